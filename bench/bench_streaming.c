@@ -0,0 +1,165 @@
+// bench-streaming: measure how converting a large buffer with cutf_s8tos32 affects another thread.
+//
+// A second thread walks a random cycle through a table which fits in the last level cache, the way a cache sensitive
+// workload would. Its rate of steps is measured alone, and while the main thread converts with cached and with
+// non-temporal stores. Both threads should run on separate cores which share the last level cache.
+
+#include <cutf.h>
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+typedef enum
+{
+    DEFAULT_INPUT_MIB = 256, // Size of the UTF-8 input, which is converted into four times as much output
+    DEFAULT_TABLE_MIB = 8,   // Size of the table walked by the co-running thread
+    ROUNDS = 3,              // Number of conversions measured for each mode
+} bench_constants_t;
+
+typedef struct
+{
+    size_t *p_table;
+    atomic_bool stop;
+    atomic_size_t steps;
+} corunner_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *const p_seed)
+{
+    // xorshift64, good enough for shuffling the table
+    *p_seed ^= *p_seed << 13;
+    *p_seed ^= *p_seed >> 7;
+    *p_seed ^= *p_seed << 17;
+    return *p_seed;
+}
+
+static int corunner_main(void *const arg)
+{
+    corunner_t *const p_corunner = arg;
+    size_t position = 0;
+    while (!atomic_load_explicit(&p_corunner->stop, memory_order_relaxed))
+    {
+        // Each step depends on the previous load, so the rate is bound by the latency of the cache
+        for (unsigned i = 0; i < 1024; ++i)
+            position = p_corunner->p_table[position];
+        atomic_fetch_add_explicit(&p_corunner->steps, 1024, memory_order_relaxed);
+    }
+    return (int)(position & 1);
+}
+
+// Measure the co-running thread's steps per second over a period, either idle or while converting in a mode.
+static double measure(corunner_t *const p_corunner, const size_t sz_in, const char8_t *const p_in,
+                      char32_t *const p_out, const int mode, double *const p_throughput)
+{
+    auto const steps_before = atomic_load(&p_corunner->steps);
+    auto const start = now();
+    if (mode < 0)
+    {
+        // Measure the co-running thread alone for about as long as a conversion
+        struct timespec const duration = {.tv_nsec = 500000000};
+        thrd_sleep(&duration, nullptr);
+    }
+    else
+    {
+        for (unsigned round = 0; round < ROUNDS; ++round)
+        {
+            size_t consumed, written;
+            cutf_state_t state = CUTF_STATE_INITIALIZER;
+            if (cutf_s8tos32_store(sz_in, p_in, sz_in, &consumed, p_out, &written, (cutf_store_mode_t)mode,
+                                   &state) != CUTF_SUCCESS)
+            {
+                fprintf(stderr, "bench-streaming: conversion failed\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    auto const elapsed = now() - start;
+    auto const steps = atomic_load(&p_corunner->steps) - steps_before;
+    if (p_throughput != nullptr)
+        *p_throughput = (double)sz_in * ROUNDS / elapsed / (1 << 20);
+    return (double)steps / elapsed;
+}
+
+int main(const int argc, char **const argv)
+{
+    auto const input_mib = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : (size_t)DEFAULT_INPUT_MIB;
+    auto const table_mib = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : (size_t)DEFAULT_TABLE_MIB;
+    if (input_mib == 0 || table_mib == 0)
+    {
+        fprintf(stderr, "usage: bench-streaming [INPUT_MIB] [TABLE_MIB]\n");
+        return EXIT_FAILURE;
+    }
+
+    // Mostly ASCII text with some multi-unit codepoints, like source code or markup
+    static constexpr char8_t sample[] = u8"<p class=\"text\">The quick brown fox — ケツを食べる 🗿</p>\n";
+    auto const sz_in = input_mib << 20;
+    char8_t *const p_in = malloc(sz_in);
+    char32_t *const p_out = malloc(sz_in * sizeof(char32_t));
+    auto const table_size = (table_mib << 20) / sizeof(size_t);
+    corunner_t corunner = {.p_table = malloc(table_size * sizeof(size_t))};
+    if (p_in == nullptr || p_out == nullptr || corunner.p_table == nullptr)
+    {
+        fprintf(stderr, "bench-streaming: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Fill the input with whole copies of the sample, padding the end with ASCII
+    size_t pos = 0;
+    for (; pos + sizeof(sample) - 1 <= sz_in; pos += sizeof(sample) - 1)
+        memcpy(p_in + pos, sample, sizeof(sample) - 1);
+    memset(p_in + pos, ' ', sz_in - pos);
+    // Touch the output so page faults are not measured
+    memset(p_out, 0, sz_in * sizeof(char32_t));
+
+    // Link the table into a single random cycle (Sattolo's algorithm)
+    for (size_t i = 0; i < table_size; ++i)
+        corunner.p_table[i] = i;
+    uint64_t seed = 0x9E3779B97F4A7C15;
+    for (size_t i = table_size - 1; i > 0; --i)
+    {
+        auto const j = (size_t)(next_random(&seed) % i);
+        auto const tmp = corunner.p_table[i];
+        corunner.p_table[i] = corunner.p_table[j];
+        corunner.p_table[j] = tmp;
+    }
+
+    thrd_t thread;
+    if (thrd_create(&thread, corunner_main, &corunner) != thrd_success)
+    {
+        fprintf(stderr, "bench-streaming: could not start the co-running thread\n");
+        return EXIT_FAILURE;
+    }
+
+    // Warm up the table and the conversion
+    measure(&corunner, sz_in, p_in, p_out, -1, nullptr);
+
+    double cached_throughput, streaming_throughput;
+    auto const idle_rate = measure(&corunner, sz_in, p_in, p_out, -1, nullptr);
+    auto const cached_rate = measure(&corunner, sz_in, p_in, p_out, CUTF_STORE_CACHED, &cached_throughput);
+    auto const streaming_rate = measure(&corunner, sz_in, p_in, p_out, CUTF_STORE_STREAMING, &streaming_throughput);
+
+    atomic_store(&corunner.stop, true);
+    thrd_join(thread, nullptr);
+
+    printf("input %zu MiB, co-running table %zu MiB\n", input_mib, table_mib);
+    printf("%-10s %16s %22s\n", "mode", "input MiB/s", "co-runner Msteps/s");
+    printf("%-10s %16s %22.1f\n", "idle", "-", idle_rate * 1e-6);
+    printf("%-10s %16.1f %22.1f\n", "cached", cached_throughput, cached_rate * 1e-6);
+    printf("%-10s %16.1f %22.1f\n", "streaming", streaming_throughput, streaming_rate * 1e-6);
+
+    free(corunner.p_table);
+    free(p_in);
+    free(p_out);
+    return EXIT_SUCCESS;
+}
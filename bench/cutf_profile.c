@@ -0,0 +1,437 @@
+// cutf-profile: measure cycles per byte of each conversion kernel, over several classes of input.
+//
+// Hardware counters for cycles, instructions, branch misses and L1 data cache misses are read with perf_event_open,
+// from which the instructions per cycle and the branch miss rate are derived. Counters which can not be opened, for
+// example because of perf_event_paranoid or inside a virtual machine, are reported as missing, while the time is always
+// given.
+
+#define _GNU_SOURCE
+
+#include <cutf.h>
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum
+{
+    DEFAULT_SIZE = 4 << 20, // Default number of UTF-8 bytes in each input
+    DEFAULT_REPEATS = 10,   // Default number of times each kernel is run over the input
+} profile_constants_t;
+
+typedef enum
+{
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_COUNT,
+} counter_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} counter_event_t;
+
+static const counter_event_t COUNTER_EVENTS[COUNTER_COUNT] = {
+    [COUNTER_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [COUNTER_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [COUNTER_BRANCH_MISSES] = {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    [COUNTER_L1D_MISSES] = {"l1d_misses", PERF_TYPE_HW_CACHE,
+                            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+typedef struct
+{
+    const char *name;
+    cutf_encoding_t from;
+    cutf_encoding_t to;
+} kernel_t;
+
+static const kernel_t KERNELS[] = {
+    {"s8tos16", CUTF_ENCODING_UTF8, CUTF_ENCODING_UTF16},   {"s8tos32", CUTF_ENCODING_UTF8, CUTF_ENCODING_UTF32},
+    {"s16tos8", CUTF_ENCODING_UTF16, CUTF_ENCODING_UTF8},   {"s16tos32", CUTF_ENCODING_UTF16, CUTF_ENCODING_UTF32},
+    {"s32tos8", CUTF_ENCODING_UTF32, CUTF_ENCODING_UTF8},   {"s32tos16", CUTF_ENCODING_UTF32, CUTF_ENCODING_UTF16},
+};
+
+typedef enum
+{
+    KERNEL_COUNT = sizeof(KERNELS) / sizeof(*KERNELS),
+} kernel_count_t;
+
+// Input classes, each drawing codepoints from ranges of a typical kind of text
+typedef struct
+{
+    char32_t first;
+    char32_t last;
+    unsigned weight;
+} codepoint_range_t;
+
+typedef struct
+{
+    const char *name;
+    codepoint_range_t ranges[3];
+} input_class_t;
+
+static const input_class_t INPUT_CLASSES[] = {
+    // Source code, markup and English text
+    {"ascii", {{0x20, 0x7E, 60}, {U'\n', U'\n', 1}}},
+    // Western European languages
+    {"latin", {{0x20, 0x7E, 8}, {0xC0, 0xFF, 2}}},
+    // Chinese and Japanese
+    {"cjk", {{0x4E00, 0x9FFF, 8}, {0x3040, 0x30FF, 4}, {0x20, 0x7E, 1}}},
+    // Codepoints outside the BMP
+    {"emoji", {{0x1F600, 0x1F64F, 4}, {0x20, 0x20, 1}}},
+    // Every length of UTF-8 sequence
+    {"mixed", {{0x20, 0x7E, 4}, {0x400, 0x4FF, 2}, {0x1F300, 0x1F5FF, 1}}},
+};
+
+typedef enum
+{
+    INPUT_CLASS_COUNT = sizeof(INPUT_CLASSES) / sizeof(*INPUT_CLASSES),
+} input_class_count_t;
+
+typedef struct
+{
+    size_t sz[3]; // Number of units in each encoding, indexed by cutf_encoding_t
+    void *p[3];   // String in each encoding
+} input_t;
+
+typedef struct
+{
+    double seconds;
+    bool has[COUNTER_COUNT];
+    uint64_t values[COUNTER_COUNT];
+} measurement_t;
+
+static int counter_fds[COUNTER_COUNT];
+
+static uint64_t next_random(uint64_t *const p_seed)
+{
+    // xorshift64, good enough for picking codepoints
+    *p_seed ^= *p_seed << 13;
+    *p_seed ^= *p_seed >> 7;
+    *p_seed ^= *p_seed << 17;
+    return *p_seed;
+}
+
+static void open_counters(void)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        struct perf_event_attr attr = {
+            .type = COUNTER_EVENTS[i].type,
+            .size = sizeof(attr),
+            .config = COUNTER_EVENTS[i].config,
+            .disabled = 1,
+            .exclude_kernel = 1,
+            .exclude_hv = 1,
+        };
+        counter_fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counter_fds[i] < 0)
+            fprintf(stderr, "cutf-profile: counter %s is not available\n", COUNTER_EVENTS[i].name);
+    }
+}
+
+static void close_counters(void)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        if (counter_fds[i] >= 0)
+            close(counter_fds[i]);
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Generate the input of a class, with about the given number of bytes when encoded as UTF-8.
+static bool generate_input(const input_class_t *const p_class, const size_t sz_utf8, input_t *const p_input)
+{
+    unsigned total_weight = 0;
+    for (size_t r = 0; r < 3; ++r)
+        total_weight += p_class->ranges[r].weight;
+
+    // Every codepoint takes at least one byte, so this is enough codepoints
+    char32_t *const p32 = malloc(sz_utf8 * sizeof(char32_t));
+    if (p32 == nullptr)
+        return false;
+    uint64_t seed = 0x9E3779B97F4A7C15;
+    size_t count = 0, bytes = 0;
+    while (bytes < sz_utf8)
+    {
+        auto pick = (unsigned)(next_random(&seed) % total_weight);
+        size_t r = 0;
+        while (pick >= p_class->ranges[r].weight)
+            pick -= p_class->ranges[r++].weight;
+        auto const range = p_class->ranges[r];
+        auto const c = range.first + (char32_t)(next_random(&seed) % (range.last - range.first + 1));
+        auto const sz_c = (size_t)(1 + (c >= 0x80) + (c >= 0x800) + (c >= 0x10000));
+        if (bytes + sz_c > sz_utf8)
+            break;
+        p32[count++] = c;
+        bytes += sz_c;
+    }
+
+    *p_input = (input_t){.sz = {[CUTF_ENCODING_UTF32] = count}, .p = {[CUTF_ENCODING_UTF32] = p32}};
+    static const cutf_encoding_t targets[] = {CUTF_ENCODING_UTF8, CUTF_ENCODING_UTF16};
+    for (size_t t = 0; t < sizeof(targets) / sizeof(*targets); ++t)
+    {
+        auto const to = targets[t];
+        size_t valid, sz_out, consumed;
+        cutf_count_converted(CUTF_ENCODING_UTF32, count, p32, to, &valid, &sz_out);
+        p_input->p[to] = malloc(sz_out * cutf_encoding_unit_size(to) + 1);
+        if (p_input->p[to] == nullptr)
+            return false;
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        if (cutf_convert(CUTF_ENCODING_UTF32, count, p32, to, sz_out, &consumed, p_input->p[to], &p_input->sz[to],
+                         &state) != CUTF_SUCCESS)
+            return false;
+    }
+    return true;
+}
+
+static void free_input(input_t *const p_input)
+{
+    for (size_t i = 0; i < 3; ++i)
+        free(p_input->p[i]);
+}
+
+// Run a kernel over the input a number of times, measuring all of the runs together.
+static bool measure(const kernel_t *const p_kernel, const input_t *const p_input, void *const p_out,
+                    const unsigned repeats, measurement_t *const p_measurement)
+{
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        if (counter_fds[i] >= 0)
+            ioctl(counter_fds[i], PERF_EVENT_IOC_RESET, 0);
+    }
+
+    auto const start = now();
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        if (counter_fds[i] >= 0)
+            ioctl(counter_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    bool success = true;
+    for (unsigned repeat = 0; repeat < repeats; ++repeat)
+    {
+        size_t consumed, written;
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        // The output holds as many units as the largest encoding of the input
+        success &= cutf_convert(p_kernel->from, p_input->sz[p_kernel->from], p_input->p[p_kernel->from], p_kernel->to,
+                                p_input->sz[CUTF_ENCODING_UTF8], &consumed, p_out, &written,
+                                &state) == CUTF_SUCCESS;
+    }
+
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        if (counter_fds[i] >= 0)
+            ioctl(counter_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    p_measurement->seconds = now() - start;
+
+    for (size_t i = 0; i < COUNTER_COUNT; ++i)
+    {
+        p_measurement->has[i] = counter_fds[i] >= 0 &&
+                                read(counter_fds[i], &p_measurement->values[i], sizeof(uint64_t)) == sizeof(uint64_t);
+    }
+    return success;
+}
+
+// Print a value derived from counters, or a placeholder if one of them is missing.
+static void print_ratio(const bool json, const char *const name, const bool has, const double value)
+{
+    if (json)
+    {
+        if (has)
+            printf(", \"%s\": %.4f", name, value);
+        else
+            printf(", \"%s\": null", name);
+    }
+    else
+    {
+        if (has)
+            printf(" %12.3f", value);
+        else
+            printf(" %12s", "-");
+    }
+}
+
+static void print_measurement(const bool json, const bool first, const kernel_t *const p_kernel,
+                              const input_class_t *const p_class, const input_t *const p_input, const unsigned repeats,
+                              const measurement_t *const p_measurement)
+{
+    auto const bytes =
+        (double)p_input->sz[p_kernel->from] * (double)cutf_encoding_unit_size(p_kernel->from) * (double)repeats;
+    auto const has = p_measurement->has;
+    auto const values = p_measurement->values;
+
+    if (json)
+        printf("%s\n  {\"kernel\": \"%s\", \"input\": \"%s\", \"bytes\": %.0f, \"ns_per_byte\": %.4f", first ? "" : ",",
+               p_kernel->name, p_class->name, bytes, p_measurement->seconds * 1e9 / bytes);
+    else
+        printf("%-10s %-8s %12.3f", p_kernel->name, p_class->name, p_measurement->seconds * 1e9 / bytes);
+
+    print_ratio(json, "cycles_per_byte", has[COUNTER_CYCLES], (double)values[COUNTER_CYCLES] / bytes);
+    print_ratio(json, "ipc", has[COUNTER_CYCLES] && has[COUNTER_INSTRUCTIONS] && values[COUNTER_CYCLES] != 0,
+                (double)values[COUNTER_INSTRUCTIONS] / (double)values[COUNTER_CYCLES]);
+    print_ratio(json, "branch_misses_per_kib", has[COUNTER_BRANCH_MISSES],
+                (double)values[COUNTER_BRANCH_MISSES] * 1024 / bytes);
+    print_ratio(json, "branch_misses_per_kilo_instruction",
+                has[COUNTER_BRANCH_MISSES] && has[COUNTER_INSTRUCTIONS] && values[COUNTER_INSTRUCTIONS] != 0,
+                (double)values[COUNTER_BRANCH_MISSES] * 1000 / (double)values[COUNTER_INSTRUCTIONS]);
+    print_ratio(json, "l1d_misses_per_kib", has[COUNTER_L1D_MISSES], (double)values[COUNTER_L1D_MISSES] * 1024 / bytes);
+
+    if (json)
+        printf("}");
+    else
+        printf("\n");
+}
+
+static int print_usage(void)
+{
+    fprintf(stderr, "usage: cutf-profile [-s BYTES] [-r REPEATS] [-k KERNEL] [-i INPUT] [-j]\n"
+                    "\n"
+                    "  -s BYTES    size of each input when encoded as UTF-8, 4 MiB by default\n"
+                    "  -r REPEATS  number of times each kernel is run over the input, 10 by default\n"
+                    "  -k KERNEL   only profile this kernel, which can be given more than once\n"
+                    "  -i INPUT    only profile this class of input, which can be given more than once\n"
+                    "  -j          print the results as JSON\n"
+                    "\n"
+                    "Kernels are s8tos16, s8tos32, s16tos8, s16tos32, s32tos8 and s32tos16.\n"
+                    "Inputs are ascii, latin, cjk, emoji and mixed.\n");
+    return EXIT_FAILURE;
+}
+
+// Select an item by name, returning false if there is no such item.
+static bool select_by_name(const char *const name, const size_t count, const char *(*const p_name)(size_t),
+                           bool p_selected[const count])
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (strcmp(name, p_name(i)) == 0)
+        {
+            p_selected[i] = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char *kernel_name(const size_t i)
+{
+    return KERNELS[i].name;
+}
+
+static const char *input_class_name(const size_t i)
+{
+    return INPUT_CLASSES[i].name;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = DEFAULT_SIZE;
+    unsigned repeats = DEFAULT_REPEATS;
+    bool json = false, any_kernel = false, any_class = false;
+    bool kernels[KERNEL_COUNT] = {0}, classes[INPUT_CLASS_COUNT] = {0};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            size = (size_t)strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeats = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+        {
+            if (!select_by_name(argv[++i], KERNEL_COUNT, kernel_name, kernels))
+                return print_usage();
+            any_kernel = true;
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            if (!select_by_name(argv[++i], INPUT_CLASS_COUNT, input_class_name, classes))
+                return print_usage();
+            any_class = true;
+        }
+        else if (strcmp(argv[i], "-j") == 0)
+            json = true;
+        else
+            return print_usage();
+    }
+    if (size == 0 || repeats == 0)
+        return print_usage();
+    for (size_t i = 0; i < KERNEL_COUNT; ++i)
+        kernels[i] |= !any_kernel;
+    for (size_t i = 0; i < INPUT_CLASS_COUNT; ++i)
+        classes[i] |= !any_class;
+
+    // Each encoding has at most as many units as UTF-8, so this fits any output
+    void *const p_out = malloc(size * sizeof(char32_t));
+    if (p_out == nullptr)
+    {
+        fprintf(stderr, "cutf-profile: out of memory\n");
+        return EXIT_FAILURE;
+    }
+    open_counters();
+
+    if (json)
+        printf("[");
+    else
+        printf("%-10s %-8s %12s %12s %12s %12s %12s %12s\n", "kernel", "input", "ns/byte", "cycles/byte", "ipc",
+               "bmiss/KiB", "bmiss/kinstr", "l1dmiss/KiB");
+
+    bool first = true;
+    int exit_code = EXIT_SUCCESS;
+    for (size_t c = 0; c < INPUT_CLASS_COUNT; ++c)
+    {
+        if (!classes[c])
+            continue;
+
+        input_t input = {0};
+        if (!generate_input(&INPUT_CLASSES[c], size, &input))
+        {
+            fprintf(stderr, "cutf-profile: could not generate the %s input\n", INPUT_CLASSES[c].name);
+            free_input(&input);
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+
+        for (size_t k = 0; k < KERNEL_COUNT; ++k)
+        {
+            if (!kernels[k])
+                continue;
+
+            // Warm up the caches and branch predictors first
+            measurement_t measurement;
+            measure(&KERNELS[k], &input, p_out, 1, &measurement);
+            if (!measure(&KERNELS[k], &input, p_out, repeats, &measurement))
+            {
+                fprintf(stderr, "cutf-profile: %s failed on the %s input\n", KERNELS[k].name, INPUT_CLASSES[c].name);
+                exit_code = EXIT_FAILURE;
+            }
+            print_measurement(json, first, &KERNELS[k], &INPUT_CLASSES[c], &input, repeats, &measurement);
+            first = false;
+        }
+        free_input(&input);
+    }
+    if (json)
+        printf("\n]\n");
+
+    close_counters();
+    free(p_out);
+    return exit_code;
+}
@@ -3,6 +3,7 @@
 #include <uchar.h>
 
 #include <stddef.h>
+#include <stdint.h>
 // Include for bool if we are not on C23
 #if __STDC_VERSION__ < 202311L
 #    include <stdbool.h>
@@ -14,6 +15,7 @@ enum cutf_result_t
     CUTF_INCOMPLETE_INPUT, // Input string did not contain enough characters to complete conversion of the last output
     CUTF_INSUFFICIENT_BUFFER, // Output buffer was too small to fit all output characters
     CUTF_INVALID_INPUT,       // Input string was not in the valid encoding
+    CUTF_FILE_ERROR,          // File could not be read or written
 };
 typedef enum cutf_result_t cutf_result_t;
 
@@ -39,9 +41,71 @@ bool cutf_state_is_clean(cutf_state_t state);
 
 static const cutf_state_t CUTF_STATE_INITIALIZER = {.state_type = CUTF_STATE_CLEAR};
 
+enum cutf_encoding_t
+{
+    CUTF_ENCODING_UTF8,  // UTF-8, using char8_t units
+    CUTF_ENCODING_UTF16, // UTF-16 in native endianness, using char16_t units
+    CUTF_ENCODING_UTF32, // UTF-32 in native endianness, using char32_t units
+};
+typedef enum cutf_encoding_t cutf_encoding_t;
+
+struct cutf_stats_t
+{
+    size_t codepoints;      // Number of codepoints in the input
+    size_t lines;           // Number of line terminators, counting carriage return followed by line feed only once
+    char32_t max_codepoint; // Highest codepoint in the input
+    char32_t last;          // Last codepoint in the input, used to pair carriage returns across calls
+    bool is_ascii;          // Whether all codepoints are ASCII
+};
+typedef struct cutf_stats_t cutf_stats_t;
+
+static const cutf_stats_t CUTF_STATS_INITIALIZER = {.is_ascii = true};
+
+struct cutf_counters_t
+{
+    size_t calls;               // Number of calls to the conversion functions
+    size_t bytes_in;            // Bytes of input consumed
+    size_t bytes_out;           // Bytes of output written
+    size_t fast_blocks;         // Blocks of units converted at once by the fast paths
+    size_t slow_codepoints;     // Codepoints converted one at a time by the state machine
+    size_t restarts;            // Calls which started with a codepoint carried in the state from the previous call
+    size_t incomplete_input;    // Calls which returned CUTF_INCOMPLETE_INPUT
+    size_t insufficient_buffer; // Calls which returned CUTF_INSUFFICIENT_BUFFER
+    size_t invalid_input;       // Calls which returned CUTF_INVALID_INPUT
+};
+typedef struct cutf_counters_t cutf_counters_t;
+
+/**
+ * Get the counters of the conversion functions called by the current thread. Counters are only kept when the library
+ * is built with the CUTF_ENABLE_STATS option, otherwise they are always zero, and counting costs nothing. Bytes are not
+ * counted for calls which return CUTF_INVALID_INPUT.
+ *
+ * @return Counters of the calls made by the current thread since it started, or since ``cutf_stats_reset``.
+ */
+cutf_counters_t cutf_stats_snapshot(void);
+
+/**
+ * Reset the counters of the conversion functions called by the current thread to zero.
+ */
+void cutf_stats_reset(void);
+
+enum cutf_store_mode_t
+{
+    CUTF_STORE_AUTO,      // Use non-temporal stores if the output is larger than CUTF_STREAMING_THRESHOLD bytes
+    CUTF_STORE_CACHED,    // Write the output through the cache, like any other store
+    CUTF_STORE_STREAMING, // Write the output with non-temporal stores, which bypass the cache where supported
+};
+typedef enum cutf_store_mode_t cutf_store_mode_t;
+
+// Number of output bytes above which CUTF_STORE_AUTO switches to non-temporal stores. Output of this size would not fit
+// in the last level cache of most machines, so writing it through the cache only evicts data used by other threads.
+static const size_t CUTF_STREAMING_THRESHOLD = 32u << 20;
+
 /**
  * Convert a UTF-8 string to a UTF-32 string.
  *
+ * Output larger than CUTF_STREAMING_THRESHOLD bytes is written with non-temporal stores, see cutf_s8tos32_store.
+ *
  * @param sz_in Number of UTF-8 units to convert.
  * @param p_in Input UTF-8 string to convert.
  * @param sz_out Size of the output string.
@@ -54,6 +118,47 @@ static const cutf_state_t CUTF_STATE_INITIALIZER = {.state_type = CUTF_STATE_CLE
 cutf_result_t cutf_s8tos32(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
                            char32_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
 
+/**
+ * Convert a UTF-8 string to a UTF-32 string, choosing how the output is stored.
+ *
+ * With non-temporal stores, the output is written to memory without being kept in the cache, and the input is
+ * prefetched ahead of the conversion. This is slower for output which is read again soon, but conversion of very large
+ * buffers no longer evicts the data of other threads from the shared cache. On targets without non-temporal stores,
+ * CUTF_STORE_STREAMING only prefetches the input. The result is identical for all modes.
+ *
+ * @param sz_in Number of UTF-8 units to convert.
+ * @param p_in Input UTF-8 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units converted.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-32 units written.
+ * @param mode How the output is stored.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s8tos32_store(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                 char32_t p_out[sz_out], size_t *p_written, cutf_store_mode_t mode,
+                                 cutf_state_t *state);
+
+/**
+ * Convert a UTF-8 string to a UTF-32 string, like ``cutf_s8tos32``, while collecting statistics of the input. This
+ * saves going over the input again to count its codepoints and lines. The statistics are added to the ones given, so
+ * they can be collected over several calls, starting from CUTF_STATS_INITIALIZER. A codepoint split between calls is
+ * counted by the call which completes it.
+ *
+ * @param sz_in Number of UTF-8 units to convert.
+ * @param p_in Input UTF-8 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units converted.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-32 units written.
+ * @param stats Pointer to the statistics, which are updated with the codepoints consumed.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s8tos32_stats(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                 char32_t p_out[sz_out], size_t *p_written, cutf_stats_t *stats, cutf_state_t *state);
+
 /**
  * Convert a UTF-32 string to a UTF-8 string.
  *
@@ -99,6 +204,77 @@ cutf_result_t cutf_is_utf8_valid(size_t sz_in, const char8_t p_in[static sz_in],
  */
 cutf_result_t cutf_utf8_next_codepoint(size_t sz_in, const char8_t p_in[const static sz_in], size_t *p_consumed);
 
+/**
+ * Find the length of the last codepoint in the input, which allows moving backwards through a UTF-8 string.
+ *
+ * @param sz_in Number of UTF-8 units in the input, which is the position to move back from.
+ * @param p_in Input string to move back along.
+ * @param p_consumed Pointer which receives the number of UTF-8 units to move back to the previous codepoint.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input is empty or the last codepoint is missing
+ *         units, or CUTF_INVALID_INPUT if the input is not UTF-8 encoded.
+ */
+cutf_result_t cutf_utf8_prev_codepoint(size_t sz_in, const char8_t p_in[const static sz_in], size_t *p_consumed);
+
+/**
+ * Move an offset back to the nearest codepoint boundary, such that cutting the string there does not split a
+ * codepoint. Since codepoints are at most four units long, this only looks at up to three units before the offset.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @param offset Offset in UTF-8 units to snap to a boundary.
+ * @return Largest codepoint boundary which is not greater than the offset. Offsets past the end snap to the end of the
+ *         input, and offsets where the input is not correctly encoded are returned unchanged.
+ */
+size_t cutf_utf8_snap_boundary(size_t sz_in, const char8_t p_in[const static sz_in], size_t offset);
+
+/**
+ * Find the start of the codepoint which is a number of codepoints before the end of the input. Blocks of units which
+ * do not contain the codepoint are skipped without examining each of them.
+ *
+ * @param sz_in Number of UTF-8 units in the input, which is the position to move back from.
+ * @param p_in Input UTF-8 string, assumed to be correctly encoded.
+ * @param count Number of codepoints to move back by.
+ * @param p_offset Pointer which receives the offset of the codepoint in UTF-8 units.
+ * @return CUTF_SUCCESS if successful, or CUTF_INCOMPLETE_INPUT if the input has fewer codepoints than requested.
+ */
+cutf_result_t cutf_utf8_seek_back(size_t sz_in, const char8_t p_in[const static sz_in], size_t count, size_t *p_offset);
+
+/**
+ * Find the length of the last codepoint in the input, which allows moving backwards through a UTF-16 string.
+ *
+ * @param sz_in Number of UTF-16 units in the input, which is the position to move back from.
+ * @param p_in Input string to move back along.
+ * @param p_consumed Pointer which receives the number of UTF-16 units to move back to the previous codepoint.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input is empty or the last codepoint is missing
+ *         a surrogate, or CUTF_INVALID_INPUT if the input is not UTF-16 encoded.
+ */
+cutf_result_t cutf_utf16_prev_codepoint(size_t sz_in, const char16_t p_in[const static sz_in], size_t *p_consumed);
+
+/**
+ * Move an offset back to the nearest codepoint boundary, such that cutting the string there does not split a
+ * surrogate pair.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string.
+ * @param offset Offset in UTF-16 units to snap to a boundary.
+ * @return Largest codepoint boundary which is not greater than the offset. Offsets past the end snap to the end of the
+ *         input.
+ */
+size_t cutf_utf16_snap_boundary(size_t sz_in, const char16_t p_in[const static sz_in], size_t offset);
+
+/**
+ * Find the start of the codepoint which is a number of codepoints before the end of the input. Blocks of units which
+ * do not contain the codepoint are skipped without examining each of them.
+ *
+ * @param sz_in Number of UTF-16 units in the input, which is the position to move back from.
+ * @param p_in Input UTF-16 string, assumed to be correctly encoded.
+ * @param count Number of codepoints to move back by.
+ * @param p_offset Pointer which receives the offset of the codepoint in UTF-16 units.
+ * @return CUTF_SUCCESS if successful, or CUTF_INCOMPLETE_INPUT if the input has fewer codepoints than requested.
+ */
+cutf_result_t cutf_utf16_seek_back(size_t sz_in, const char16_t p_in[const static sz_in], size_t count,
+                                   size_t *p_offset);
+
 /**
  * Count the number of UTF-32 characters required to represent all characters in the input.
  *
@@ -110,6 +286,78 @@ cutf_result_t cutf_utf8_next_codepoint(size_t sz_in, const char8_t p_in[const st
  */
 cutf_result_t cutf_count_s8asc32(size_t sz_in, const char8_t p_in[static sz_in], size_t *valid_count, size_t *p_count);
 
+/**
+ * Count the number of UTF-16 units required to represent all characters in the input.
+ *
+ * @param sz_in Length of the UTF-8 string.
+ * @param p_in Pointer to the UTF-8 string.
+ * @param valid_count Number of UTF-8 units that can be converted into complete UTF-16 codepoints.
+ * @param p_count Pointer that receives the number of UTF-16 units needed to represent the input string.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_is_utf8_valid``.
+ */
+cutf_result_t cutf_count_s8asc16(size_t sz_in, const char8_t p_in[static sz_in], size_t *valid_count, size_t *p_count);
+
+/**
+ * Convert an offset in UTF-16 units into an offset in UTF-8 units of the same UTF-8 string. This is useful when
+ * positions are given as UTF-16 offsets (such as by language server clients), but the text is stored as UTF-8.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string, assumed to be correctly encoded.
+ * @param offset16 Offset in UTF-16 units to convert.
+ * @param p_offset8 Pointer which receives the offset in UTF-8 units.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the offset is past the end of the input, or
+ *         CUTF_INVALID_INPUT if the offset is in the middle of a surrogate pair.
+ */
+cutf_result_t cutf_utf16_offset_to_utf8(size_t sz_in, const char8_t p_in[static sz_in], size_t offset16,
+                                        size_t *p_offset8);
+
+/**
+ * Convert an offset in UTF-8 units into an offset in UTF-16 units of the same UTF-8 string.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string, assumed to be correctly encoded.
+ * @param offset8 Offset in UTF-8 units to convert.
+ * @param p_offset16 Pointer which receives the offset in UTF-16 units.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the offset is past the end of the input, or
+ *         CUTF_INVALID_INPUT if the offset is in the middle of a codepoint.
+ */
+cutf_result_t cutf_utf8_offset_to_utf16(size_t sz_in, const char8_t p_in[static sz_in], size_t offset8,
+                                        size_t *p_offset16);
+
+/**
+ * Convert multiple offsets in UTF-16 units into offsets in UTF-8 units of the same UTF-8 string. The input is only
+ * traversed once, so the offsets must be sorted in ascending order.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string, assumed to be correctly encoded.
+ * @param count Number of offsets to convert.
+ * @param p_offsets16 Sorted offsets in UTF-16 units to convert.
+ * @param p_offsets8 Array which receives the offsets in UTF-8 units.
+ * @param p_converted Pointer which receives the number of offsets converted.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if an offset is past the end of the input, or
+ *         CUTF_INVALID_INPUT if an offset is in the middle of a surrogate pair or offsets are not sorted.
+ */
+cutf_result_t cutf_utf16_offsets_to_utf8(size_t sz_in, const char8_t p_in[static sz_in], size_t count,
+                                         const size_t p_offsets16[static count], size_t p_offsets8[count],
+                                         size_t *p_converted);
+
+/**
+ * Convert multiple offsets in UTF-8 units into offsets in UTF-16 units of the same UTF-8 string. The input is only
+ * traversed once, so the offsets must be sorted in ascending order.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string, assumed to be correctly encoded.
+ * @param count Number of offsets to convert.
+ * @param p_offsets8 Sorted offsets in UTF-8 units to convert.
+ * @param p_offsets16 Array which receives the offsets in UTF-16 units.
+ * @param p_converted Pointer which receives the number of offsets converted.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if an offset is past the end of the input, or
+ *         CUTF_INVALID_INPUT if an offset is in the middle of a codepoint or offsets are not sorted.
+ */
+cutf_result_t cutf_utf8_offsets_to_utf16(size_t sz_in, const char8_t p_in[static sz_in], size_t count,
+                                         const size_t p_offsets8[static count], size_t p_offsets16[count],
+                                         size_t *p_converted);
+
 /**
  * Convert a UTF-16 string to a UTF-32 string.
  *
@@ -140,6 +388,74 @@ cutf_result_t cutf_s16tos32(size_t sz_in, const char16_t p_in[const static sz_in
 cutf_result_t cutf_s32tos16(size_t sz_in, const char32_t p_in[const static sz_in], size_t sz_out, size_t *p_consumed,
                             char16_t p_out[const sz_out], size_t *p_written, cutf_state_t *state);
 
+/**
+ * Check if the input is a correctly encoded UTF-16 string, meaning that all surrogates are correctly paired.
+ *
+ * @param sz_in Number of UTF-16 units in the input to check.
+ * @param p_in Input string to check if it is a valid UTF-16 encoded string.
+ * @param valid_count Pointer that receives the number of UTF-16 units from the start of the input which are valid.
+ * @return CUTF_SUCCESS if the input is a valid UTF-16 string. When the string is valid, but the last codepoint is
+ *         missing its low surrogate, CUTF_INCOMPLETE_INPUT is returned. If the input is not UTF-16 encoded,
+ *         CUTF_INVALID_INPUT is returned.
+ */
+cutf_result_t cutf_is_utf16_valid(size_t sz_in, const char16_t p_in[static sz_in], size_t *valid_count);
+
+/**
+ * Count the number of UTF-32 characters required to represent all characters in the input.
+ *
+ * @param sz_in Length of the UTF-16 string.
+ * @param p_in Pointer to the UTF-16 string.
+ * @param valid_count Number of UTF-16 units that can be converted into complete UTF-32 codepoints.
+ * @param p_count Pointer that receives the number of UTF-32 units needed to represent the input string.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_is_utf16_valid``.
+ */
+cutf_result_t cutf_count_s16asc32(size_t sz_in, const char16_t p_in[static sz_in], size_t *valid_count,
+                                  size_t *p_count);
+
+/**
+ * Check if the input is a correctly encoded UTF-32 string, meaning it contains only Unicode scalar values.
+ *
+ * @param sz_in Number of UTF-32 units in the input to check.
+ * @param p_in Input string to check if it is a valid UTF-32 encoded string.
+ * @param valid_count Pointer that receives the number of UTF-32 units from the start of the input which are valid.
+ * @return CUTF_SUCCESS if the input is a valid UTF-32 string, otherwise CUTF_INVALID_INPUT.
+ */
+cutf_result_t cutf_is_utf32_valid(size_t sz_in, const char32_t p_in[static sz_in], size_t *valid_count);
+
+/**
+ * Count the number of UTF-8 units required to represent all characters in the input.
+ *
+ * @param sz_in Length of the UTF-16 string.
+ * @param p_in Pointer to the UTF-16 string.
+ * @param valid_count Number of UTF-16 units that can be converted into complete UTF-8 codepoints.
+ * @param p_count Pointer that receives the number of UTF-8 units needed to represent the input string.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_is_utf16_valid``.
+ */
+cutf_result_t cutf_count_s16asc8(size_t sz_in, const char16_t p_in[static sz_in], size_t *valid_count, size_t *p_count);
+
+/**
+ * Count the number of UTF-8 units required to represent all characters in the input.
+ *
+ * @param sz_in Length of the UTF-32 string.
+ * @param p_in Pointer to the UTF-32 string.
+ * @param valid_count Number of UTF-32 units that can be converted into UTF-8.
+ * @param p_count Pointer that receives the number of UTF-8 units needed to represent the input string.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_is_utf32_valid``.
+ */
+cutf_result_t cutf_count_s32asc8(size_t sz_in, const char32_t p_in[static sz_in], size_t *valid_count, size_t *p_count);
+
+/**
+ * Count the number of UTF-16 units required to represent all characters in the input.
+ *
+ * @param sz_in Length of the UTF-32 string.
+ * @param p_in Pointer to the UTF-32 string.
+ * @param valid_count Number of UTF-32 units that can be converted into UTF-16.
+ * @param p_count Pointer that receives the number of UTF-16 units needed to represent the input string.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_is_utf32_valid``.
+ */
+cutf_result_t cutf_count_s32asc16(size_t sz_in, const char32_t p_in[static sz_in], size_t *valid_count,
+                                  size_t *p_count);
+
 typedef enum
 {
     CUTF_ENDIANNESS_INVALID = -1,
@@ -189,6 +505,34 @@ utf_endianness_t cutf_utf32_bom_endianness(char32_t bom);
  */
 void cutf_utf32_swap_endianness(size_t sz_out, char32_t p_out[sz_out], const char32_t p_in[static sz_out]);
 
+struct cutf_encoding_guess_t
+{
+    cutf_encoding_t encoding;    // Encoding of the units
+    utf_endianness_t endianness; // Byte order of the units relative to the machine
+    size_t bom_length;           // Number of bytes of the byte-order mark at the start, zero if there is none
+    unsigned confidence;         // Confidence in the guess, from 1 to 100
+};
+typedef struct cutf_encoding_guess_t cutf_encoding_guess_t;
+
+enum cutf_detect_limits_t
+{
+    CUTF_MAX_ENCODING_GUESSES = 5,      // Most guesses made, one for UTF-8 and each byte order of UTF-16 and UTF-32
+    CUTF_DETECT_SAMPLE_SIZE = 64 << 10, // Number of bytes checked at the start of input without a byte-order mark
+};
+
+/**
+ * Guess the encoding of bytes with no declared encoding. When they start with a byte-order mark, the encoding it marks
+ * is the only guess. Otherwise, the start of the input is checked to be valid in each encoding, and the pattern of zero
+ * bytes, which are common in UTF-16 and UTF-32 but very rare in UTF-8 text, is used to rank the encodings.
+ *
+ * @param sz_in Number of bytes in the input.
+ * @param p_in Input bytes.
+ * @param sz_out Number of guesses the output array can hold.
+ * @param p_out Array which receives the guesses, ranked from the most to the least likely.
+ * @return Number of guesses written, which is zero if the input is not text in any of the encodings.
+ */
+size_t cutf_detect_encoding(size_t sz_in, const void *p_in, size_t sz_out, cutf_encoding_guess_t p_out[sz_out]);
+
 /**
  * Convert a UTF-8 string to a UTF-16 string.
  *
@@ -204,6 +548,23 @@ void cutf_utf32_swap_endianness(size_t sz_out, char32_t p_out[sz_out], const cha
 cutf_result_t cutf_s8tos16(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
                            char16_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
 
+/**
+ * Convert a UTF-8 string to a UTF-16 string, like ``cutf_s8tos16``, while collecting statistics of the input in the
+ * same way as ``cutf_s8tos32_stats``.
+ *
+ * @param sz_in Number of UTF-8 units to convert.
+ * @param p_in Input UTF-8 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units converted.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-16 units written.
+ * @param stats Pointer to the statistics, which are updated with the codepoints consumed.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s8tos16_stats(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                 char16_t p_out[sz_out], size_t *p_written, cutf_stats_t *stats, cutf_state_t *state);
+
 /**
  * Convert a UTF-16 string to a UTF-8 string.
  *
@@ -219,6 +580,374 @@ cutf_result_t cutf_s8tos16(size_t sz_in, const char8_t p_in[static sz_in], size_
 cutf_result_t cutf_s16tos8(size_t sz_in, const char16_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
                            char8_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
 
+/**
+ * Determine the size of a single unit of an encoding.
+ *
+ * @param encoding Encoding to get the unit size of.
+ * @return Number of bytes in each unit of the encoding, or zero if the encoding is not valid.
+ */
+size_t cutf_encoding_unit_size(cutf_encoding_t encoding);
+
+/**
+ * Convert a string between any two encodings, using the matching conversion function. When both encodings are the
+ * same, the units are checked and copied, and a codepoint split between calls is kept in the state like for the
+ * conversions. The number of units consumed and written is not set when CUTF_INVALID_INPUT is returned.
+ *
+ * @param from Encoding of the input.
+ * @param sz_in Number of units in the input.
+ * @param p_in Input string to convert.
+ * @param to Encoding of the output.
+ * @param sz_out Number of units which fit into the output.
+ * @param p_consumed Pointer which receives the number of input units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of output units written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_convert(cutf_encoding_t from, size_t sz_in, const void *p_in, cutf_encoding_t to, size_t sz_out,
+                           size_t *p_consumed, void *p_out, size_t *p_written, cutf_state_t *state);
+
+/**
+ * Count the number of units needed to convert a string between any two encodings, which also checks the input is
+ * correctly encoded.
+ *
+ * @param from Encoding of the input.
+ * @param sz_in Number of units in the input.
+ * @param p_in Input string to count.
+ * @param to Encoding of the output.
+ * @param valid_count Pointer which receives the number of input units that can be converted.
+ * @param p_count Pointer which receives the number of output units needed.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for the matching ``cutf_is_*_valid``.
+ */
+cutf_result_t cutf_count_converted(cutf_encoding_t from, size_t sz_in, const void *p_in, cutf_encoding_t to,
+                                   size_t *valid_count, size_t *p_count);
+
+/**
+ * Convert a UTF-32 string to UTF-16 in place. The UTF-16 output is written from the start of the buffer, which is safe
+ * because no codepoint takes more bytes in UTF-16 than in UTF-32, so the output never overtakes the input still to be
+ * read. On error, the input from ``*p_consumed`` onwards is left unchanged, after the ``*p_written`` converted units.
+ *
+ * @param sz_in Number of UTF-32 units in the buffer.
+ * @param p_buffer Buffer which holds the UTF-32 input, and receives the UTF-16 output.
+ * @param p_consumed Pointer which receives the number of UTF-32 units converted.
+ * @param p_written Pointer which receives the number of UTF-16 units written.
+ * @return CUTF_SUCCESS if successful, or CUTF_INVALID_INPUT if the input contains a value which is not a codepoint.
+ */
+cutf_result_t cutf_s32tos16_inplace(size_t sz_in, void *p_buffer, size_t *p_consumed, size_t *p_written);
+
+/**
+ * Convert a UTF-32 string to UTF-8 in place, like ``cutf_s32tos16_inplace``.
+ *
+ * @param sz_in Number of UTF-32 units in the buffer.
+ * @param p_buffer Buffer which holds the UTF-32 input, and receives the UTF-8 output.
+ * @param p_consumed Pointer which receives the number of UTF-32 units converted.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @return CUTF_SUCCESS if successful, or CUTF_INVALID_INPUT if the input contains a value which is not a codepoint.
+ */
+cutf_result_t cutf_s32tos8_inplace(size_t sz_in, void *p_buffer, size_t *p_consumed, size_t *p_written);
+
+/**
+ * Find how far the UTF-8 output of a UTF-16 string gets ahead of the input, when both are read and written from the
+ * start. Codepoints from U+0800 to U+FFFF take three bytes in UTF-8 but only two in UTF-16, so the output may overtake
+ * the input. The string can be converted in place with ``cutf_s16tos8_inplace`` when it starts at least this many bytes
+ * into the buffer, which then needs to be the size of the input plus this many bytes.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to check.
+ * @param p_headroom Pointer which receives the number of bytes needed in front of the input, which is zero when the
+ *                   string can be converted in place as it is.
+ * @return CUTF_SUCCESS if successful, otherwise an error code, which are the same as for ``cutf_is_utf16_valid``. On
+ *         error, the headroom is given for the valid part of the input.
+ */
+cutf_result_t cutf_s16tos8_inplace_headroom(size_t sz_in, const char16_t p_in[static sz_in], size_t *p_headroom);
+
+/**
+ * Convert a UTF-16 string to UTF-8 in place. The UTF-16 input starts ``offset`` bytes into the buffer, and the UTF-8
+ * output is written from the start of the buffer. Before each codepoint is written, it is checked that it does not
+ * overwrite input which was not read yet, so an offset smaller than the one given by ``cutf_s16tos8_inplace_headroom``
+ * stops the conversion with CUTF_INSUFFICIENT_BUFFER. On error, the input from ``*p_consumed`` onwards is left
+ * unchanged, after the ``*p_written`` converted units.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_buffer Buffer which holds the UTF-16 input, and receives the UTF-8 output.
+ * @param offset Offset in bytes of the input from the start of the buffer.
+ * @param p_consumed Pointer which receives the number of UTF-16 units converted.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s16tos8_inplace(size_t sz_in, void *p_buffer, size_t offset, size_t *p_consumed,
+                                   size_t *p_written);
+
+enum cutf_utf8_variant_t
+{
+    CUTF_UTF8_STANDARD, // Well-formed UTF-8
+    CUTF_UTF8_WTF8,     // WTF-8, which also encodes lone surrogates so that ill-formed UTF-16 is preserved
+    CUTF_UTF8_CESU8,    // CESU-8, which encodes each surrogate of a pair as a separate three unit sequence
+    CUTF_UTF8_MUTF8,    // Modified UTF-8 (used by Java), which is CESU-8 that allows lone surrogates and encodes
+                        // U+0000 as two units
+};
+typedef enum cutf_utf8_variant_t cutf_utf8_variant_t;
+
+/**
+ * Convert a UTF-16 string to a variant of UTF-8. Unlike ``cutf_s16tos8``, units are only written out once the
+ * complete sequence for a codepoint fits into the output buffer. For WTF-8 and Modified UTF-8 a lone high surrogate at
+ * the end of the input is kept in the state, so that it can be paired with the start of the next input. To write it
+ * out on its own at the end of the string, call the function again with an empty input.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-16 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @param variant Variant of UTF-8 to write.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s16tos8_variant(size_t sz_in, const char16_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                   char8_t p_out[sz_out], size_t *p_written, cutf_utf8_variant_t variant,
+                                   cutf_state_t *state);
+
+/**
+ * Convert a variant of UTF-8 to a UTF-16 string. Surrogates encoded in WTF-8, CESU-8 and Modified UTF-8 are written
+ * out as they are, so ill-formed UTF-16 is reproduced exactly. Unlike ``cutf_s8tos16``, units are only written out
+ * once both units of a surrogate pair fit into the output buffer. Input the variant does not allow is rejected: a
+ * surrogate outside of a pair in CESU-8, a pair of encoded surrogates in WTF-8 and a zero unit in Modified UTF-8. In
+ * CESU-8 and WTF-8, a high surrogate is kept in the state until the codepoint after it is known, so it is not written
+ * out at the end of the input. In WTF-8, it is written out as a lone surrogate by calling again without any input.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-16 units written.
+ * @param variant Variant of UTF-8 to read.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s8tos16_variant(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                   char16_t p_out[sz_out], size_t *p_written, cutf_utf8_variant_t variant,
+                                   cutf_state_t *state);
+
+enum cutf_latin1_mode_t
+{
+    CUTF_LATIN1_STRICT,     // Characters which can not be represented in Latin-1 are rejected as invalid input
+    CUTF_LATIN1_SUBSTITUTE, // Characters which can not be represented in Latin-1 are replaced with '?'
+};
+typedef enum cutf_latin1_mode_t cutf_latin1_mode_t;
+
+/**
+ * Convert a Latin-1 (ISO-8859-1) string to a UTF-8 string.
+ *
+ * @param sz_in Number of characters in the input.
+ * @param p_in Input Latin-1 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of Latin-1 characters consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_sl1tos8(size_t sz_in, const unsigned char p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                           char8_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
+
+/**
+ * Convert a Latin-1 (ISO-8859-1) string to a UTF-16 string.
+ *
+ * @param sz_in Number of characters in the input.
+ * @param p_in Input Latin-1 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of Latin-1 characters consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-16 units written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_sl1tos16(size_t sz_in, const unsigned char p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                            char16_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
+
+/**
+ * Convert a Latin-1 (ISO-8859-1) string to a UTF-32 string.
+ *
+ * @param sz_in Number of characters in the input.
+ * @param p_in Input Latin-1 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of Latin-1 characters consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-32 units written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_sl1tos32(size_t sz_in, const unsigned char p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                            char32_t p_out[sz_out], size_t *p_written, cutf_state_t *state);
+
+/**
+ * Convert a UTF-8 string to a Latin-1 (ISO-8859-1) string.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of Latin-1 characters written.
+ * @param mode How to deal with characters which can not be represented in Latin-1.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s8tosl1(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                           unsigned char p_out[sz_out], size_t *p_written, cutf_latin1_mode_t mode,
+                           cutf_state_t *state);
+
+/**
+ * Convert a UTF-16 string to a Latin-1 (ISO-8859-1) string.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-16 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of Latin-1 characters written.
+ * @param mode How to deal with characters which can not be represented in Latin-1.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s16tosl1(size_t sz_in, const char16_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                            unsigned char p_out[sz_out], size_t *p_written, cutf_latin1_mode_t mode,
+                            cutf_state_t *state);
+
+/**
+ * Convert a UTF-32 string to a Latin-1 (ISO-8859-1) string.
+ *
+ * @param sz_in Number of UTF-32 units in the input.
+ * @param p_in Input UTF-32 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-32 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of Latin-1 characters written.
+ * @param mode How to deal with characters which can not be represented in Latin-1.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+cutf_result_t cutf_s32tosl1(size_t sz_in, const char32_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                            unsigned char p_out[sz_out], size_t *p_written, cutf_latin1_mode_t mode,
+                            cutf_state_t *state);
+
+/**
+ * Check if all characters of a UTF-8 string can be represented in Latin-1 (ISO-8859-1).
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to check.
+ * @return True if the input is a complete UTF-8 string, which can be converted to Latin-1 without loss.
+ */
+bool cutf_fits_latin1_s8(size_t sz_in, const char8_t p_in[static sz_in]);
+
+/**
+ * Check if all characters of a UTF-16 string can be represented in Latin-1 (ISO-8859-1).
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to check.
+ * @return True if the input can be converted to Latin-1 without loss.
+ */
+bool cutf_fits_latin1_s16(size_t sz_in, const char16_t p_in[static sz_in]);
+
+/**
+ * Check if all characters of a UTF-32 string can be represented in Latin-1 (ISO-8859-1).
+ *
+ * @param sz_in Number of UTF-32 units in the input.
+ * @param p_in Input UTF-32 string to check.
+ * @return True if the input can be converted to Latin-1 without loss.
+ */
+bool cutf_fits_latin1_s32(size_t sz_in, const char32_t p_in[static sz_in]);
+
+enum cutf_width_class_t
+{
+    CUTF_WIDTH_ASCII,  // All codepoints are below U+0080, so one byte per codepoint is enough
+    CUTF_WIDTH_LATIN1, // All codepoints are below U+0100, so one byte per codepoint is enough
+    CUTF_WIDTH_BMP,    // All codepoints are below U+10000, so two bytes per codepoint are enough
+    CUTF_WIDTH_ASTRAL, // Some codepoints are above U+FFFF, so four bytes per codepoint are needed
+};
+typedef enum cutf_width_class_t cutf_width_class_t;
+
+struct cutf_analysis_t
+{
+    size_t count;                   // Number of codepoints
+    cutf_width_class_t width_class; // Narrowest fixed width representation that can hold all codepoints
+};
+typedef struct cutf_analysis_t cutf_analysis_t;
+
+/**
+ * Determine the number of bytes needed per codepoint for a width class.
+ *
+ * @param width_class Width class of the string.
+ * @return Number of bytes per codepoint, or zero if the width class is not valid.
+ */
+size_t cutf_width_class_size(cutf_width_class_t width_class);
+
+/**
+ * Count the number of codepoints in a UTF-8 string and determine the narrowest fixed width representation that can
+ * hold all of them in a single pass.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to analyze.
+ * @param valid_count Pointer that receives the number of UTF-8 units which form complete codepoints.
+ * @param p_analysis Pointer that receives the codepoint count and width class of the valid part of the input.
+ * @return CUTF_SUCCESS on success, otherwise an error code, which are the same as for ``cutf_count_s8asc32``.
+ */
+cutf_result_t cutf_analyze_s8(size_t sz_in, const char8_t p_in[static sz_in], size_t *valid_count,
+                              cutf_analysis_t *p_analysis);
+
+/**
+ * Count the number of codepoints in a UTF-16 string and determine the narrowest fixed width representation that can
+ * hold all of them in a single pass.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to analyze.
+ * @param valid_count Pointer that receives the number of UTF-16 units which form complete codepoints.
+ * @param p_analysis Pointer that receives the codepoint count and width class of the valid part of the input.
+ * @return CUTF_SUCCESS if the input is valid, CUTF_INCOMPLETE_INPUT if the last surrogate pair is not complete, or
+ *         CUTF_INVALID_INPUT if the input is not UTF-16 encoded.
+ */
+cutf_result_t cutf_analyze_s16(size_t sz_in, const char16_t p_in[static sz_in], size_t *valid_count,
+                               cutf_analysis_t *p_analysis);
+
+/**
+ * Convert a UTF-8 string into a fixed width string, with each codepoint taking the number of bytes given by
+ * ``cutf_width_class_size``. These are Latin-1 characters, UCS-2 units, or UTF-32 units respectively.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to convert.
+ * @param width_class Width class of the output, usually obtained from ``cutf_analyze_s8``.
+ * @param sz_out Number of codepoints the output array can hold.
+ * @param p_consumed Pointer which receives the number of UTF-8 units consumed.
+ * @param p_out Pointer to the output array, which must be suitably aligned for the width class.
+ * @param p_written Pointer which receives the number of codepoints written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code. If a codepoint does not fit into the width class,
+ *         CUTF_INVALID_INPUT is returned.
+ */
+cutf_result_t cutf_s8tonarrow(size_t sz_in, const char8_t p_in[static sz_in], cutf_width_class_t width_class,
+                              size_t sz_out, size_t *p_consumed, void *p_out, size_t *p_written, cutf_state_t *state);
+
+/**
+ * Convert a UTF-16 string into a fixed width string, with each codepoint taking the number of bytes given by
+ * ``cutf_width_class_size``. These are Latin-1 characters, UCS-2 units, or UTF-32 units respectively.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to convert.
+ * @param width_class Width class of the output, usually obtained from ``cutf_analyze_s16``.
+ * @param sz_out Number of codepoints the output array can hold.
+ * @param p_consumed Pointer which receives the number of UTF-16 units consumed.
+ * @param p_out Pointer to the output array, which must be suitably aligned for the width class.
+ * @param p_written Pointer which receives the number of codepoints written.
+ * @param state Pointer to the conversion state.
+ * @return CUTF_SUCCESS if successful, otherwise an error code. If a codepoint does not fit into the width class,
+ *         CUTF_INVALID_INPUT is returned.
+ */
+cutf_result_t cutf_s16tonarrow(size_t sz_in, const char16_t p_in[static sz_in], cutf_width_class_t width_class,
+                               size_t sz_out, size_t *p_consumed, void *p_out, size_t *p_written,
+                               cutf_state_t *state);
+
 /**
  * Check if the character is whitespace.
  *
@@ -228,12 +957,12 @@ cutf_result_t cutf_s16tos8(size_t sz_in, const char16_t p_in[static sz_in], size
 bool cutf_is_whitespace(char32_t c);
 
 /**
- * Check if the character is line-break.
+ * Check if the character is a line terminator.
  *
  * @param c Character to check.
- * @return Non-zero if the character is considered a line-break.
+ * @return Non-zero if the character is considered a line terminator.
  */
-bool cutf_is_line_break(char32_t c);
+bool cutf_is_line_terminator(char32_t c);
 
 /**
  * Check if the character can be used to break a line text and replace it with a new line.
@@ -242,3 +971,321 @@ bool cutf_is_line_break(char32_t c);
  * @return Non-zero if the character is allowed to break a line.
  */
 bool cutf_is_allowed_to_break(char32_t c);
+
+/**
+ * Check if the character can start an identifier, as defined by the XID_Start property of UAX #31.
+ *
+ * @param c Character to check.
+ * @return Non-zero if the character can start an identifier.
+ */
+bool cutf_is_xid_start(char32_t c);
+
+/**
+ * Check if the character can continue an identifier, as defined by the XID_Continue property of UAX #31.
+ *
+ * @param c Character to check.
+ * @return Non-zero if the character can be part of an identifier after its first character.
+ */
+bool cutf_is_xid_continue(char32_t c);
+
+/**
+ * Find the number of UTF-8 units at the start of the string which form an identifier. Identifiers start with a
+ * character for which ``cutf_is_xid_start`` is true or an underscore, followed by any number of characters for which
+ * ``cutf_is_xid_continue`` is true. Units which are not correctly encoded end the identifier.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @return Number of UTF-8 units of the identifier, or zero if the string does not start with one.
+ */
+size_t cutf_utf8_scan_identifier(size_t sz_in, const char8_t p_in[static sz_in]);
+
+struct cutf_span_t
+{
+    size_t start;  // Offset of the first unit of the span
+    size_t length; // Number of units in the span
+};
+typedef struct cutf_span_t cutf_span_t;
+
+/**
+ * Wrap a UTF-8 string into lines, such that no line is longer than the specified number of codepoints. Lines are broken
+ * at line terminators and at characters for which ``cutf_is_allowed_to_break`` is true. The character at which the
+ * line was broken is not included in either of the lines. When a line contains no such character, it is broken right
+ * before the codepoint which would exceed the width.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to wrap.
+ * @param width Maximum number of codepoints in a line. Must not be zero.
+ * @param sz_out Number of spans the output array can hold.
+ * @param p_consumed Pointer which receives the number of UTF-8 units which were wrapped into lines. Wrapping can be
+ *                   resumed from this position.
+ * @param p_out Array which receives the spans of lines, given as offsets into the input.
+ * @param p_written Pointer which receives the number of lines written.
+ * @return CUTF_SUCCESS if successful, CUTF_INSUFFICIENT_BUFFER if there were more lines than could fit in the output,
+ *         CUTF_INCOMPLETE_INPUT if the input ended in the middle of a codepoint, or CUTF_INVALID_INPUT if the
+ *         input was not UTF-8 encoded or the width was zero.
+ */
+cutf_result_t cutf_utf8_wrap(size_t sz_in, const char8_t p_in[static sz_in], size_t width, size_t sz_out,
+                             size_t *p_consumed, cutf_span_t p_out[sz_out], size_t *p_written);
+
+/**
+ * Find the number of UTF-8 units at the start of the string which encode whitespace characters, as determined by
+ * ``cutf_is_whitespace``. Units which are not correctly encoded are not considered whitespace.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @return Number of UTF-8 units of leading whitespace.
+ */
+size_t cutf_utf8_skip_whitespace(size_t sz_in, const char8_t p_in[static sz_in]);
+
+/**
+ * Find the part of the UTF-8 string without any leading or trailing whitespace characters.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @return Span of the trimmed string within the input.
+ */
+cutf_span_t cutf_utf8_trim(size_t sz_in, const char8_t p_in[static sz_in]);
+
+/**
+ * Find the next field of the UTF-8 string which is separated by whitespace characters. Calling this repeatedly with
+ * the same position variable iterates over all fields in the string.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @param p_pos Pointer to the position to start searching from, which should be initialized to zero. It receives the
+ *              position from which to search for the next field.
+ * @param p_span Pointer which receives the span of the field found.
+ * @return True if a field was found, false if there are no more fields.
+ */
+bool cutf_utf8_split_whitespace(size_t sz_in, const char8_t p_in[static sz_in], size_t *p_pos, cutf_span_t *p_span);
+
+/**
+ * Determine the number of columns a codepoint takes when shown in a terminal, like ``wcwidth``, but independent of the
+ * locale.
+ *
+ * @param c Codepoint to check.
+ * @return 0 for combining marks, format and control characters, 2 for wide and fullwidth characters, such as CJK
+ *         ideographs, and emoji, and 1 for all other codepoints.
+ */
+size_t cutf_codepoint_display_width(char32_t c);
+
+/**
+ * Determine the number of columns a UTF-8 string takes when shown in a terminal. Each grapheme cluster takes the
+ * columns of its widest codepoint, as given by ``cutf_codepoint_display_width``, so that a letter with combining marks
+ * is as wide as the letter, and an emoji sequence as wide as a single emoji. A character followed by the emoji
+ * presentation selector U+FE0F takes two columns.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @param p_valid Pointer which receives the number of UTF-8 units which were measured.
+ * @param p_width Pointer which receives the number of columns of the measured part of the input.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ended in the middle of a codepoint, or
+ *         CUTF_INVALID_INPUT if the input was not UTF-8 encoded.
+ */
+cutf_result_t cutf_utf8_display_width(size_t sz_in, const char8_t p_in[static sz_in], size_t *p_valid,
+                                      size_t *p_width);
+
+/**
+ * Find the longest prefix of a UTF-8 string which fits into a number of terminal columns, measured as for
+ * ``cutf_utf8_display_width``. The string is only cut between grapheme clusters.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @param max_width Maximum number of columns of the prefix.
+ * @param p_consumed Pointer which receives the number of UTF-8 units of the prefix.
+ * @param p_width Pointer which receives the number of columns of the prefix.
+ * @return CUTF_SUCCESS if successful, which includes when the string had to be cut, otherwise an error code, which are
+ *         the same as for ``cutf_utf8_display_width``.
+ */
+cutf_result_t cutf_utf8_truncate_width(size_t sz_in, const char8_t p_in[static sz_in], size_t max_width,
+                                       size_t *p_consumed, size_t *p_width);
+
+/**
+ * Apply simple case folding to a codepoint, which maps it to a single codepoint, usually its lower case version, such
+ * that codepoints which only differ in case fold to the same one.
+ *
+ * @param c Codepoint to fold.
+ * @return Folded codepoint, which is the codepoint itself if it has no case or is not valid.
+ */
+char32_t cutf_simple_casefold(char32_t c);
+
+/**
+ * Determine the number of UTF-8 units ``cutf_utf8_casefold`` writes for a string, which can differ from the number of
+ * units of the string, as folded codepoints may take more or fewer units than the original ones.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @param p_valid Pointer which receives the number of UTF-8 units which were counted.
+ * @param p_count Pointer which receives the number of UTF-8 units of the folded string.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ended in the middle of a codepoint, or
+ *         CUTF_INVALID_INPUT if the input was not UTF-8 encoded.
+ */
+cutf_result_t cutf_utf8_casefold_count(size_t sz_in, const char8_t p_in[static sz_in], size_t *p_valid,
+                                       size_t *p_count);
+
+/**
+ * Apply simple case folding to a UTF-8 string, as done by ``cutf_simple_casefold`` for each codepoint. Folding can be
+ * resumed from where it stopped, once more input is available or the output was emptied.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to fold.
+ * @param sz_out Number of UTF-8 units the output array can hold.
+ * @param p_consumed Pointer which receives the number of UTF-8 units consumed.
+ * @param p_out Array which receives the folded UTF-8 string.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @return CUTF_SUCCESS if successful, CUTF_INSUFFICIENT_BUFFER if the output could not hold the whole folded string,
+ *         or an error code as for ``cutf_utf8_casefold_count``. Only whole codepoints are consumed and written.
+ */
+cutf_result_t cutf_utf8_casefold(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_out, size_t *p_consumed,
+                                 char8_t p_out[sz_out], size_t *p_written);
+
+/**
+ * Compare two UTF-8 strings while ignoring case, by comparing their codepoints after simple case folding. No memory is
+ * allocated for the folded strings.
+ *
+ * @param sz_a Number of UTF-8 units in the first string.
+ * @param p_a First UTF-8 string.
+ * @param sz_b Number of UTF-8 units in the second string.
+ * @param p_b Second UTF-8 string.
+ * @param p_order Pointer which receives a negative value if the first string is ordered before the second one, zero
+ *                if they are equal, or a positive value if it is ordered after it. Strings are ordered by their first
+ *                folded codepoint which differs, and a string which is the start of the other one comes first.
+ * @return CUTF_SUCCESS if successful, otherwise an error code as for ``cutf_utf8_casefold_count``, when one of the
+ *         strings is not correctly encoded before the first difference.
+ */
+cutf_result_t cutf_utf8_casecmp(size_t sz_a, const char8_t p_a[static sz_a], size_t sz_b,
+                                const char8_t p_b[static sz_b], int *p_order);
+
+/**
+ * Hash a UTF-8 string for hash tables. The hash depends only on the codepoints of the string, so it is the same as the
+ * one ``cutf_hash_utf16`` and ``cutf_hash_utf32`` give for the same codepoints in their encodings, and strings do not
+ * need to be converted to a common encoding first. Hashes can differ between versions of the library and platforms.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to hash.
+ * @param seed Value the hash starts from, such as a random one chosen for each process to make collisions hard to
+ *             predict.
+ * @param p_valid Pointer which receives the number of UTF-8 units which were hashed.
+ * @param p_hash Pointer which receives the hash of the codepoints which were hashed.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ended in the middle of a codepoint, or
+ *         CUTF_INVALID_INPUT if the input was not UTF-8 encoded, including overlong encodings.
+ */
+cutf_result_t cutf_hash_utf8(size_t sz_in, const char8_t p_in[static sz_in], uint64_t seed, size_t *p_valid,
+                             uint64_t *p_hash);
+
+/**
+ * Hash a UTF-16 string for hash tables, as done by ``cutf_hash_utf8``.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to hash.
+ * @param seed Value the hash starts from.
+ * @param p_valid Pointer which receives the number of UTF-16 units which were hashed.
+ * @param p_hash Pointer which receives the hash of the codepoints which were hashed.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ended after a high surrogate, or
+ *         CUTF_INVALID_INPUT if the surrogates are not paired.
+ */
+cutf_result_t cutf_hash_utf16(size_t sz_in, const char16_t p_in[static sz_in], uint64_t seed, size_t *p_valid,
+                              uint64_t *p_hash);
+
+/**
+ * Hash a UTF-32 string for hash tables, as done by ``cutf_hash_utf8``.
+ *
+ * @param sz_in Number of UTF-32 units in the input.
+ * @param p_in Input UTF-32 string to hash.
+ * @param seed Value the hash starts from.
+ * @param p_valid Pointer which receives the number of UTF-32 units which were hashed.
+ * @param p_hash Pointer which receives the hash of the codepoints which were hashed.
+ * @return CUTF_SUCCESS if successful, or CUTF_INVALID_INPUT if a unit is not a valid codepoint.
+ */
+cutf_result_t cutf_hash_utf32(size_t sz_in, const char32_t p_in[static sz_in], uint64_t seed, size_t *p_valid,
+                              uint64_t *p_hash);
+
+/**
+ * Compare a UTF-8 string with a UTF-16 string in codepoint order, without converting either of them. Strings are
+ * ordered by their first codepoint which differs, and a string which is the start of the other one comes first. For
+ * UTF-8 and UTF-32 this is the same as the order of the units, but not for UTF-16, where surrogates sort before the
+ * units of codepoints from U+E000 to U+FFFF.
+ *
+ * @param sz_a Number of UTF-8 units in the first string.
+ * @param p_a First string, encoded as UTF-8.
+ * @param sz_b Number of UTF-16 units in the second string.
+ * @param p_b Second string, encoded as UTF-16.
+ * @param p_order Pointer which receives a negative value if the first string is ordered before the second one, zero
+ *                if they are equal, or a positive value if it is ordered after it.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if one of the strings ends in the middle of a codepoint
+ *         before the first difference, or CUTF_INVALID_INPUT if one of them is not correctly encoded before it.
+ */
+cutf_result_t cutf_compare_s8_s16(size_t sz_a, const char8_t p_a[static sz_a], size_t sz_b,
+                                  const char16_t p_b[static sz_b], int *p_order);
+
+/**
+ * Compare a UTF-8 string with a UTF-32 string in codepoint order, as done by ``cutf_compare_s8_s16``.
+ *
+ * @param sz_a Number of UTF-8 units in the first string.
+ * @param p_a First string, encoded as UTF-8.
+ * @param sz_b Number of UTF-32 units in the second string.
+ * @param p_b Second string, encoded as UTF-32.
+ * @param p_order Pointer which receives the order of the first string relative to the second one.
+ * @return CUTF_SUCCESS if successful, otherwise an error code as for ``cutf_compare_s8_s16``.
+ */
+cutf_result_t cutf_compare_s8_s32(size_t sz_a, const char8_t p_a[static sz_a], size_t sz_b,
+                                  const char32_t p_b[static sz_b], int *p_order);
+
+/**
+ * Compare a UTF-16 string with a UTF-32 string in codepoint order, as done by ``cutf_compare_s8_s16``.
+ *
+ * @param sz_a Number of UTF-16 units in the first string.
+ * @param p_a First string, encoded as UTF-16.
+ * @param sz_b Number of UTF-32 units in the second string.
+ * @param p_b Second string, encoded as UTF-32.
+ * @param p_order Pointer which receives the order of the first string relative to the second one.
+ * @return CUTF_SUCCESS if successful, otherwise an error code as for ``cutf_compare_s8_s16``.
+ */
+cutf_result_t cutf_compare_s16_s32(size_t sz_a, const char16_t p_a[static sz_a], size_t sz_b,
+                                   const char32_t p_b[static sz_b], int *p_order);
+
+/**
+ * Compare two UTF-16 strings in codepoint order, as done by ``cutf_compare_s8_s16``, which is not the order of their
+ * units when one of them contains surrogates.
+ *
+ * @param sz_a Number of UTF-16 units in the first string.
+ * @param p_a First UTF-16 string.
+ * @param sz_b Number of UTF-16 units in the second string.
+ * @param p_b Second UTF-16 string.
+ * @param p_order Pointer which receives the order of the first string relative to the second one.
+ * @return CUTF_SUCCESS if successful, otherwise an error code as for ``cutf_compare_s8_s16``.
+ */
+cutf_result_t cutf_compare_s16_s16(size_t sz_a, const char16_t p_a[static sz_a], size_t sz_b,
+                                   const char16_t p_b[static sz_b], int *p_order);
+
+/**
+ * Find the first occurrence of a UTF-8 needle in a UTF-8 string. Unlike ``memmem``, only occurrences which start and
+ * end on codepoint boundaries of the string are found, so a needle never matches part of a multi-unit sequence. The
+ * string is not validated, which keeps the search fast for scanning large amounts of text.
+ *
+ * @param sz_in Number of UTF-8 units in the string to search.
+ * @param p_in UTF-8 string to search.
+ * @param sz_needle Number of UTF-8 units in the needle. An empty needle is found at the start of the string.
+ * @param p_needle UTF-8 string to find.
+ * @param p_offset Pointer which receives the offset in UTF-8 units at which the needle was found.
+ * @param p_codepoint_offset Pointer which receives the offset in codepoints at which the needle was found. May be
+ *                           NULL, which saves counting the codepoints before the occurrence.
+ * @return true if the needle was found, otherwise false, in which case the offsets are not written.
+ */
+bool cutf_utf8_find(size_t sz_in, const char8_t p_in[static sz_in], size_t sz_needle,
+                    const char8_t p_needle[static sz_needle], size_t *p_offset, size_t *p_codepoint_offset);
+
+/**
+ * Find the first occurrence of a codepoint in a UTF-8 string, as done by ``cutf_utf8_find``.
+ *
+ * @param sz_in Number of UTF-8 units in the string to search.
+ * @param p_in UTF-8 string to search.
+ * @param c Codepoint to find.
+ * @param p_offset Pointer which receives the offset in UTF-8 units at which the codepoint was found.
+ * @param p_codepoint_offset Pointer which receives the offset in codepoints at which the codepoint was found. May be
+ *                           NULL.
+ * @return true if the codepoint was found, otherwise false, which is also returned for values which are not valid
+ *         codepoints.
+ */
+bool cutf_utf8_find_codepoint(size_t sz_in, const char8_t p_in[static sz_in], char32_t c, size_t *p_offset,
+                              size_t *p_codepoint_offset);
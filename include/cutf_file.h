@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cutf.h"
+
+/**
+ * Convert a whole file between encodings. Both files are memory mapped, so that the conversion happens directly between
+ * the mappings. The input is first checked and counted, so the output file is only created once it is known the whole
+ * input can be converted, and has exactly the right size. UTF-16 and UTF-32 units are in the byte order of the machine.
+ * This is only available on POSIX systems.
+ *
+ * @param in_path Path of the file to convert.
+ * @param from Encoding of the input file.
+ * @param out_path Path of the file which receives the converted contents, replacing it if it exists. It can not be the
+ *                 input file.
+ * @param to Encoding of the output file.
+ * @param p_written Pointer which receives the number of units written into the output file, only set when successful.
+ * @return CUTF_SUCCESS if successful, CUTF_INVALID_INPUT or CUTF_INCOMPLETE_INPUT if the input is not correctly
+ *         encoded, or CUTF_FILE_ERROR if one of the files could not be accessed, in which case errno is set, which
+ *         includes when both paths refer to the same file, with errno set to EINVAL.
+ */
+cutf_result_t cutf_convert_file(const char *in_path, cutf_encoding_t from, const char *out_path, cutf_encoding_t to,
+                                size_t *p_written);
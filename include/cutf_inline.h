@@ -0,0 +1,541 @@
+#pragma once
+
+#include "cutf.h"
+
+// Inline versions of the single codepoint functions and conversions of short strings. These are the same functions
+// the library itself uses, so the results are identical to the ones of the functions in ``cutf.h``, but allow the
+// compiler to inline them when processing strings which are only a few units long. The iterator over codepoints,
+// ``cutf_iter_t``, is defined here as well. Its functions which process more than one codepoint at a time,
+// ``cutf_iter_next_block``, ``cutf_iter_next_grapheme`` and ``cutf_iter_skip_graphemes``, are not inline, but part of
+// the library like the functions in ``cutf.h``.
+
+/**
+ * Check if the value is a Unicode scalar value, meaning it is neither too large nor a surrogate.
+ *
+ * @param c Value to check.
+ * @return true if the value can be encoded in any of the UTF encodings.
+ */
+static inline bool cutf_inline_is_valid_codepoint(const char32_t c)
+{
+    return (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) == 0;
+}
+
+/**
+ * Check if the codepoint is an ASCII character.
+ *
+ * @param c Codepoint to check.
+ * @return true if the codepoint is below U+0080.
+ */
+static inline bool cutf_inline_is_ascii(const char32_t c)
+{
+    return c < 0x80;
+}
+
+/**
+ * Check if the UTF-8 unit is a continuation unit (10xxxxxx).
+ *
+ * @param c UTF-8 unit to check.
+ * @return true if the unit is a continuation unit.
+ */
+static inline bool cutf_inline_utf8_is_continuation(const char8_t c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+/**
+ * Classify a leading UTF-8 unit by the number of continuation units which follow it.
+ *
+ * @param c UTF-8 unit to classify.
+ * @return CUTF_STATE_CLEAR for a single unit codepoint, CUTF_STATE_U8_1 to CUTF_STATE_U8_3 for the number of
+ *         continuation units needed, or CUTF_STATE_ERROR if the unit can not start a codepoint.
+ */
+static inline cutf_state_type_t cutf_inline_utf8_classify_leading_byte(const char8_t c)
+{
+    if (c < 0x80)
+        return CUTF_STATE_CLEAR;
+    if (c < 0xC0)
+        return CUTF_STATE_ERROR;
+    if (c < 0xE0)
+        return CUTF_STATE_U8_1;
+    if (c < 0xF0)
+        return CUTF_STATE_U8_2;
+    if (c < 0xF8)
+        return CUTF_STATE_U8_3;
+    return CUTF_STATE_ERROR;
+}
+
+/**
+ * Check if the UTF-16 unit is a high surrogate (0xD800 to 0xDBFF).
+ *
+ * @param c UTF-16 unit to check.
+ * @return true if the unit is a high surrogate.
+ */
+static inline bool cutf_inline_utf16_is_high_surrogate(const char32_t c)
+{
+    return c >= 0xD800 && c <= 0xDBFF;
+}
+
+/**
+ * Check if the UTF-16 unit is a low surrogate (0xDC00 to 0xDFFF).
+ *
+ * @param c UTF-16 unit to check.
+ * @return true if the unit is a low surrogate.
+ */
+static inline bool cutf_inline_utf16_is_low_surrogate(const char32_t c)
+{
+    return c >= 0xDC00 && c <= 0xDFFF;
+}
+
+/**
+ * Inline version of ``cutf_utf8_next_codepoint``.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input string to advance along.
+ * @param p_consumed Pointer which receives the number of UTF-8 units to advance to the next Unicode unit.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+static inline cutf_result_t cutf_inline_utf8_next_codepoint(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                                            size_t *const p_consumed)
+{
+    size_t needed_continuations;
+    switch (cutf_inline_utf8_classify_leading_byte(p_in[0]))
+    {
+    case CUTF_STATE_U8_3:
+        needed_continuations = 3;
+        break;
+
+    case CUTF_STATE_U8_2:
+        needed_continuations = 2;
+        break;
+
+    case CUTF_STATE_U8_1:
+        needed_continuations = 1;
+        break;
+
+    case CUTF_STATE_CLEAR:
+        needed_continuations = 0;
+        break;
+
+    default:
+        return CUTF_INVALID_INPUT;
+    }
+
+    if (needed_continuations + 1 > sz_in)
+        return CUTF_INCOMPLETE_INPUT;
+
+    for (size_t j = 0; j < needed_continuations; ++j)
+    {
+        if (!cutf_inline_utf8_is_continuation(p_in[j + 1]))
+            return CUTF_INVALID_INPUT;
+    }
+
+    *p_consumed = 1 + needed_continuations;
+    return CUTF_SUCCESS;
+}
+
+/**
+ * Decode a single codepoint from the start of a UTF-8 string. Unlike ``cutf_inline_utf8_next_codepoint``, the value is
+ * checked as well, so overlong encodings, surrogates and values above U+10FFFF are rejected.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string to decode.
+ * @param p_consumed Pointer which receives the number of UTF-8 units the codepoint was encoded with.
+ * @param p_out Pointer which receives the decoded codepoint.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ends in the middle of a codepoint which the
+ *         units after it could still complete, or CUTF_INVALID_INPUT if it is not a correctly encoded codepoint, which
+ *         includes the start of one which can not become valid, such as E0 80 or ED A0 at the end of the input.
+ */
+static inline cutf_result_t cutf_inline_utf8_decode(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                                    size_t *const p_consumed, char32_t *const p_out)
+{
+    // Overlong encodings, surrogates and values above U+10FFFF are known from the leading unit and the first
+    // continuation unit, so they are rejected before checking whether the input is long enough
+    const char8_t lead = p_in[0];
+    if (lead == 0xC0 || lead == 0xC1 || lead >= 0xF5)
+        return CUTF_INVALID_INPUT;
+    if (sz_in >= 2 && ((lead == 0xE0 && p_in[1] < 0xA0) || (lead == 0xED && p_in[1] > 0x9F) ||
+                       (lead == 0xF0 && p_in[1] < 0x90) || (lead == 0xF4 && p_in[1] > 0x8F)))
+        return CUTF_INVALID_INPUT;
+
+    size_t consumed;
+    const cutf_result_t res = cutf_inline_utf8_next_codepoint(sz_in, p_in, &consumed);
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    // Bits of the leading unit which are part of the value, based on the length of the sequence
+    static const char8_t leading_masks[] = {0x7F, 0x1F, 0x0F, 0x07};
+    char32_t c = p_in[0] & leading_masks[consumed - 1];
+    for (size_t j = 1; j < consumed; ++j)
+        c = (c << 6) | (p_in[j] & 0x3F);
+
+    *p_consumed = consumed;
+    *p_out = c;
+    return CUTF_SUCCESS;
+}
+
+/**
+ * Encode a single codepoint as UTF-8.
+ *
+ * @param c Codepoint to encode.
+ * @param p_out Array which receives the UTF-8 units.
+ * @return Number of UTF-8 units written, or zero if the codepoint is not valid.
+ */
+static inline size_t cutf_inline_utf8_encode(const char32_t c, char8_t p_out[const static 4])
+{
+    if (!cutf_inline_is_valid_codepoint(c))
+        return 0;
+
+    if (c < 0x80)
+    {
+        p_out[0] = (char8_t)c;
+        return 1;
+    }
+    if (c < 0x800)
+    {
+        p_out[0] = (char8_t)(0xC0 | (c >> 6));
+        p_out[1] = (char8_t)(0x80 | (c & 0x3F));
+        return 2;
+    }
+    if (c < 0x10000)
+    {
+        p_out[0] = (char8_t)(0xE0 | (c >> 12));
+        p_out[1] = (char8_t)(0x80 | ((c >> 6) & 0x3F));
+        p_out[2] = (char8_t)(0x80 | (c & 0x3F));
+        return 3;
+    }
+    p_out[0] = (char8_t)(0xF0 | (c >> 18));
+    p_out[1] = (char8_t)(0x80 | ((c >> 12) & 0x3F));
+    p_out[2] = (char8_t)(0x80 | ((c >> 6) & 0x3F));
+    p_out[3] = (char8_t)(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/**
+ * Decode a single codepoint from the start of a UTF-16 string.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string to decode.
+ * @param p_consumed Pointer which receives the number of UTF-16 units the codepoint was encoded with.
+ * @param p_out Pointer which receives the decoded codepoint.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the input ends after a high surrogate, or
+ *         CUTF_INVALID_INPUT if the surrogates are not paired.
+ */
+static inline cutf_result_t cutf_inline_utf16_decode(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                                     size_t *const p_consumed, char32_t *const p_out)
+{
+    const char16_t c = p_in[0];
+    if (cutf_inline_utf16_is_low_surrogate(c))
+        return CUTF_INVALID_INPUT;
+
+    if (!cutf_inline_utf16_is_high_surrogate(c))
+    {
+        *p_consumed = 1;
+        *p_out = c;
+        return CUTF_SUCCESS;
+    }
+
+    if (sz_in < 2)
+        return CUTF_INCOMPLETE_INPUT;
+
+    if (!cutf_inline_utf16_is_low_surrogate(p_in[1]))
+        return CUTF_INVALID_INPUT;
+
+    *p_consumed = 2;
+    *p_out = 0x10000 + ((char32_t)(c & 0x3FF) << 10) + (p_in[1] & 0x3FF);
+    return CUTF_SUCCESS;
+}
+
+/**
+ * Encode a single codepoint as UTF-16.
+ *
+ * @param c Codepoint to encode.
+ * @param p_out Array which receives the UTF-16 units.
+ * @return Number of UTF-16 units written, or zero if the codepoint is not valid.
+ */
+static inline size_t cutf_inline_utf16_encode(const char32_t c, char16_t p_out[const static 2])
+{
+    if (!cutf_inline_is_valid_codepoint(c))
+        return 0;
+
+    if (c < 0x10000)
+    {
+        p_out[0] = (char16_t)c;
+        return 1;
+    }
+    const char32_t adjusted = c - 0x10000;
+    p_out[0] = (char16_t)(0xD800 | (adjusted >> 10));
+    p_out[1] = (char16_t)(0xDC00 | (adjusted & 0x3FF));
+    return 2;
+}
+
+/**
+ * Convert a short UTF-8 string to a UTF-32 string. Unlike ``cutf_s8tos32`` no conversion state is kept, so an
+ * incomplete codepoint at the end of the input is not consumed.
+ *
+ * @param sz_in Number of UTF-8 units to convert.
+ * @param p_in Input UTF-8 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-8 units converted.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-32 units written.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+static inline cutf_result_t cutf_inline_s8tos32(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                                const size_t sz_out, size_t *const p_consumed,
+                                                char32_t p_out[const sz_out], size_t *const p_written)
+{
+    size_t pos_in = 0, pos_out = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        if (pos_out == sz_out)
+        {
+            res = CUTF_INSUFFICIENT_BUFFER;
+            break;
+        }
+
+        size_t consumed;
+        res = cutf_inline_utf8_decode(sz_in - pos_in, p_in + pos_in, &consumed, p_out + pos_out);
+        if (res != CUTF_SUCCESS)
+            break;
+        pos_in += consumed;
+        pos_out += 1;
+    }
+
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
+
+/**
+ * Convert a short UTF-32 string to a UTF-8 string. Unlike ``cutf_s32tos8`` no conversion state is kept, so only
+ * complete codepoints are written into the output.
+ *
+ * @param sz_in Number of characters in the input.
+ * @param p_in Input UTF-32 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-32 units consumed.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-8 units written.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+static inline cutf_result_t cutf_inline_s32tos8(const size_t sz_in, const char32_t p_in[const static sz_in],
+                                                const size_t sz_out, size_t *const p_consumed,
+                                                char8_t p_out[const sz_out], size_t *const p_written)
+{
+    size_t pos_in = 0, pos_out = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    for (; pos_in < sz_in; ++pos_in)
+    {
+        char8_t buffer[4];
+        const size_t count = cutf_inline_utf8_encode(p_in[pos_in], buffer);
+        if (count == 0)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (count > sz_out - pos_out)
+        {
+            res = CUTF_INSUFFICIENT_BUFFER;
+            break;
+        }
+        for (size_t j = 0; j < count; ++j)
+            p_out[pos_out + j] = buffer[j];
+        pos_out += count;
+    }
+
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
+
+/**
+ * Convert a short UTF-16 string to a UTF-32 string. Unlike ``cutf_s16tos32`` no conversion state is kept, so an
+ * unpaired high surrogate at the end of the input is not consumed.
+ *
+ * @param sz_in Number of UTF-16 units to convert.
+ * @param p_in Input UTF-16 string to convert.
+ * @param sz_out Size of the output string.
+ * @param p_consumed Pointer which receives the number of UTF-16 units converted.
+ * @param p_out Pointer to the output array.
+ * @param p_written Pointer which receives the number of UTF-32 units written.
+ * @return CUTF_SUCCESS if successful, otherwise an error code.
+ */
+static inline cutf_result_t cutf_inline_s16tos32(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                                 const size_t sz_out, size_t *const p_consumed,
+                                                 char32_t p_out[const sz_out], size_t *const p_written)
+{
+    size_t pos_in = 0, pos_out = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        if (pos_out == sz_out)
+        {
+            res = CUTF_INSUFFICIENT_BUFFER;
+            break;
+        }
+
+        size_t consumed;
+        res = cutf_inline_utf16_decode(sz_in - pos_in, p_in + pos_in, &consumed, p_out + pos_out);
+        if (res != CUTF_SUCCESS)
+            break;
+        pos_in += consumed;
+        pos_out += 1;
+    }
+
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
+
+struct cutf_iter_t
+{
+    cutf_encoding_t encoding; // Encoding of the string being iterated over
+    size_t size;              // Number of units in the string
+    size_t position;          // Offset of the next unit to decode
+    union
+    {
+        const char8_t *p8;
+        const char16_t *p16;
+        const char32_t *p32;
+    };
+};
+typedef struct cutf_iter_t cutf_iter_t;
+
+/**
+ * Create an iterator over the codepoints of a UTF-8 string. The string is not copied, so it must outlive the iterator.
+ *
+ * @param sz_in Number of UTF-8 units in the input.
+ * @param p_in Input UTF-8 string.
+ * @return Iterator positioned at the start of the string.
+ */
+static inline cutf_iter_t cutf_iter_utf8(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    return (cutf_iter_t){.encoding = CUTF_ENCODING_UTF8, .size = sz_in, .position = 0, .p8 = p_in};
+}
+
+/**
+ * Create an iterator over the codepoints of a UTF-16 string. The string is not copied, so it must outlive the
+ * iterator.
+ *
+ * @param sz_in Number of UTF-16 units in the input.
+ * @param p_in Input UTF-16 string.
+ * @return Iterator positioned at the start of the string.
+ */
+static inline cutf_iter_t cutf_iter_utf16(const size_t sz_in, const char16_t p_in[const static sz_in])
+{
+    return (cutf_iter_t){.encoding = CUTF_ENCODING_UTF16, .size = sz_in, .position = 0, .p16 = p_in};
+}
+
+/**
+ * Create an iterator over the codepoints of a UTF-32 string. The string is not copied, so it must outlive the
+ * iterator.
+ *
+ * @param sz_in Number of UTF-32 units in the input.
+ * @param p_in Input UTF-32 string.
+ * @return Iterator positioned at the start of the string.
+ */
+static inline cutf_iter_t cutf_iter_utf32(const size_t sz_in, const char32_t p_in[const static sz_in])
+{
+    return (cutf_iter_t){.encoding = CUTF_ENCODING_UTF32, .size = sz_in, .position = 0, .p32 = p_in};
+}
+
+/**
+ * Check if the iterator reached the end of the string.
+ *
+ * @param iter Iterator to check.
+ * @return true if there are no more units left to decode.
+ */
+static inline bool cutf_iter_done(const cutf_iter_t *const iter)
+{
+    return iter->position >= iter->size;
+}
+
+/**
+ * Decode the next codepoint of the string and advance the iterator past it. When an error is returned, the iterator
+ * is not advanced.
+ *
+ * @param iter Iterator to advance.
+ * @param p_codepoint Pointer which receives the decoded codepoint.
+ * @param p_span Pointer which receives the span of units the codepoint was encoded with. May be NULL.
+ * @return CUTF_SUCCESS if successful, CUTF_INCOMPLETE_INPUT if the string ends in the middle of a codepoint or the
+ *         iterator is already at the end, or CUTF_INVALID_INPUT if the string is not correctly encoded.
+ */
+static inline cutf_result_t cutf_iter_next(cutf_iter_t *const iter, char32_t *const p_codepoint,
+                                           cutf_span_t *const p_span)
+{
+    if (cutf_iter_done(iter))
+        return CUTF_INCOMPLETE_INPUT;
+
+    const size_t remaining = iter->size - iter->position;
+    size_t consumed;
+    cutf_result_t res;
+    switch (iter->encoding)
+    {
+    case CUTF_ENCODING_UTF8:
+        res = cutf_inline_utf8_decode(remaining, iter->p8 + iter->position, &consumed, p_codepoint);
+        break;
+
+    case CUTF_ENCODING_UTF16:
+        res = cutf_inline_utf16_decode(remaining, iter->p16 + iter->position, &consumed, p_codepoint);
+        break;
+
+    case CUTF_ENCODING_UTF32:
+        consumed = 1;
+        *p_codepoint = iter->p32[iter->position];
+        res = cutf_inline_is_valid_codepoint(*p_codepoint) ? CUTF_SUCCESS : CUTF_INVALID_INPUT;
+        break;
+
+    default:
+        return CUTF_INVALID_INPUT;
+    }
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    if (p_span)
+        *p_span = (cutf_span_t){.start = iter->position, .length = consumed};
+    iter->position += consumed;
+    return CUTF_SUCCESS;
+}
+
+/**
+ * Decode multiple codepoints of the string at once and advance the iterator past them. This is faster than calling
+ * ``cutf_iter_next`` repeatedly, when the positions of individual codepoints are not needed.
+ *
+ * @param iter Iterator to advance.
+ * @param sz_out Size of the output array.
+ * @param p_out Array which receives the decoded codepoints.
+ * @param p_written Pointer which receives the number of codepoints written.
+ * @return CUTF_SUCCESS if the output array was filled or the end of the string was reached, otherwise an error code,
+ *         which are the same as for ``cutf_iter_next``. When an error is returned, the iterator is positioned at the
+ *         codepoint which caused it.
+ */
+cutf_result_t cutf_iter_next_block(cutf_iter_t *iter, size_t sz_out, char32_t p_out[sz_out], size_t *p_written);
+
+/**
+ * Find the next extended grapheme cluster of the string, as defined by UAX #29, and advance the iterator past it. These
+ * are what users perceive as single characters, such as a letter with combining accents, a flag made of two regional
+ * indicators, or an emoji sequence joined by zero width joiners. A cluster ends before units which can not be decoded,
+ * and the error is returned by the next call.
+ *
+ * @param iter Iterator to advance.
+ * @param p_span Pointer which receives the span of units of the cluster. May be NULL.
+ * @return CUTF_SUCCESS if successful, otherwise an error code, which are the same as for ``cutf_iter_next``. When an
+ *         error is returned, the iterator is not advanced.
+ */
+cutf_result_t cutf_iter_next_grapheme(cutf_iter_t *iter, cutf_span_t *p_span);
+
+/**
+ * Advance the iterator past a number of extended grapheme clusters, for example to move a cursor or to truncate a
+ * string. Runs of ASCII characters are skipped a block at a time. Passing SIZE_MAX as count counts the clusters in the
+ * rest of the string.
+ *
+ * @param iter Iterator to advance.
+ * @param count Number of clusters to skip.
+ * @param p_skipped Pointer which receives the number of clusters skipped.
+ * @return CUTF_SUCCESS if the clusters were skipped or the end of the string was reached, otherwise an error code,
+ *         which are the same as for ``cutf_iter_next``. When an error is returned, the iterator is positioned at the
+ *         codepoint which caused it.
+ */
+cutf_result_t cutf_iter_skip_graphemes(cutf_iter_t *iter, size_t count, size_t *p_skipped);
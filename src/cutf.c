@@ -1,7 +1,14 @@
 #include "../include/cutf.h"
+#include "../include/cutf_inline.h"
+#include "cutf_tables.h"
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
 
 typedef struct
 {
@@ -16,11 +23,6 @@ typedef enum
     UNICODE_INVALID_END = 0xDFFF,   // end of the invalid region
 } unicode_limits_t;
 
-static bool is_valid_unicode_codepoint(const char32_t c)
-{
-    return (c > UNICODE_MAX_VALUE || (c >= UNICODE_INVALID_START && c <= UNICODE_INVALID_END)) == 0;
-}
-
 typedef enum
 {
     UTF8_PREFIX_CONTINUATION = 0x80,
@@ -40,36 +42,154 @@ typedef enum
     MASK_BOTTOM_10_BITS = 0x3FF,
 } bit_masks_t;
 
-static cutf_state_type_t utf8_classify_leading_byte(const char8_t c8)
+// Helpers for processing eight UTF-8 units at the same time using 64-bit integer arithmetic (SWAR). This keeps the
+// code portable, while still allowing compilers to vectorize it even further.
+static constexpr size_t SWAR_BLOCK = sizeof(uint64_t);
+static constexpr uint64_t SWAR_LOW_BITS = 0x0101010101010101;
+static constexpr uint64_t SWAR_HIGH_BITS = 0x8080808080808080;
+
+static uint64_t swar_load(const char8_t p_in[static SWAR_BLOCK])
 {
+    uint64_t v;
+    memcpy(&v, p_in, sizeof(v));
+    return v;
+}
 
-    // We are dealing with a single unit.
-    if (c8 < UTF8_PREFIX_CONTINUATION)
-    {
-        return CUTF_STATE_CLEAR;
-    }
-    // Was it a surrogate codepoint?
-    if (c8 < UTF8_PREFIX_TWO_UNITS)
-    {
-        return CUTF_STATE_ERROR;
-    }
-    // We are dealing with 2 units.
-    if (c8 < UTF8_PREFIX_THREE_UNITS)
-    {
-        return CUTF_STATE_U8_1;
-    }
-    // We are dealing with 3 units
-    if (c8 < UTF8_PREFIX_FOUR_UNITS)
-    {
-        return CUTF_STATE_U8_2;
-    }
-    // we are dealing with 4 units
-    if (c8 < 0xF8)
+// Count the number of bytes which have their highest bit set, assuming no other bits are set.
+static unsigned swar_count_marked(const uint64_t marked)
+{
+    return (unsigned)(((marked >> 7) * SWAR_LOW_BITS) >> 56);
+}
+
+// Marks UTF-8 continuation units (10xxxxxx) by setting the highest bit of the byte.
+static uint64_t swar_mark_continuations(const uint64_t v)
+{
+    return v & ~(v << 1) & SWAR_HIGH_BITS;
+}
+
+// Marks bytes which are zero by setting their highest bit.
+static uint64_t swar_mark_zero(const uint64_t v)
+{
+    constexpr uint64_t low_bits = ~SWAR_HIGH_BITS;
+    return ~(((v & low_bits) + low_bits) | v) & SWAR_HIGH_BITS;
+}
+
+// Marks leading units of four unit UTF-8 sequences (11110xxx) by setting the highest bit of the byte.
+static uint64_t swar_mark_four_unit_leads(const uint64_t v)
+{
+    return v & (v << 1) & (v << 2) & (v << 3) & SWAR_HIGH_BITS;
+}
+
+// Marks bytes which are lower than the value given, which must not be greater than 0x80. Not exact for each byte, but
+// exact in determining whether any byte is marked.
+static uint64_t swar_mark_less_than(const uint64_t v, const char8_t value)
+{
+    return (v - SWAR_LOW_BITS * value) & ~v & SWAR_HIGH_BITS;
+}
+
+// Marks bytes which are lower than the value given, which must not be greater than 0x80, exactly for each byte. The
+// bytes must all be ASCII.
+static uint64_t swar_mark_ascii_less_than(const uint64_t v, const char8_t value)
+{
+    return ~((v | SWAR_HIGH_BITS) - SWAR_LOW_BITS * value) & SWAR_HIGH_BITS;
+}
+
+// Helpers for processing four UTF-16 units at the same time, similar to the UTF-8 ones.
+static constexpr size_t SWAR_BLOCK_16 = sizeof(uint64_t) / sizeof(char16_t);
+static constexpr uint64_t SWAR_LOW_BITS_16 = 0x0001000100010001;
+static constexpr uint64_t SWAR_HIGH_BITS_16 = 0x8000800080008000;
+static constexpr uint64_t SWAR_NON_ASCII_16 = 0xFF80FF80FF80FF80;
+
+static uint64_t swar_load_16(const char16_t p_in[static SWAR_BLOCK_16])
+{
+    uint64_t v;
+    memcpy(&v, p_in, sizeof(v));
+    return v;
+}
+
+// Count the number of UTF-16 units which have their highest bit set, assuming no other bits are set.
+static unsigned swar_count_marked_16(const uint64_t marked)
+{
+    return (unsigned)(((marked >> 15) * SWAR_LOW_BITS_16) >> 48);
+}
+
+// Marks UTF-16 low surrogates (0xDC00 to 0xDFFF) by setting the highest bit of the unit.
+static uint64_t swar_mark_low_surrogates_16(const uint64_t v)
+{
+    constexpr uint64_t low_bits = ~SWAR_HIGH_BITS_16;
+    auto const x = (v & 0xFC00FC00FC00FC00) ^ 0xDC00DC00DC00DC00;
+    return ~(((x & low_bits) + low_bits) | x) & SWAR_HIGH_BITS_16;
+}
+
+// Marks UTF-16 units which are zero by setting the highest bit of the unit.
+static uint64_t swar_mark_zero_16(const uint64_t v)
+{
+    constexpr uint64_t low_bits = ~SWAR_HIGH_BITS_16;
+    return ~(((v & low_bits) + low_bits) | v) & SWAR_HIGH_BITS_16;
+}
+
+// Checks if any of the UTF-16 units is a surrogate (0xD800 to 0xDFFF), by looking for a zero after masking and
+// comparing the top five bits of each unit.
+static bool swar_has_surrogate_16(const uint64_t v)
+{
+    auto const x = (v & 0xF800F800F800F800) ^ 0xD800D800D800D800;
+    return ((x - SWAR_LOW_BITS_16) & ~x & SWAR_HIGH_BITS_16) != 0;
+}
+
+// Counters of the conversion functions, which compile to nothing unless the library is built with CUTF_ENABLE_STATS.
+#if defined(CUTF_ENABLE_STATS)
+static thread_local cutf_counters_t counters;
+#    define COUNT(field, n) ((void)(counters.field += (n)))
+#else
+#    define COUNT(field, n) ((void)0)
+#endif
+
+cutf_counters_t cutf_stats_snapshot(void)
+{
+#if defined(CUTF_ENABLE_STATS)
+    return counters;
+#else
+    return (cutf_counters_t){0};
+#endif
+}
+
+void cutf_stats_reset(void)
+{
+#if defined(CUTF_ENABLE_STATS)
+    counters = (cutf_counters_t){0};
+#endif
+}
+
+// Count a call to a conversion function, before it starts.
+static void count_call(const cutf_state_t *const state)
+{
+    COUNT(calls, 1);
+    COUNT(restarts, state->state_type != CUTF_STATE_CLEAR);
+    (void)state;
+}
+
+// Count the result of a call to a conversion function, which is passed through.
+static cutf_result_t count_result(const cutf_result_t res, const size_t *const p_consumed, const size_t sz_unit_in,
+                                  const size_t *const p_written, const size_t sz_unit_out)
+{
+#if defined(CUTF_ENABLE_STATS)
+    if (res == CUTF_INCOMPLETE_INPUT)
+        COUNT(incomplete_input, 1);
+    else if (res == CUTF_INSUFFICIENT_BUFFER)
+        COUNT(insufficient_buffer, 1);
+    else if (res == CUTF_INVALID_INPUT)
+        COUNT(invalid_input, 1);
+
+    // The units converted are not given on invalid input
+    if (res != CUTF_INVALID_INPUT)
     {
-        return CUTF_STATE_U8_3;
+        COUNT(bytes_in, *p_consumed * sz_unit_in);
+        COUNT(bytes_out, *p_written * sz_unit_out);
     }
-    // Invalid
-    return CUTF_STATE_ERROR;
+#else
+    (void)p_consumed, (void)sz_unit_in, (void)p_written, (void)sz_unit_out;
+#endif
+    return res;
 }
 
 static cutf_state_t utf8_extract_leading_byte(const char8_t c8)
@@ -103,7 +223,15 @@ static cutf_state_t utf8_extract_leading_byte(const char8_t c8)
     return (cutf_state_t){.state_type = CUTF_STATE_ERROR};
 }
 
-static cutf_state_t update_utf8_state_adding(const char8_t c, const cutf_state_t state)
+// Sequences which are rejected in standard UTF-8, but which the variants of it allow.
+typedef enum
+{
+    UTF8_ALLOW_NONE = 0,
+    UTF8_ALLOW_SURROGATES = 1 << 0,    // Surrogates encoded as three units
+    UTF8_ALLOW_OVERLONG_NULL = 1 << 1, // U+0000 encoded as two units
+} utf8_allow_t;
+
+static cutf_state_t update_utf8_state_adding(const char8_t c, const cutf_state_t state, const utf8_allow_t allow)
 {
     assert(state.state_type == CUTF_STATE_CLEAR || state.state_type == CUTF_STATE_U8_1 ||
            state.state_type == CUTF_STATE_U8_2 || state.state_type == CUTF_STATE_U8_3);
@@ -138,7 +266,30 @@ static cutf_state_t update_utf8_state_adding(const char8_t c, const cutf_state_t
         return (cutf_state_t){.state_type = CUTF_STATE_ERROR};
     }
 
-    return (cutf_state_t){.state_type = new_type, .value = (state.value << 6) | (c & MASK_BOTTOM_6_BITS)};
+    // Overlong encodings, surrogates and values above U+10FFFF are known once the first continuation unit is added,
+    // as the values of longer sequences are always above the ranges checked for shorter ones
+    auto const value = (state.value << 6) | (c & MASK_BOTTOM_6_BITS);
+    bool invalid;
+    switch (state.state_type)
+    {
+    case CUTF_STATE_U8_3:
+        invalid = value < (UTF8_MAX_THREE_UNITS >> 12) || value > (UNICODE_MAX_VALUE >> 12);
+        break;
+
+    case CUTF_STATE_U8_2:
+        invalid = value < (UTF8_MAX_TWO_UNITS >> 6) ||
+                  ((allow & UTF8_ALLOW_SURROGATES) == 0 && value >= (UNICODE_INVALID_START >> 6) &&
+                   value <= (UNICODE_INVALID_END >> 6));
+        break;
+
+    default:
+        invalid = value < UTF8_PREFIX_CONTINUATION && (value != 0 || (allow & UTF8_ALLOW_OVERLONG_NULL) == 0);
+        break;
+    }
+    if (invalid)
+        return (cutf_state_t){.state_type = CUTF_STATE_ERROR};
+
+    return (cutf_state_t){.state_type = new_type, .value = value};
 }
 
 typedef enum
@@ -159,7 +310,7 @@ static cutf_state_t utf16_extract_leading_unit(const char16_t c)
         return (cutf_state_t){.state_type = CUTF_STATE_CLEAR, .value = c};
     }
     // Is it the high surrogate (since it comes first)?
-    if (c < UTF16_SURROGATE_HIGH_END && c >= UTF16_SURROGATE_HIGH_START)
+    if (c <= UTF16_SURROGATE_HIGH_END && c >= UTF16_SURROGATE_HIGH_START)
     {
         return (cutf_state_t){.state_type = CUTF_STATE_U16_1, .value = MASK_BOTTOM_10_BITS & c};
     }
@@ -205,7 +356,7 @@ static remove_result_utf8_t update_utf8_state_removing(const cutf_state_t state,
     if (state.state_type == CUTF_STATE_CLEAR)
     {
         // Check for valid Unicode codepoint
-        if (!is_valid_unicode_codepoint(c))
+        if (!cutf_inline_is_valid_codepoint(c))
             return (remove_result_utf8_t){.state = {.state_type = CUTF_STATE_ERROR}};
 
         // Initialize the state
@@ -294,7 +445,7 @@ static remove_result_utf16_t update_utf16_state_removing(const cutf_state_t stat
     {
         // Initialize the state
         // Check for valid Unicode codepoint
-        if (!is_valid_unicode_codepoint(c))
+        if (!cutf_inline_is_valid_codepoint(c))
             return (remove_result_utf16_t){.state = {.state_type = CUTF_STATE_ERROR}};
 
         // Does it fit in the single unit?
@@ -320,9 +471,18 @@ static remove_result_utf16_t update_utf16_state_removing(const cutf_state_t stat
     return (remove_result_utf16_t){.state = {.state_type = CUTF_STATE_CLEAR}, .out = out};
 }
 
-static codepoint_return_t utf8_read_in_codepoint(const size_t sz_in, const char8_t p_in[static sz_in],
-                                                 cutf_state_t state)
+static codepoint_return_t utf8_read_in_codepoint_allowing(const size_t sz_in, const char8_t p_in[static sz_in],
+                                                          cutf_state_t state, const utf8_allow_t allow)
 {
+    // Complete valid codepoints are decoded directly, the state handles codepoints split between calls and errors
+    if (state.state_type == CUTF_STATE_CLEAR && sz_in != 0)
+    {
+        size_t consumed;
+        char32_t c;
+        if (cutf_inline_utf8_decode(sz_in, p_in, &consumed, &c) == CUTF_SUCCESS)
+            return (codepoint_return_t){.state = {.state_type = CUTF_STATE_CLEAR, .value = c}, .consumed = consumed};
+    }
+
     size_t i = 0;
     while (i < sz_in)
     {
@@ -330,7 +490,7 @@ static codepoint_return_t utf8_read_in_codepoint(const size_t sz_in, const char8
         i += 1;
 
         // Update the state type
-        auto const new_state = update_utf8_state_adding(c, state);
+        auto const new_state = update_utf8_state_adding(c, state, allow);
         if (new_state.state_type == CUTF_STATE_ERROR)
         {
             return (codepoint_return_t){.state = {.state_type = CUTF_STATE_ERROR}};
@@ -345,9 +505,27 @@ static codepoint_return_t utf8_read_in_codepoint(const size_t sz_in, const char8
     return (codepoint_return_t){.state = state, .consumed = i};
 }
 
+static codepoint_return_t utf8_read_in_codepoint(const size_t sz_in, const char8_t p_in[static sz_in],
+                                                 const cutf_state_t state)
+{
+    return utf8_read_in_codepoint_allowing(sz_in, p_in, state, UTF8_ALLOW_NONE);
+}
+
 static codepoint_return_t utf16_read_in_codepoint(const size_t sz_in, const char16_t p_in[static sz_in],
                                                   cutf_state_t state)
 {
+    // Complete valid codepoints are decoded directly, the state handles codepoints split between calls and errors
+    if (state.state_type == CUTF_STATE_CLEAR && sz_in != 0)
+    {
+        size_t consumed;
+        char32_t c;
+        auto const res = cutf_inline_utf16_decode(sz_in, p_in, &consumed, &c);
+        if (res == CUTF_SUCCESS)
+            return (codepoint_return_t){.state = {.state_type = CUTF_STATE_CLEAR, .value = c}, .consumed = consumed};
+        if (res == CUTF_INVALID_INPUT)
+            return (codepoint_return_t){.state = {.state_type = CUTF_STATE_ERROR}};
+    }
+
     size_t i = 0;
     while (i < sz_in)
     {
@@ -416,25 +594,127 @@ static codepoint_return_t utf8_write_out_codepoint(const size_t sz_out, char8_t
     return (codepoint_return_t){.state = state, .consumed = i};
 }
 
-cutf_result_t cutf_s8tos32(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
-                           size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
-                           cutf_state_t *const state)
+bool cutf_state_is_clean(const cutf_state_t state)
+{
+    return state.state_type == CUTF_STATE_CLEAR;
+}
+
+// Add a codepoint to the statistics.
+static void stats_add(cutf_stats_t *const stats, const char32_t c)
+{
+    stats->codepoints += 1;
+    if (c > stats->max_codepoint)
+        stats->max_codepoint = c;
+    stats->is_ascii = stats->is_ascii && c < UTF8_PREFIX_CONTINUATION;
+    // Carriage return followed by line feed is a single line terminator
+    if (cutf_is_line_terminator(c) && !(c == U'\n' && stats->last == U'\r'))
+        stats->lines += 1;
+    stats->last = c;
+}
+
+// Check if a block of UTF-8 units can be added to the statistics at once, which needs them to be ASCII and not
+// contain any line terminators.
+static bool stats_can_add_block(const uint64_t block)
+{
+    return ((block & SWAR_HIGH_BITS) | swar_mark_less_than(block, U'\r' + 1)) == 0;
+}
+
+// Add a block of UTF-8 units, for which ``stats_can_add_block`` is true, to the statistics.
+static void stats_add_block(cutf_stats_t *const stats, const char8_t p_in[static SWAR_BLOCK])
+{
+    stats->codepoints += SWAR_BLOCK;
+    for (size_t i = 0; i < SWAR_BLOCK; ++i)
+    {
+        if (p_in[i] > stats->max_codepoint)
+            stats->max_codepoint = p_in[i];
+    }
+    stats->last = p_in[SWAR_BLOCK - 1];
+}
+
+// Distance in bytes at which the input is prefetched when streaming the output.
+static constexpr size_t STREAMING_PREFETCH_DISTANCE = 512;
+
+// Store a single UTF-32 unit, bypassing the cache when streaming.
+static void store_s32(char32_t *const p_out, const char32_t value, const bool streaming)
+{
+#if defined(__SSE2__)
+    if (streaming)
+    {
+        _mm_stream_si32((int *)p_out, (int)value);
+        return;
+    }
+#endif
+    (void)streaming;
+    *p_out = value;
+}
+
+// Widen a block of ASCII UTF-8 units to UTF-32.
+static void widen_ascii_block_s8tos32(const char8_t p_in[static SWAR_BLOCK], char32_t p_out[static SWAR_BLOCK],
+                                      const bool streaming)
+{
+#if defined(__SSE2__)
+    // Full 16 byte non-temporal stores need an aligned destination
+    if (streaming && (uintptr_t)p_out % sizeof(__m128i) == 0)
+    {
+        auto const zero = _mm_setzero_si128();
+        auto const units16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p_in), zero);
+        _mm_stream_si128((__m128i *)p_out, _mm_unpacklo_epi16(units16, zero));
+        _mm_stream_si128((__m128i *)(p_out + 4), _mm_unpackhi_epi16(units16, zero));
+        return;
+    }
+#endif
+    for (size_t i = 0; i < SWAR_BLOCK; ++i)
+        store_s32(p_out + i, p_in[i], streaming);
+}
+
+static cutf_result_t s8tos32(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                             size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                             const bool streaming, cutf_stats_t *const stats, cutf_state_t *const state)
 {
     size_t pos_in, pos_out;
+    bool invalid = false;
     for (pos_in = 0, pos_out = 0; pos_in < sz_in && pos_out < sz_out;)
     {
+#if defined(__GNUC__)
+        // Prefetch the input once per cache line, ahead of where it is needed
+        if (streaming && pos_in % 64 < SWAR_BLOCK && sz_in - pos_in > STREAMING_PREFETCH_DISTANCE)
+            __builtin_prefetch(p_in + pos_in + STREAMING_PREFETCH_DISTANCE);
+#endif
+
+        // Widen whole blocks of ASCII units at once
+        if (state->state_type == CUTF_STATE_CLEAR && sz_in - pos_in >= SWAR_BLOCK && sz_out - pos_out >= SWAR_BLOCK)
+        {
+            auto const block = swar_load(p_in + pos_in);
+            if (stats == nullptr ? (block & SWAR_HIGH_BITS) == 0 : stats_can_add_block(block))
+            {
+                widen_ascii_block_s8tos32(p_in + pos_in, p_out + pos_out, streaming);
+                COUNT(fast_blocks, 1);
+                if (stats != nullptr)
+                    stats_add_block(stats, p_in + pos_in);
+                pos_in += SWAR_BLOCK;
+                pos_out += SWAR_BLOCK;
+                continue;
+            }
+        }
+
         auto const res = utf8_read_in_codepoint(sz_in - pos_in, p_in + pos_in, *state);
         if (res.state.state_type == CUTF_STATE_ERROR)
-            return CUTF_INVALID_INPUT;
+        {
+            invalid = true;
+            break;
+        }
         pos_in += res.consumed;
 
         // Update the value accumulated thus far
         if (res.state.state_type == CUTF_STATE_CLEAR)
         {
             // We are done with parsing
-            p_out[pos_out] = res.state.value;
-            // Clear the context value as well
-            state->value = 0;
+            store_s32(p_out + pos_out, res.state.value, streaming);
+            COUNT(slow_codepoints, 1);
+            if (stats != nullptr)
+                stats_add(stats, res.state.value);
+            // Clear the context as well, since it may have held the start of this codepoint
+            *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
             pos_out += 1;
         }
         else
@@ -443,6 +723,16 @@ cutf_result_t cutf_s8tos32(const size_t sz_in, const char8_t p_in[const static s
             break;
         }
     }
+
+#if defined(__SSE2__)
+    // Non-temporal stores are weakly ordered, so make them visible before returning
+    if (streaming)
+        _mm_sfence();
+#endif
+
+    if (invalid)
+        return CUTF_INVALID_INPUT;
+
     *p_consumed = pos_in;
     *p_written = pos_out;
 
@@ -458,9 +748,47 @@ cutf_result_t cutf_s8tos32(const size_t sz_in, const char8_t p_in[const static s
     return CUTF_SUCCESS;
 }
 
-cutf_result_t cutf_s32tos8(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
-                           size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+// Decide whether to stream the output of a UTF-8 to UTF-32 conversion.
+static bool s8tos32_streaming(const size_t sz_in, const size_t sz_out, const cutf_store_mode_t mode)
+{
+    if (mode != CUTF_STORE_AUTO)
+        return mode == CUTF_STORE_STREAMING;
+
+    // At most one UTF-32 unit is written for each UTF-8 unit
+    auto const max_written = sz_in < sz_out ? sz_in : sz_out;
+    return max_written > CUTF_STREAMING_THRESHOLD / sizeof(char32_t);
+}
+
+cutf_result_t cutf_s8tos32_store(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                 size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                                 const cutf_store_mode_t mode, cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s8tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, s8tos32_streaming(sz_in, sz_out, mode),
+                             nullptr, state);
+    return count_result(res, p_consumed, sizeof(char8_t), p_written, sizeof(char32_t));
+}
+
+cutf_result_t cutf_s8tos32_stats(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                 size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                                 cutf_stats_t *const stats, cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s8tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written,
+                             s8tos32_streaming(sz_in, sz_out, CUTF_STORE_AUTO), stats, state);
+    return count_result(res, p_consumed, sizeof(char8_t), p_written, sizeof(char32_t));
+}
+
+cutf_result_t cutf_s8tos32(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
                            cutf_state_t *const state)
+{
+    return cutf_s8tos32_store(sz_in, p_in, sz_out, p_consumed, p_out, p_written, CUTF_STORE_AUTO, state);
+}
+
+static cutf_result_t s32tos8(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
+                             size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                             cutf_state_t *const state)
 {
     size_t pos_out, pos_in;
     for (pos_out = 0, pos_in = 0; pos_out < sz_out; ++pos_out)
@@ -480,6 +808,7 @@ cutf_result_t cutf_s32tos8(const size_t sz_in, const char32_t p_in[const static
                 break;
             }
             auto const c = p_in[pos_in];
+            COUNT(slow_codepoints, 1);
             res = update_utf8_state_removing(*state, c);
             pos_in += (res.state.state_type != CUTF_STATE_ERROR);
         }
@@ -503,6 +832,15 @@ cutf_result_t cutf_s32tos8(const size_t sz_in, const char32_t p_in[const static
     return CUTF_SUCCESS;
 }
 
+cutf_result_t cutf_s32tos8(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                           cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s32tos8(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    return count_result(res, p_consumed, sizeof(char32_t), p_written, sizeof(char8_t));
+}
+
 size_t cutf_count_s8asc32_complete(const size_t sz_in, const char8_t p_in[const static sz_in])
 {
     size_t completed = 0;
@@ -530,7 +868,12 @@ size_t cutf_count_s8asc32_complete(const size_t sz_in, const char8_t p_in[const
     //         i += 4;
     //     }
     // }
-    for (unsigned i = 0; i < sz_in; ++i)
+    size_t i = 0;
+    for (; i + SWAR_BLOCK <= sz_in; i += SWAR_BLOCK)
+    {
+        completed += SWAR_BLOCK - swar_count_marked(swar_mark_continuations(swar_load(p_in + i)));
+    }
+    for (; i < sz_in; ++i)
     {
         // Just increment if we do not have a continuation prefix, duh!
         completed += ((p_in[i] & 0xC0) != UTF8_PREFIX_CONTINUATION);
@@ -539,49 +882,79 @@ size_t cutf_count_s8asc32_complete(const size_t sz_in, const char8_t p_in[const
     return completed;
 }
 
-static bool check_utf8_continuation_unit(char8_t const c)
+cutf_result_t cutf_utf8_next_codepoint(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                       size_t *const p_consumed)
 {
-    return (c & 0xC0) == UTF8_PREFIX_CONTINUATION;
+    return cutf_inline_utf8_next_codepoint(sz_in, p_in, p_consumed);
 }
 
-cutf_result_t cutf_utf8_next_codepoint(const size_t sz_in, const char8_t p_in[const static sz_in],
+cutf_result_t cutf_utf8_prev_codepoint(const size_t sz_in, const char8_t p_in[const static sz_in],
                                        size_t *const p_consumed)
 {
-    size_t needed_continuations;
-    switch (utf8_classify_leading_byte(p_in[0]))
+    if (sz_in == 0)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Step back over at most three continuation units to the leading unit
+    size_t start = sz_in - 1;
+    while (start > 0 && sz_in - start < 4 && cutf_inline_utf8_is_continuation(p_in[start]))
     {
-    case CUTF_STATE_U8_3:
-        needed_continuations = 3;
-        break;
+        start -= 1;
+    }
+    if (cutf_inline_utf8_is_continuation(p_in[start]))
+        return sz_in - start < 4 ? CUTF_INCOMPLETE_INPUT : CUTF_INVALID_INPUT;
 
-    case CUTF_STATE_U8_2:
-        needed_continuations = 2;
-        break;
+    // The leading unit must be followed by exactly the units which were stepped over
+    size_t consumed;
+    auto const res = cutf_inline_utf8_next_codepoint(sz_in - start, p_in + start, &consumed);
+    if (res != CUTF_SUCCESS)
+        return res;
+    if (consumed != sz_in - start)
+        return CUTF_INVALID_INPUT;
 
-    case CUTF_STATE_U8_1:
-        needed_continuations = 1;
-        break;
+    *p_consumed = consumed;
+    return CUTF_SUCCESS;
+}
 
-    case CUTF_STATE_CLEAR:
-        needed_continuations = 0;
-        break;
+size_t cutf_utf8_snap_boundary(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t offset)
+{
+    if (offset >= sz_in)
+        return sz_in;
 
-    default:
-        return CUTF_INVALID_INPUT;
+    size_t boundary = offset;
+    while (boundary > 0 && offset - boundary < 3 && cutf_inline_utf8_is_continuation(p_in[boundary]))
+    {
+        boundary -= 1;
     }
 
-    if (needed_continuations + 1 > sz_in)
-        return CUTF_INCOMPLETE_INPUT;
+    return cutf_inline_utf8_is_continuation(p_in[boundary]) ? offset : boundary;
+}
 
-    for (unsigned j = 0; j < needed_continuations; ++j)
+cutf_result_t cutf_utf8_seek_back(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t count,
+                                  size_t *const p_offset)
+{
+    size_t pos = sz_in, remaining = count;
+    while (remaining > 0)
     {
-        if (!check_utf8_continuation_unit(p_in[j + 1]))
+        // Skip whole blocks which have fewer leading units than there are codepoints left to move back by
+        if (pos >= SWAR_BLOCK)
         {
-            return CUTF_INVALID_INPUT;
+            auto const continuations = swar_mark_continuations(swar_load(p_in + pos - SWAR_BLOCK));
+            auto const leads = SWAR_BLOCK - swar_count_marked(continuations);
+            if (leads < remaining)
+            {
+                pos -= SWAR_BLOCK;
+                remaining -= leads;
+                continue;
+            }
         }
+
+        if (pos == 0)
+            return CUTF_INCOMPLETE_INPUT;
+        pos -= 1;
+        remaining -= !cutf_inline_utf8_is_continuation(p_in[pos]);
     }
 
-    *p_consumed = 1 + needed_continuations;
+    *p_offset = pos;
     return CUTF_SUCCESS;
 }
 
@@ -599,8 +972,10 @@ cutf_result_t cutf_count_s8asc32(const size_t sz_in, const char8_t p_in[const st
     cutf_result_t res = CUTF_SUCCESS;
     while (pos_in < sz_in)
     {
+        // Decoding also rejects overlong encodings, surrogates and values beyond U+10FFFF, which converting would
         size_t consumed;
-        res = cutf_utf8_next_codepoint(sz_in - pos_in, p_in + pos_in, &consumed);
+        char32_t c;
+        res = cutf_inline_utf8_decode(sz_in - pos_in, p_in + pos_in, &consumed, &c);
 
         if (res != CUTF_SUCCESS)
         {
@@ -615,71 +990,255 @@ cutf_result_t cutf_count_s8asc32(const size_t sz_in, const char8_t p_in[const st
     return res;
 }
 
-cutf_result_t cutf_c16toc32(const size_t sz_in, const char16_t p_in[const static sz_in], size_t *const p_consumed,
-                            char32_t *const p_out, cutf_state_t *const state)
+// Number of UTF-16 units needed for a codepoint which starts with the given UTF-8 unit.
+static size_t utf8_leading_byte_utf16_units(const char8_t c8)
 {
-    cutf_result_t res = CUTF_INCOMPLETE_INPUT;
-    size_t i;
-    // Keep going until we either run out of characters or conversion is no longer incomplete.
-    for (i = 0; i < sz_in; ++i)
+    switch (cutf_inline_utf8_classify_leading_byte(c8))
     {
-        auto const c = p_in[i];
+    case CUTF_STATE_U8_3:
+        // Needs a surrogate pair
+        return 2;
 
-        // Update the state type
-        auto const new_state = update_utf16_state_adding(c, *state);
-        if (new_state.state_type == CUTF_STATE_ERROR)
-            return CUTF_INVALID_INPUT;
+    case CUTF_STATE_ERROR:
+        // Continuation units do not start a new codepoint
+        return 0;
 
-        // Update the value accumulated thus far
-        *state = new_state;
-        if (new_state.state_type == CUTF_STATE_CLEAR)
-        {
-            // We are done with parsing
-            *p_out = new_state.value;
-            // Clear the context value as well
-            state->value = 0;
-            res = CUTF_SUCCESS;
-            i += 1;
-            break;
-        }
+    default:
+        return 1;
     }
-
-    *p_consumed = i;
-    return res;
 }
 
-cutf_result_t cutf_s16tos32(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
-                            size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
-                            cutf_state_t *const state)
+static size_t utf8_count_utf16_units(const size_t sz_in, const char8_t p_in[const static sz_in])
 {
-    size_t pos_in = 0, pos_out = 0;
-    while (pos_in < sz_in && pos_out < sz_out)
+    size_t pos = 0, units = 0;
+    for (; pos + SWAR_BLOCK <= sz_in; pos += SWAR_BLOCK)
     {
-        size_t consumed;
-        auto const res = cutf_c16toc32(sz_in - pos_in, p_in + pos_in, &consumed, p_out + pos_out, state);
-        if (res != CUTF_SUCCESS)
-        {
-            return res;
-        }
-        pos_in += consumed;
-        pos_out += 1;
+        auto const block = swar_load(p_in + pos);
+        // Each unit that is not a continuation starts a codepoint and four unit ones also need a surrogate pair
+        units += SWAR_BLOCK - swar_count_marked(swar_mark_continuations(block)) +
+                 swar_count_marked(swar_mark_four_unit_leads(block));
     }
-    *p_consumed = pos_in;
-    *p_written = pos_out;
-
-    // Check if we ran out of output buffer before the end of the input
-    if (pos_in != sz_in)
-        return CUTF_INSUFFICIENT_BUFFER;
-
-    // Nope, we finished it all!
-    return CUTF_SUCCESS;
+    for (; pos < sz_in; ++pos)
+    {
+        units += utf8_leading_byte_utf16_units(p_in[pos]);
+    }
+    return units;
 }
 
-cutf_result_t cutf_s32tos16(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
-                            size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
-                            cutf_state_t *const state)
+cutf_result_t cutf_count_s8asc16(const size_t sz_in, const char8_t p_in[const static sz_in], size_t *const valid_count,
+                                 size_t *const p_count)
 {
-    size_t pos_out, pos_in;
+    auto const res = cutf_is_utf8_valid(sz_in, p_in, valid_count);
+    *p_count = utf8_count_utf16_units(*valid_count, p_in);
+    return res;
+}
+
+// Advance the position in the UTF-8 string until the number of UTF-16 units before it reaches the target.
+static cutf_result_t utf8_seek_utf16_offset(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                            const size_t target, size_t *const p_pos, size_t *const p_units)
+{
+    size_t pos = *p_pos, units = *p_units;
+    // Skip over whole blocks as long as they do not reach the target
+    while (units < target && pos + SWAR_BLOCK <= sz_in)
+    {
+        auto const block = swar_load(p_in + pos);
+        auto const block_units = SWAR_BLOCK - swar_count_marked(swar_mark_continuations(block)) +
+                                 swar_count_marked(swar_mark_four_unit_leads(block));
+        if (units + block_units >= target)
+            break;
+        units += block_units;
+        pos += SWAR_BLOCK;
+    }
+    // Finish off one unit at a time
+    while (units < target && pos < sz_in)
+    {
+        units += utf8_leading_byte_utf16_units(p_in[pos]);
+        pos += 1;
+    }
+    // Skip the remaining continuation units of the last codepoint
+    while (pos < sz_in && cutf_inline_utf8_is_continuation(p_in[pos]))
+    {
+        pos += 1;
+    }
+
+    *p_pos = pos;
+    *p_units = units;
+
+    // Target is past the end of the input
+    if (units < target)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Target is in the middle of a surrogate pair
+    if (units > target)
+        return CUTF_INVALID_INPUT;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_utf16_offset_to_utf8(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                        const size_t offset16, size_t *const p_offset8)
+{
+    size_t converted;
+    return cutf_utf16_offsets_to_utf8(sz_in, p_in, 1, &offset16, p_offset8, &converted);
+}
+
+cutf_result_t cutf_utf8_offset_to_utf16(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                        const size_t offset8, size_t *const p_offset16)
+{
+    size_t converted;
+    return cutf_utf8_offsets_to_utf16(sz_in, p_in, 1, &offset8, p_offset16, &converted);
+}
+
+cutf_result_t cutf_utf16_offsets_to_utf8(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t count,
+                                         const size_t p_offsets16[const static count], size_t p_offsets8[const count],
+                                         size_t *const p_converted)
+{
+    size_t pos = 0, units = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        // Offsets must be sorted, since we only ever move forward
+        if (p_offsets16[i] < units)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        res = utf8_seek_utf16_offset(sz_in, p_in, p_offsets16[i], &pos, &units);
+        if (res != CUTF_SUCCESS)
+            break;
+
+        p_offsets8[i] = pos;
+    }
+
+    *p_converted = i;
+    return res;
+}
+
+cutf_result_t cutf_utf8_offsets_to_utf16(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t count,
+                                         const size_t p_offsets8[const static count], size_t p_offsets16[const count],
+                                         size_t *const p_converted)
+{
+    size_t pos = 0, units = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        auto const offset = p_offsets8[i];
+        // Offsets must be sorted, since we only ever move forward
+        if (offset < pos)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        if (offset > sz_in)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+
+        // Offset must not split a codepoint
+        if (offset != sz_in && cutf_inline_utf8_is_continuation(p_in[offset]))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        units += utf8_count_utf16_units(offset - pos, p_in + pos);
+        pos = offset;
+        p_offsets16[i] = units;
+    }
+
+    *p_converted = i;
+    return res;
+}
+
+cutf_result_t cutf_c16toc32(const size_t sz_in, const char16_t p_in[const static sz_in], size_t *const p_consumed,
+                            char32_t *const p_out, cutf_state_t *const state)
+{
+    cutf_result_t res = CUTF_INCOMPLETE_INPUT;
+    size_t i;
+    // Keep going until we either run out of characters or conversion is no longer incomplete.
+    for (i = 0; i < sz_in; ++i)
+    {
+        auto const c = p_in[i];
+
+        // Update the state type
+        auto const new_state = update_utf16_state_adding(c, *state);
+        if (new_state.state_type == CUTF_STATE_ERROR)
+            return CUTF_INVALID_INPUT;
+
+        // Update the value accumulated thus far
+        *state = new_state;
+        if (new_state.state_type == CUTF_STATE_CLEAR)
+        {
+            // We are done with parsing
+            *p_out = new_state.value;
+            // Clear the context value as well
+            state->value = 0;
+            res = CUTF_SUCCESS;
+            i += 1;
+            break;
+        }
+    }
+
+    *p_consumed = i;
+    return res;
+}
+
+static cutf_result_t s16tos32(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                              size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                              cutf_state_t *const state)
+{
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < sz_in && pos_out < sz_out)
+    {
+        size_t consumed;
+        auto const res = cutf_c16toc32(sz_in - pos_in, p_in + pos_in, &consumed, p_out + pos_out, state);
+        if (res == CUTF_INVALID_INPUT)
+        {
+            return res;
+        }
+        pos_in += consumed;
+        // Input ended with a high surrogate, which is now kept in the state
+        if (res == CUTF_INCOMPLETE_INPUT)
+        {
+            break;
+        }
+        pos_out += 1;
+        COUNT(slow_codepoints, 1);
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    // Check if we ran out of output buffer before the end of the input
+    if (pos_in != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    // We consumed all input but it was not complete
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Nope, we finished it all!
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_s16tos32(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                            cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s16tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    return count_result(res, p_consumed, sizeof(char16_t), p_written, sizeof(char32_t));
+}
+
+static cutf_result_t s32tos16(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
+                              size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                              cutf_state_t *const state)
+{
+    size_t pos_out, pos_in;
     for (pos_out = 0, pos_in = 0; pos_out < sz_out; ++pos_out)
     {
         // Advance the state
@@ -697,6 +1256,7 @@ cutf_result_t cutf_s32tos16(const size_t sz_in, const char32_t p_in[const static
                 break;
             }
             auto const c = p_in[pos_in];
+            COUNT(slow_codepoints, 1);
             res = update_utf16_state_removing(*state, c);
             pos_in += (res.state.state_type != CUTF_STATE_ERROR);
         }
@@ -722,6 +1282,232 @@ cutf_result_t cutf_s32tos16(const size_t sz_in, const char32_t p_in[const static
     return CUTF_SUCCESS;
 }
 
+cutf_result_t cutf_s32tos16(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                            cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s32tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    return count_result(res, p_consumed, sizeof(char32_t), p_written, sizeof(char16_t));
+}
+
+cutf_result_t cutf_utf16_prev_codepoint(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                        size_t *const p_consumed)
+{
+    if (sz_in == 0)
+        return CUTF_INCOMPLETE_INPUT;
+
+    auto const c = p_in[sz_in - 1];
+    if (cutf_inline_utf16_is_high_surrogate(c))
+        return CUTF_INCOMPLETE_INPUT;
+
+    if (!cutf_inline_utf16_is_low_surrogate(c))
+    {
+        *p_consumed = 1;
+        return CUTF_SUCCESS;
+    }
+
+    // Low surrogates must be preceded by a high surrogate
+    if (sz_in < 2)
+        return CUTF_INCOMPLETE_INPUT;
+    if (!cutf_inline_utf16_is_high_surrogate(p_in[sz_in - 2]))
+        return CUTF_INVALID_INPUT;
+
+    *p_consumed = 2;
+    return CUTF_SUCCESS;
+}
+
+size_t cutf_utf16_snap_boundary(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t offset)
+{
+    if (offset >= sz_in)
+        return sz_in;
+
+    if (offset > 0 && cutf_inline_utf16_is_low_surrogate(p_in[offset]) &&
+        cutf_inline_utf16_is_high_surrogate(p_in[offset - 1]))
+        return offset - 1;
+
+    return offset;
+}
+
+cutf_result_t cutf_utf16_seek_back(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t count,
+                                   size_t *const p_offset)
+{
+    size_t pos = sz_in, remaining = count;
+    while (remaining > 0)
+    {
+        // Skip whole blocks which have fewer leading units than there are codepoints left to move back by
+        if (pos >= SWAR_BLOCK_16)
+        {
+            auto const low_surrogates = swar_mark_low_surrogates_16(swar_load_16(p_in + pos - SWAR_BLOCK_16));
+            auto const leads = SWAR_BLOCK_16 - swar_count_marked_16(low_surrogates);
+            if (leads < remaining)
+            {
+                pos -= SWAR_BLOCK_16;
+                remaining -= leads;
+                continue;
+            }
+        }
+
+        if (pos == 0)
+            return CUTF_INCOMPLETE_INPUT;
+        pos -= 1;
+        remaining -= !cutf_inline_utf16_is_low_surrogate(p_in[pos]);
+    }
+
+    *p_offset = pos;
+    return CUTF_SUCCESS;
+}
+
+// Number of units checked per iteration of the block loops of the UTF-16 and UTF-32 validation (32 and 64 bytes).
+static constexpr size_t UTF16_CHECK_BLOCK = 4 * SWAR_BLOCK_16;
+static constexpr size_t UTF32_CHECK_BLOCK = 16;
+
+// Number of UTF-8 units needed to encode a valid codepoint.
+static size_t utf8_codepoint_units(const char32_t c)
+{
+    return 1 + (c >= UTF8_PREFIX_CONTINUATION) + (c >= UTF8_MAX_TWO_UNITS) + (c >= UTF8_MAX_THREE_UNITS);
+}
+
+cutf_result_t cutf_is_utf16_valid(const size_t sz_in, const char16_t p_in[const static sz_in], size_t *valid_count)
+{
+    size_t unused;
+    // This function works the same as ``cutf_count_s16asc32``, but not caring about the number of Unicode codepoints
+    return cutf_count_s16asc32(sz_in, p_in, valid_count, &unused);
+}
+
+cutf_result_t cutf_count_s16asc32(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                  size_t *const valid_count, size_t *const p_count)
+{
+    size_t pos_in = 0, pos_out = 0;
+    // Blocks containing surrogates are checked one codepoint at a time up to this position
+    size_t scalar_end = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        if (pos_in >= scalar_end && pos_in + UTF16_CHECK_BLOCK <= sz_in)
+        {
+            bool has_surrogates = false;
+            for (unsigned j = 0; j < UTF16_CHECK_BLOCK; j += SWAR_BLOCK_16)
+                has_surrogates |= swar_has_surrogate_16(swar_load_16(p_in + pos_in + j));
+
+            // Blocks without surrogates have one codepoint per unit
+            if (!has_surrogates)
+            {
+                pos_in += UTF16_CHECK_BLOCK;
+                pos_out += UTF16_CHECK_BLOCK;
+                continue;
+            }
+            scalar_end = pos_in + UTF16_CHECK_BLOCK;
+        }
+
+        auto const read =
+            utf16_read_in_codepoint(sz_in - pos_in, p_in + pos_in, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+        pos_in += read.consumed;
+        pos_out += 1;
+    }
+
+    *p_count = pos_out;
+    *valid_count = pos_in;
+    return res;
+}
+
+cutf_result_t cutf_count_s16asc8(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                 size_t *const valid_count, size_t *const p_count)
+{
+    size_t pos_in = 0, count = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        // Blocks of ASCII have one UTF-8 unit per UTF-16 unit
+        if (pos_in + SWAR_BLOCK_16 <= sz_in && (swar_load_16(p_in + pos_in) & SWAR_NON_ASCII_16) == 0)
+        {
+            pos_in += SWAR_BLOCK_16;
+            count += SWAR_BLOCK_16;
+            continue;
+        }
+
+        auto const read =
+            utf16_read_in_codepoint(sz_in - pos_in, p_in + pos_in, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+        pos_in += read.consumed;
+        count += utf8_codepoint_units(read.state.value);
+    }
+
+    *p_count = count;
+    *valid_count = pos_in;
+    return res;
+}
+
+cutf_result_t cutf_is_utf32_valid(const size_t sz_in, const char32_t p_in[const static sz_in], size_t *valid_count)
+{
+    size_t pos = 0;
+    // Check whole blocks without branching on each unit, so that the compiler is able to vectorize the loop
+    while (pos + UTF32_CHECK_BLOCK <= sz_in)
+    {
+        bool invalid = false;
+        for (unsigned j = 0; j < UTF32_CHECK_BLOCK; ++j)
+            invalid |= !cutf_inline_is_valid_codepoint(p_in[pos + j]);
+
+        if (invalid)
+            break;
+        pos += UTF32_CHECK_BLOCK;
+    }
+
+    // Find the exact position of the first invalid codepoint in what remains
+    while (pos < sz_in && cutf_inline_is_valid_codepoint(p_in[pos]))
+        pos += 1;
+
+    *valid_count = pos;
+    return pos == sz_in ? CUTF_SUCCESS : CUTF_INVALID_INPUT;
+}
+
+cutf_result_t cutf_count_s32asc8(const size_t sz_in, const char32_t p_in[const static sz_in],
+                                 size_t *const valid_count, size_t *const p_count)
+{
+    size_t pos = 0, count = 0;
+    for (; pos < sz_in && cutf_inline_is_valid_codepoint(p_in[pos]); ++pos)
+    {
+        count += utf8_codepoint_units(p_in[pos]);
+    }
+
+    *p_count = count;
+    *valid_count = pos;
+    return pos == sz_in ? CUTF_SUCCESS : CUTF_INVALID_INPUT;
+}
+
+cutf_result_t cutf_count_s32asc16(const size_t sz_in, const char32_t p_in[const static sz_in],
+                                  size_t *const valid_count, size_t *const p_count)
+{
+    size_t pos = 0, count = 0;
+    for (; pos < sz_in && cutf_inline_is_valid_codepoint(p_in[pos]); ++pos)
+    {
+        count += 1 + (p_in[pos] >= UTF16_SURROGATE_PAIR_START);
+    }
+
+    *p_count = count;
+    *valid_count = pos;
+    return pos == sz_in ? CUTF_SUCCESS : CUTF_INVALID_INPUT;
+}
+
 typedef enum
 {
     BOM_UTF16_NATIVE = 0xFEFF,
@@ -814,20 +1600,211 @@ void cutf_utf32_swap_endianness(const size_t sz_out, char32_t p_out[const sz_out
     }
 }
 
-cutf_result_t cutf_s8tos16(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
-                           size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
-                           cutf_state_t *const state)
+typedef enum
 {
-    size_t pos_out = 0, pos_in = 0;
-    if (state->state_type == CUTF_STATE_U8_1 || state->state_type == CUTF_STATE_U8_2 ||
-        state->state_type == CUTF_STATE_U8_3)
-    {
-        auto const res_read = utf8_read_in_codepoint(sz_in, p_in, *state);
-        if (res_read.state.state_type == CUTF_STATE_ERROR)
-            return CUTF_INVALID_INPUT;
+    DETECT_CHUNK = 256,          // Number of units copied out of the input at once, to read them aligned and swapped
+    DETECT_BOM_CONFIDENCE = 100, // Confidence in an encoding marked by a byte-order mark
+} detect_constants_t;
+
+// Units at the start of the input, read as UTF-16 or UTF-32 of either byte order.
+typedef struct
+{
+    bool valid;        // All units are correctly encoded, except possibly for an incomplete codepoint at the end
+    size_t units;      // Number of units read
+    size_t narrow;     // Units which are below 0x100, as most of ASCII and Latin-1 text is
+    size_t zero;       // Units which are zero
+    size_t surrogates; // UTF-16 surrogates, which are all paired in a valid sample
+} detect_sample_t;
+
+static detect_sample_t detect_sample_16(const size_t sz_in, const char8_t p_in[const static sz_in], const bool swap)
+{
+    detect_sample_t sample = {.valid = true, .units = sz_in / sizeof(char16_t)};
+    // One more unit holds a high surrogate carried over from the previous chunk
+    char16_t chunk[DETECT_CHUNK + 1];
+    size_t carried = 0;
+    for (size_t pos = 0; pos < sample.units && sample.valid;)
+    {
+        auto const n = sample.units - pos < DETECT_CHUNK ? sample.units - pos : (size_t)DETECT_CHUNK;
+        memcpy(chunk + carried, p_in + pos * sizeof(char16_t), n * sizeof(char16_t));
+        if (swap)
+            cutf_utf16_swap_endianness(n, chunk + carried, chunk + carried);
+
+        size_t i = carried;
+        for (; i + SWAR_BLOCK_16 <= carried + n; i += SWAR_BLOCK_16)
+        {
+            auto const v = swar_load_16(chunk + i);
+            sample.narrow += swar_count_marked_16(swar_mark_zero_16(v & 0xFF00FF00FF00FF00));
+            sample.zero += swar_count_marked_16(swar_mark_zero_16(v));
+            sample.surrogates +=
+                swar_count_marked_16(swar_mark_zero_16((v & 0xF800F800F800F800) ^ 0xD800D800D800D800));
+        }
+        for (; i < carried + n; ++i)
+        {
+            sample.narrow += chunk[i] < 0x100;
+            sample.zero += chunk[i] == 0;
+            sample.surrogates += (chunk[i] & 0xF800) == 0xD800;
+        }
+
+        size_t valid;
+        sample.valid = cutf_is_utf16_valid(carried + n, chunk, &valid) != CUTF_INVALID_INPUT;
+        // Anything not valid is a high surrogate at the end of the chunk
+        carried = carried + n - valid;
+        if (carried != 0)
+            chunk[0] = chunk[valid];
+        pos += n;
+    }
+    return sample;
+}
+
+static detect_sample_t detect_sample_32(const size_t sz_in, const char8_t p_in[const static sz_in], const bool swap)
+{
+    detect_sample_t sample = {.valid = true, .units = sz_in / sizeof(char32_t)};
+    char32_t chunk[DETECT_CHUNK];
+    for (size_t pos = 0; pos < sample.units && sample.valid;)
+    {
+        auto const n = sample.units - pos < DETECT_CHUNK ? sample.units - pos : (size_t)DETECT_CHUNK;
+        memcpy(chunk, p_in + pos * sizeof(char32_t), n * sizeof(char32_t));
+        if (swap)
+            cutf_utf32_swap_endianness(n, chunk, chunk);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            sample.narrow += chunk[i] < 0x100;
+            sample.zero += chunk[i] == 0;
+        }
+
+        size_t valid;
+        sample.valid = cutf_is_utf32_valid(n, chunk, &valid) == CUTF_SUCCESS;
+        pos += n;
+    }
+    return sample;
+}
+
+// Confidence in UTF-16, which is higher the more units look like ASCII or Latin-1 or are paired surrogates, but lower
+// for zero units, which are rare in text but common in UTF-32.
+static unsigned detect_confidence_16(const detect_sample_t sample)
+{
+    if (!sample.valid || sample.units == 0)
+        return 0;
+    auto const likely = sample.narrow - sample.zero + sample.surrogates;
+    return 40 + (unsigned)(55 * (likely > sample.zero ? likely - sample.zero : 0) / sample.units);
+}
+
+// Confidence in UTF-32, where valid units are rare unless it really is UTF-32.
+static unsigned detect_confidence_32(const detect_sample_t sample)
+{
+    if (!sample.valid || sample.units == 0)
+        return 0;
+    return 70 + (unsigned)(29 * (sample.narrow - sample.zero) / sample.units);
+}
+
+size_t cutf_detect_encoding(const size_t sz_in, const void *const p_in, const size_t sz_out,
+                            cutf_encoding_guess_t p_out[const sz_out])
+{
+    const char8_t *const p_bytes = p_in;
+    if (sz_out == 0)
+        return 0;
+
+    // UTF-32 has to be checked first, since the little endian UTF-32 BOM starts with the little endian UTF-16 BOM
+    if (sz_in >= sizeof(char32_t))
+    {
+        char32_t bom;
+        memcpy(&bom, p_bytes, sizeof(bom));
+        auto const endianness = cutf_utf32_bom_endianness(bom);
+        if (endianness != CUTF_ENDIANNESS_INVALID)
+        {
+            p_out[0] = (cutf_encoding_guess_t){CUTF_ENCODING_UTF32, endianness, sizeof(bom), DETECT_BOM_CONFIDENCE};
+            return 1;
+        }
+    }
+    if (sz_in >= sizeof(char16_t))
+    {
+        char16_t bom;
+        memcpy(&bom, p_bytes, sizeof(bom));
+        auto const endianness = cutf_utf16_bom_endianness(bom);
+        if (endianness != CUTF_ENDIANNESS_INVALID)
+        {
+            p_out[0] = (cutf_encoding_guess_t){CUTF_ENCODING_UTF16, endianness, sizeof(bom), DETECT_BOM_CONFIDENCE};
+            return 1;
+        }
+    }
+    if (sz_in >= 3 && p_bytes[0] == 0xEF && p_bytes[1] == 0xBB && p_bytes[2] == 0xBF)
+    {
+        p_out[0] = (cutf_encoding_guess_t){CUTF_ENCODING_UTF8, CUTF_ENDIANNESS_NATIVE, 3, DETECT_BOM_CONFIDENCE};
+        return 1;
+    }
+
+    auto const sz_sample = sz_in < CUTF_DETECT_SAMPLE_SIZE ? sz_in : CUTF_DETECT_SAMPLE_SIZE;
+
+    // Zero bytes are valid UTF-8, but almost never appear in text
+    size_t zero_bytes = 0, pos = 0;
+    for (; pos + SWAR_BLOCK <= sz_sample; pos += SWAR_BLOCK)
+        zero_bytes += swar_count_marked(swar_mark_zero(swar_load(p_bytes + pos)));
+    for (; pos < sz_sample; ++pos)
+        zero_bytes += p_bytes[pos] == 0;
+    size_t valid;
+    auto const utf8_valid = cutf_is_utf8_valid(sz_sample, p_bytes, &valid) != CUTF_INVALID_INPUT;
+
+    cutf_encoding_guess_t guesses[CUTF_MAX_ENCODING_GUESSES] = {
+        {CUTF_ENCODING_UTF8, CUTF_ENDIANNESS_NATIVE, 0, utf8_valid ? (zero_bytes == 0 ? 95 : 20) : 0},
+        {CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_NATIVE, 0, 0},
+        {CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_REVERSE, 0, 0},
+        {CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_NATIVE, 0, 0},
+        {CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_REVERSE, 0, 0},
+    };
+    // Units can not be split at the end of the whole input
+    if (sz_in % sizeof(char16_t) == 0)
+    {
+        guesses[1].confidence = detect_confidence_16(detect_sample_16(sz_sample, p_bytes, false));
+        guesses[2].confidence = detect_confidence_16(detect_sample_16(sz_sample, p_bytes, true));
+    }
+    if (sz_in % sizeof(char32_t) == 0)
+    {
+        guesses[3].confidence = detect_confidence_32(detect_sample_32(sz_sample, p_bytes, false));
+        guesses[4].confidence = detect_confidence_32(detect_sample_32(sz_sample, p_bytes, true));
+    }
+    // Nothing tells the encodings of empty input apart
+    if (sz_in == 0)
+        guesses[0].confidence = 1;
+
+    // Rank the guesses, keeping the order above for equal confidence
+    size_t written = 0;
+    for (size_t i = 0; i < CUTF_MAX_ENCODING_GUESSES; ++i)
+    {
+        if (guesses[i].confidence == 0)
+            continue;
+        size_t j = written < sz_out ? written : sz_out - 1;
+        if (j == written || guesses[i].confidence > p_out[j].confidence)
+        {
+            for (; j > 0 && p_out[j - 1].confidence < guesses[i].confidence; --j)
+                p_out[j] = p_out[j - 1];
+            p_out[j] = guesses[i];
+            written += written < sz_out;
+        }
+    }
+    return written;
+}
+
+static cutf_result_t s8tos16(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                             size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                             cutf_stats_t *const stats, cutf_state_t *const state)
+{
+    size_t pos_out = 0, pos_in = 0;
+    if (state->state_type == CUTF_STATE_U8_1 || state->state_type == CUTF_STATE_U8_2 ||
+        state->state_type == CUTF_STATE_U8_3)
+    {
+        auto const res_read = utf8_read_in_codepoint(sz_in, p_in, *state);
+        if (res_read.state.state_type == CUTF_STATE_ERROR)
+            return CUTF_INVALID_INPUT;
 
         pos_in = res_read.consumed;
         *state = res_read.state;
+        if (state->state_type == CUTF_STATE_CLEAR)
+        {
+            COUNT(slow_codepoints, 1);
+            if (stats != nullptr)
+                stats_add(stats, state->value);
+        }
     }
     if (state->state_type == CUTF_STATE_U16_1 || (pos_in != 0 && state->state_type == CUTF_STATE_CLEAR))
     {
@@ -846,6 +1823,23 @@ cutf_result_t cutf_s8tos16(const size_t sz_in, const char8_t p_in[const static s
 
     while (pos_in < sz_in && pos_out < sz_out)
     {
+        // Widen whole blocks of ASCII units at once
+        if (sz_in - pos_in >= SWAR_BLOCK && sz_out - pos_out >= SWAR_BLOCK)
+        {
+            auto const block = swar_load(p_in + pos_in);
+            if (stats == nullptr ? (block & SWAR_HIGH_BITS) == 0 : stats_can_add_block(block))
+            {
+                for (size_t i = 0; i < SWAR_BLOCK; ++i)
+                    p_out[pos_out + i] = p_in[pos_in + i];
+                COUNT(fast_blocks, 1);
+                if (stats != nullptr)
+                    stats_add_block(stats, p_in + pos_in);
+                pos_in += SWAR_BLOCK;
+                pos_out += SWAR_BLOCK;
+                continue;
+            }
+        }
+
         // Consume UTF-8 units until we complete the next codepoint
         auto const res_read =
             utf8_read_in_codepoint(sz_in - pos_in, p_in + pos_in, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
@@ -861,6 +1855,9 @@ cutf_result_t cutf_s8tos16(const size_t sz_in, const char8_t p_in[const static s
 
         // We are done with reading, extract the
         auto const next_codepoint = res_read.state.value;
+        COUNT(slow_codepoints, 1);
+        if (stats != nullptr)
+            stats_add(stats, next_codepoint);
 
         // Write out the UTF-16 units representing the codepoint
         auto const res_write = utf16_write_out_codepoint(
@@ -888,9 +1885,27 @@ cutf_result_t cutf_s8tos16(const size_t sz_in, const char8_t p_in[const static s
     return CUTF_SUCCESS;
 }
 
-cutf_result_t cutf_s16tos8(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
-                           size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+cutf_result_t cutf_s8tos16(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
                            cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s8tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, nullptr, state);
+    return count_result(res, p_consumed, sizeof(char8_t), p_written, sizeof(char16_t));
+}
+
+cutf_result_t cutf_s8tos16_stats(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                 size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                                 cutf_stats_t *const stats, cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s8tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, stats, state);
+    return count_result(res, p_consumed, sizeof(char8_t), p_written, sizeof(char16_t));
+}
+
+static cutf_result_t s16tos8(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                             size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                             cutf_state_t *const state)
 {
     size_t pos_out = 0, pos_in = 0;
 
@@ -936,6 +1951,7 @@ cutf_result_t cutf_s16tos8(const size_t sz_in, const char16_t p_in[const static
 
         // We are done with reading, extract the
         auto const next_codepoint = res_read.state.value;
+        COUNT(slow_codepoints, 1);
 
         // Write out the UTF-16 units representing the codepoint
         auto const res_write = utf8_write_out_codepoint(sz_out - pos_out, p_out + pos_out,
@@ -963,115 +1979,2508 @@ cutf_result_t cutf_s16tos8(const size_t sz_in, const char16_t p_in[const static
     return CUTF_SUCCESS;
 }
 
-static constexpr char32_t CUTF_WHITESPACE_CHARACTERS[] = {
-    U'\x0009', // Tab
-    U'\x000A', // Line feed
-    U'\x000B', // Line tab
-    U'\x000C', // Form feed
-    U'\x000D', // Carriage return
-    U'\x0020', // Space
-    U'\x0085', // Next line
-    U'\x00A0', // No-break space
-    U'\x1689', // Ogham space mark
-    U'\x2000', // En quad
-    U'\x2001', // Em quad
-    U'\x2002', // En space
-    U'\x2003', // Em space
-    U'\x2004', // Three-per-em space
-    U'\x2005', // Four-per-em space
-    U'\x2006', // Six-per-em space
-    U'\x2007', // Figure space
-    U'\x2008', // Punctuation space
-    U'\x2009', // Thin space
-    U'\x200A', // Hair space
-    U'\x2028', // Line separator
-    U'\x2029', // Paragraph separator
-    U'\x202F', // Narrow no-break space
-    U'\x205F', // Medium mathematical space
-    U'\x3000', // Ideographic
-};
+cutf_result_t cutf_s16tos8(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                           cutf_state_t *const state)
+{
+    count_call(state);
+    auto const res = s16tos8(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    return count_result(res, p_consumed, sizeof(char16_t), p_written, sizeof(char8_t));
+}
 
-static constexpr size_t CUTF_WHITESPACE_CHARACTERS_COUNT = sizeof(CUTF_WHITESPACE_CHARACTERS) / sizeof(char32_t);
+size_t cutf_encoding_unit_size(const cutf_encoding_t encoding)
+{
+    switch (encoding)
+    {
+    case CUTF_ENCODING_UTF8:
+        return sizeof(char8_t);
 
-bool cutf_is_whitespace(const char32_t c)
+    case CUTF_ENCODING_UTF16:
+        return sizeof(char16_t);
+
+    case CUTF_ENCODING_UTF32:
+        return sizeof(char32_t);
+
+    default:
+        return 0;
+    }
+}
+
+// Copy units between two strings of the same encoding, checking them like converting would. A codepoint split between
+// calls is kept in the state until the next call completes it, and only written out whole.
+static cutf_result_t copy_checked(const cutf_encoding_t encoding, const size_t sz_in, const void *const p_in,
+                                  const size_t sz_out, size_t *const p_consumed, void *const p_out,
+                                  size_t *const p_written, cutf_state_t *const state)
 {
-    for (size_t i = 0; i < CUTF_WHITESPACE_CHARACTERS_COUNT; ++i)
+    auto const unit_size = cutf_encoding_unit_size(encoding);
+    const char8_t *const p_bytes_in = p_in;
+    char8_t *const p_bytes_out = p_out;
+    size_t pos_in = 0, pos_out = 0;
+
+    if (state->state_type != CUTF_STATE_CLEAR)
     {
-        auto const whitespace_char = CUTF_WHITESPACE_CHARACTERS[i];
-        if (c == whitespace_char)
-            return true;
+        codepoint_return_t read = {.state = {.state_type = CUTF_STATE_ERROR}};
+        if (encoding == CUTF_ENCODING_UTF8 && (state->state_type == CUTF_STATE_U8_1 ||
+                                               state->state_type == CUTF_STATE_U8_2 ||
+                                               state->state_type == CUTF_STATE_U8_3))
+            read = utf8_read_in_codepoint(sz_in, p_in, *state);
+        else if (encoding == CUTF_ENCODING_UTF16 && state->state_type == CUTF_STATE_U16_1)
+            read = utf16_read_in_codepoint(sz_in, p_in, *state);
+        if (read.state.state_type == CUTF_STATE_ERROR)
+            return CUTF_INVALID_INPUT;
 
-        if (c < whitespace_char)
-            return false;
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            *state = read.state;
+            *p_consumed = read.consumed;
+            *p_written = 0;
+            return CUTF_INCOMPLETE_INPUT;
+        }
+
+        // The units of the codepoint read by the previous call are gone, so it is encoded again
+        char8_t units_8[4];
+        char16_t units_16[2];
+        auto const length = encoding == CUTF_ENCODING_UTF8 ? cutf_inline_utf8_encode(read.state.value, units_8)
+                                                           : cutf_inline_utf16_encode(read.state.value, units_16);
+        if (length > sz_out)
+        {
+            *p_consumed = 0;
+            *p_written = 0;
+            return CUTF_INSUFFICIENT_BUFFER;
+        }
+        memcpy(p_out, encoding == CUTF_ENCODING_UTF8 ? (const void *)units_8 : units_16, length * unit_size);
+        pos_in = read.consumed;
+        pos_out = length;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
     }
-    return false;
+
+    // Only the units which fit into the output are checked, so that small outputs do not check the same input again
+    auto const sz_rest = sz_in - pos_in;
+    auto const sz_checked = sz_rest < sz_out - pos_out ? sz_rest : sz_out - pos_out;
+    auto const p_rest = p_bytes_in + pos_in * unit_size;
+    size_t valid = 0;
+    auto res = CUTF_INVALID_INPUT;
+    if (encoding == CUTF_ENCODING_UTF8)
+        res = cutf_is_utf8_valid(sz_checked, (const char8_t *)p_rest, &valid);
+    else if (encoding == CUTF_ENCODING_UTF16)
+        res = cutf_is_utf16_valid(sz_checked, (const char16_t *)p_rest, &valid);
+    else if (encoding == CUTF_ENCODING_UTF32)
+        res = cutf_is_utf32_valid(sz_checked, (const char32_t *)p_rest, &valid);
+    if (res == CUTF_INVALID_INPUT)
+        return res;
+
+    if (valid != 0)
+        memcpy(p_bytes_out + pos_out * unit_size, p_rest, valid * unit_size);
+    pos_in += valid;
+    pos_out += valid;
+    if (sz_checked != sz_rest)
+    {
+        res = CUTF_INSUFFICIENT_BUFFER;
+    }
+    else if (res == CUTF_INCOMPLETE_INPUT)
+    {
+        // Keep the codepoint at the end of the input in the state, which the next call completes
+        auto const clear = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+        auto const p_tail = p_rest + valid * unit_size;
+        auto const tail = encoding == CUTF_ENCODING_UTF8
+                              ? utf8_read_in_codepoint(sz_in - pos_in, (const char8_t *)p_tail, clear).state
+                              : utf16_read_in_codepoint(sz_in - pos_in, (const char16_t *)p_tail, clear).state;
+        if (tail.state_type == CUTF_STATE_ERROR)
+            return CUTF_INVALID_INPUT;
+        *state = tail;
+        pos_in = sz_in;
+    }
+
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
 }
 
-static constexpr char32_t CUTF_LINE_TERMINATORS[] = {
-    U'\x000A', // Line feed
-    U'\x000D', // Carriage return
-    U'\x0085', // Next line
-    U'\x2028', // Line separator
-    U'\x2029', // Paragraph separator
-};
+cutf_result_t cutf_convert(const cutf_encoding_t from, const size_t sz_in, const void *const p_in,
+                           const cutf_encoding_t to, const size_t sz_out, size_t *const p_consumed, void *const p_out,
+                           size_t *const p_written, cutf_state_t *const state)
+{
+    if (from == to)
+        return copy_checked(from, sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    if (from == CUTF_ENCODING_UTF8 && to == CUTF_ENCODING_UTF16)
+        return cutf_s8tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    if (from == CUTF_ENCODING_UTF8 && to == CUTF_ENCODING_UTF32)
+        return cutf_s8tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    if (from == CUTF_ENCODING_UTF16 && to == CUTF_ENCODING_UTF8)
+        return cutf_s16tos8(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    if (from == CUTF_ENCODING_UTF16 && to == CUTF_ENCODING_UTF32)
+        return cutf_s16tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    if (from == CUTF_ENCODING_UTF32 && to == CUTF_ENCODING_UTF8)
+        return cutf_s32tos8(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+    if (from == CUTF_ENCODING_UTF32 && to == CUTF_ENCODING_UTF16)
+        return cutf_s32tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    return CUTF_INVALID_INPUT;
+}
 
-static constexpr size_t CUTF_LINE_TERMINATORS_COUNT = sizeof(CUTF_LINE_TERMINATORS) / sizeof(char32_t);
+cutf_result_t cutf_count_converted(const cutf_encoding_t from, const size_t sz_in, const void *const p_in,
+                                   const cutf_encoding_t to, size_t *const valid_count, size_t *const p_count)
+{
+    cutf_result_t res = CUTF_INVALID_INPUT;
+    *valid_count = 0;
+    if (from == CUTF_ENCODING_UTF8 && to == CUTF_ENCODING_UTF8)
+        res = cutf_is_utf8_valid(sz_in, p_in, valid_count);
+    else if (from == CUTF_ENCODING_UTF8 && to == CUTF_ENCODING_UTF16)
+        res = cutf_count_s8asc16(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF8 && to == CUTF_ENCODING_UTF32)
+        res = cutf_count_s8asc32(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF16 && to == CUTF_ENCODING_UTF8)
+        res = cutf_count_s16asc8(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF16 && to == CUTF_ENCODING_UTF16)
+        res = cutf_is_utf16_valid(sz_in, p_in, valid_count);
+    else if (from == CUTF_ENCODING_UTF16 && to == CUTF_ENCODING_UTF32)
+        res = cutf_count_s16asc32(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF32 && to == CUTF_ENCODING_UTF8)
+        res = cutf_count_s32asc8(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF32 && to == CUTF_ENCODING_UTF16)
+        res = cutf_count_s32asc16(sz_in, p_in, valid_count, p_count);
+    else if (from == CUTF_ENCODING_UTF32 && to == CUTF_ENCODING_UTF32)
+        res = cutf_is_utf32_valid(sz_in, p_in, valid_count);
+
+    // Units are the same when not converting
+    if (from == to)
+        *p_count = *valid_count;
+    return res;
+}
 
-bool cutf_is_line_terminator(const char32_t c)
+// The in-place conversions hold units of two different types in the same buffer, so it is only accessed through memcpy,
+// which compilers turn into plain loads and stores.
+
+cutf_result_t cutf_s32tos16_inplace(const size_t sz_in, void *const p_buffer, size_t *const p_consumed,
+                                    size_t *const p_written)
 {
-    for (size_t i = 0; i < CUTF_LINE_TERMINATORS_COUNT; ++i)
+    char8_t *const p_bytes = p_buffer;
+    size_t pos_in = 0, pos_out = 0;
+    auto res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
     {
-        auto const line_terminator = CUTF_LINE_TERMINATORS[i];
-        if (c == line_terminator)
-            return true;
+        // Narrow blocks of codepoints below U+10000 at once, after the whole block was read
+        if (sz_in - pos_in >= SWAR_BLOCK_16)
+        {
+            char32_t units[SWAR_BLOCK_16];
+            memcpy(units, p_bytes + pos_in * sizeof(char32_t), sizeof(units));
+            uint64_t v[2];
+            memcpy(v, units, sizeof(v));
+            // Pack the bottom halves of the 32-bit lanes into 16-bit lanes, whose order does not matter for the check
+            auto const packed = ((v[0] & 0xFFFF) | ((v[0] >> 16) & 0xFFFF0000)) |
+                                (((v[1] & 0xFFFF) | ((v[1] >> 16) & 0xFFFF0000)) << 32);
+            if (((v[0] | v[1]) & 0xFFFF0000FFFF0000) == 0 && !swar_has_surrogate_16(packed))
+            {
+                char16_t narrowed[SWAR_BLOCK_16];
+                for (size_t j = 0; j < SWAR_BLOCK_16; ++j)
+                    narrowed[j] = (char16_t)units[j];
+                memcpy(p_bytes + pos_out * sizeof(char16_t), narrowed, sizeof(narrowed));
+                pos_in += SWAR_BLOCK_16;
+                pos_out += SWAR_BLOCK_16;
+                continue;
+            }
+        }
 
-        if (c < line_terminator)
-            return false;
+        char32_t c;
+        memcpy(&c, p_bytes + pos_in * sizeof(char32_t), sizeof(c));
+        char16_t encoded[2];
+        auto const sz_encoded = cutf_inline_utf16_encode(c, encoded);
+        if (sz_encoded == 0)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        // The units of the codepoint fit in the bytes it was read from
+        memcpy(p_bytes + pos_out * sizeof(char16_t), encoded, sz_encoded * sizeof(char16_t));
+        pos_in += 1;
+        pos_out += sz_encoded;
     }
-    return false;
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
 }
 
-static constexpr char32_t CUTF_MAY_BREAK[] = {
-    U'\x0009', // Tab
-    U'\x000A', // Line feed
-    U'\x000B', // Line tab
-    U'\x000C', // Form feed
-    U'\x000D', // Carriage return
-    U'\x0020', // Space
-    U'\x0085', // Next line
-    U'\x1689', // Ogham space mark
-    U'\x180E', // Mongolian vowel separator
-    U'\x2000', // En quad
-    U'\x2001', // Em quad
-    U'\x2002', // En space
-    U'\x2003', // Em space
-    U'\x2004', // Three-per-em space
-    U'\x2005', // Four-per-em space
-    U'\x2006', // Six-per-em space
-    U'\x2008', // Punctuation space
-    U'\x2009', // Thin space
-    U'\x200A', // Hair space
-    U'\x200B', // Zero width space
-    U'\x200C', // Zero width non-joiner
-    U'\x200D', // Zero width joiner
-    U'\x2028', // Line separator
-    U'\x2029', // Paragraph separator
-    U'\x205F', // Medium mathematical space
-    U'\x3000', // Ideographic
-};
+cutf_result_t cutf_s32tos8_inplace(const size_t sz_in, void *const p_buffer, size_t *const p_consumed,
+                                   size_t *const p_written)
+{
+    char8_t *const p_bytes = p_buffer;
+    size_t pos_in = 0, pos_out = 0;
+    auto res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        // Narrow blocks of ASCII codepoints at once, after the whole block was read
+        if (sz_in - pos_in >= SWAR_BLOCK)
+        {
+            char32_t units[SWAR_BLOCK];
+            memcpy(units, p_bytes + pos_in * sizeof(char32_t), sizeof(units));
+            uint64_t v[SWAR_BLOCK / 2];
+            memcpy(v, units, sizeof(v));
+            if (((v[0] | v[1] | v[2] | v[3]) & 0xFFFFFF80FFFFFF80) == 0)
+            {
+                char8_t narrowed[SWAR_BLOCK];
+                for (size_t j = 0; j < SWAR_BLOCK; ++j)
+                    narrowed[j] = (char8_t)units[j];
+                memcpy(p_bytes + pos_out, narrowed, sizeof(narrowed));
+                pos_in += SWAR_BLOCK;
+                pos_out += SWAR_BLOCK;
+                continue;
+            }
+        }
 
-static constexpr size_t CUTF_MAY_BREAK_COUNT = sizeof(CUTF_MAY_BREAK) / sizeof(char32_t);
+        char32_t c;
+        memcpy(&c, p_bytes + pos_in * sizeof(char32_t), sizeof(c));
+        char8_t encoded[4];
+        auto const sz_encoded = cutf_inline_utf8_encode(c, encoded);
+        if (sz_encoded == 0)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        // The units of the codepoint fit in the bytes it was read from
+        memcpy(p_bytes + pos_out, encoded, sz_encoded);
+        pos_in += 1;
+        pos_out += sz_encoded;
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
 
-bool cutf_is_allowed_to_break(const char32_t c)
+cutf_result_t cutf_s16tos8_inplace_headroom(const size_t sz_in, const char16_t p_in[const static sz_in],
+                                            size_t *const p_headroom)
 {
-    for (size_t i = 0; i < CUTF_MAY_BREAK_COUNT; ++i)
+    // Bytes written minus bytes read so far, which only grows for codepoints from U+0800 to U+FFFF
+    ptrdiff_t ahead = 0, max_ahead = 0;
+    size_t pos_in = 0;
+    auto res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
     {
-        auto const break_char = CUTF_MAY_BREAK[i];
-        if (c == break_char)
-            return true;
+        // ASCII units fall behind by one byte each
+        if (sz_in - pos_in >= SWAR_BLOCK_16 && (swar_load_16(p_in + pos_in) & SWAR_NON_ASCII_16) == 0)
+        {
+            ahead -= SWAR_BLOCK_16;
+            pos_in += SWAR_BLOCK_16;
+            continue;
+        }
 
-        if (c < break_char)
-            return false;
+        size_t consumed;
+        char32_t c;
+        res = cutf_inline_utf16_decode(sz_in - pos_in, p_in + pos_in, &consumed, &c);
+        if (res != CUTF_SUCCESS)
+            break;
+        ahead += (ptrdiff_t)utf8_codepoint_units(c) - (ptrdiff_t)(consumed * sizeof(char16_t));
+        if (ahead > max_ahead)
+            max_ahead = ahead;
+        pos_in += consumed;
     }
-    return false;
+    *p_headroom = (size_t)max_ahead;
+    return res;
+}
+
+cutf_result_t cutf_s16tos8_inplace(const size_t sz_in, void *const p_buffer, const size_t offset,
+                                   size_t *const p_consumed, size_t *const p_written)
+{
+    char8_t *const p_bytes = p_buffer;
+    const char8_t *const p_input = p_bytes + offset;
+    size_t pos_in = 0, pos_out = 0;
+    auto res = CUTF_SUCCESS;
+    // Output written never reaches beyond the input read, so pos_out <= offset + pos_in * sizeof(char16_t)
+    while (pos_in < sz_in)
+    {
+        // Narrow blocks of ASCII units at once, which fall behind the input
+        if (sz_in - pos_in >= SWAR_BLOCK_16)
+        {
+            char16_t units[SWAR_BLOCK_16];
+            memcpy(units, p_input + pos_in * sizeof(char16_t), sizeof(units));
+            if ((swar_load_16(units) & SWAR_NON_ASCII_16) == 0)
+            {
+                char8_t narrowed[SWAR_BLOCK_16];
+                for (size_t j = 0; j < SWAR_BLOCK_16; ++j)
+                    narrowed[j] = (char8_t)units[j];
+                memcpy(p_bytes + pos_out, narrowed, sizeof(narrowed));
+                pos_in += SWAR_BLOCK_16;
+                pos_out += SWAR_BLOCK_16;
+                continue;
+            }
+        }
+
+        char16_t units[2];
+        auto const sz_units = sz_in - pos_in < 2 ? sz_in - pos_in : 2;
+        memcpy(units, p_input + pos_in * sizeof(char16_t), sz_units * sizeof(char16_t));
+        size_t consumed;
+        char32_t c;
+        res = cutf_inline_utf16_decode(sz_units, units, &consumed, &c);
+        if (res != CUTF_SUCCESS)
+            break;
+
+        char8_t encoded[4];
+        auto const sz_encoded = cutf_inline_utf8_encode(c, encoded);
+        // Stop before overwriting input which was not read yet
+        if (pos_out + sz_encoded > offset + (pos_in + consumed) * sizeof(char16_t))
+        {
+            res = CUTF_INSUFFICIENT_BUFFER;
+            break;
+        }
+        memcpy(p_bytes + pos_out, encoded, sz_encoded);
+        pos_in += consumed;
+        pos_out += sz_encoded;
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
+
+typedef enum
+{
+    LATIN1_MAX_VALUE = 0xFF,   // highest codepoint which can be represented in Latin-1
+    LATIN1_SUBSTITUTE = u8'?', // character used in place of those which can not be represented
+} latin1_constants_t;
+
+cutf_result_t cutf_sl1tos8(const size_t sz_in, const unsigned char p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                           cutf_state_t *const state)
+{
+    size_t pos_in = 0, pos_out = 0;
+    // Finish writing out the last character from the previous call
+    if (state->state_type == CUTF_STATE_U8_1 && sz_out != 0)
+    {
+        auto const res = update_utf8_state_removing(*state, 0);
+        *state = res.state;
+        p_out[0] = res.out;
+        pos_out = 1;
+    }
+    else if (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U8_1)
+    {
+        // Unrecognized state
+        return CUTF_INVALID_INPUT;
+    }
+
+    while (state->state_type == CUTF_STATE_CLEAR && pos_in < sz_in && pos_out < sz_out)
+    {
+        // Copy blocks of ASCII characters directly
+        if (pos_in + SWAR_BLOCK <= sz_in && pos_out + SWAR_BLOCK <= sz_out &&
+            (swar_load(p_in + pos_in) & SWAR_HIGH_BITS) == 0)
+        {
+            memcpy(p_out + pos_out, p_in + pos_in, SWAR_BLOCK);
+            pos_in += SWAR_BLOCK;
+            pos_out += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const c = p_in[pos_in];
+        pos_in += 1;
+        auto const res = update_utf8_state_removing(*state, c);
+        *state = res.state;
+        p_out[pos_out] = res.out;
+        pos_out += 1;
+
+        // Write out the continuation unit if there is room for it
+        if (state->state_type != CUTF_STATE_CLEAR && pos_out < sz_out)
+        {
+            auto const cont = update_utf8_state_removing(*state, 0);
+            *state = cont.state;
+            p_out[pos_out] = cont.out;
+            pos_out += 1;
+        }
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    // Either input was left, or the last character was not completely written out
+    if (pos_in != sz_in || state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_sl1tos16(const size_t sz_in, const unsigned char p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                            cutf_state_t *const state)
+{
+    // Nothing is ever left over, so the state must always be clear
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INVALID_INPUT;
+
+    // Every character maps to exactly one unit
+    auto const count = sz_in < sz_out ? sz_in : sz_out;
+    for (size_t i = 0; i < count; ++i)
+    {
+        p_out[i] = p_in[i];
+    }
+    *p_consumed = count;
+    *p_written = count;
+
+    if (count != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_sl1tos32(const size_t sz_in, const unsigned char p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, char32_t p_out[const sz_out], size_t *const p_written,
+                            cutf_state_t *const state)
+{
+    // Nothing is ever left over, so the state must always be clear
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INVALID_INPUT;
+
+    // Every character maps to exactly one unit
+    auto const count = sz_in < sz_out ? sz_in : sz_out;
+    for (size_t i = 0; i < count; ++i)
+    {
+        p_out[i] = p_in[i];
+    }
+    *p_consumed = count;
+    *p_written = count;
+
+    if (count != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+// Map a codepoint to Latin-1 based on the mode, returning false if it should be rejected.
+static bool latin1_encode_codepoint(const char32_t c, const cutf_latin1_mode_t mode, unsigned char *const p_out)
+{
+    if (c <= LATIN1_MAX_VALUE)
+    {
+        *p_out = (unsigned char)c;
+        return true;
+    }
+
+    if (mode == CUTF_LATIN1_SUBSTITUTE)
+    {
+        *p_out = LATIN1_SUBSTITUTE;
+        return true;
+    }
+
+    return false;
+}
+
+cutf_result_t cutf_s8tosl1(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                           size_t *const p_consumed, unsigned char p_out[const sz_out], size_t *const p_written,
+                           const cutf_latin1_mode_t mode, cutf_state_t *const state)
+{
+    if (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U8_1 &&
+        state->state_type != CUTF_STATE_U8_2 && state->state_type != CUTF_STATE_U8_3)
+    {
+        // Unrecognized state
+        return CUTF_INVALID_INPUT;
+    }
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < sz_in && pos_out < sz_out)
+    {
+        // Copy blocks of ASCII characters directly
+        if (state->state_type == CUTF_STATE_CLEAR && pos_in + SWAR_BLOCK <= sz_in && pos_out + SWAR_BLOCK <= sz_out &&
+            (swar_load(p_in + pos_in) & SWAR_HIGH_BITS) == 0)
+        {
+            memcpy(p_out + pos_out, p_in + pos_in, SWAR_BLOCK);
+            pos_in += SWAR_BLOCK;
+            pos_out += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const read = utf8_read_in_codepoint(sz_in - pos_in, p_in + pos_in, *state);
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            // Codepoint is completed by the next call
+            pos_in += read.consumed;
+            *state = read.state;
+            break;
+        }
+
+        if (!latin1_encode_codepoint(read.state.value, mode, p_out + pos_out))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        pos_in += read.consumed;
+        pos_out += 1;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    // Was the input complete?
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Check if we ran out of output buffer before the end of the input
+    if (pos_in != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_s16tosl1(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, unsigned char p_out[const sz_out], size_t *const p_written,
+                            const cutf_latin1_mode_t mode, cutf_state_t *const state)
+{
+    if (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U16_1)
+    {
+        // Unrecognized state
+        return CUTF_INVALID_INPUT;
+    }
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < sz_in && pos_out < sz_out)
+    {
+        // Units which fit need no decoding
+        if (state->state_type == CUTF_STATE_CLEAR && p_in[pos_in] <= LATIN1_MAX_VALUE)
+        {
+            p_out[pos_out] = (unsigned char)p_in[pos_in];
+            pos_in += 1;
+            pos_out += 1;
+            continue;
+        }
+
+        auto const read = utf16_read_in_codepoint(sz_in - pos_in, p_in + pos_in, *state);
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            // Codepoint is completed by the next call
+            pos_in += read.consumed;
+            *state = read.state;
+            break;
+        }
+
+        if (!latin1_encode_codepoint(read.state.value, mode, p_out + pos_out))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        pos_in += read.consumed;
+        pos_out += 1;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    // Was the input complete?
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Check if we ran out of output buffer before the end of the input
+    if (pos_in != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_s32tosl1(const size_t sz_in, const char32_t p_in[const static sz_in], const size_t sz_out,
+                            size_t *const p_consumed, unsigned char p_out[const sz_out], size_t *const p_written,
+                            const cutf_latin1_mode_t mode, cutf_state_t *const state)
+{
+    // Nothing is ever left over, so the state must always be clear
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INVALID_INPUT;
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos;
+    auto const count = sz_in < sz_out ? sz_in : sz_out;
+    for (pos = 0; pos < count; ++pos)
+    {
+        auto const c = p_in[pos];
+        if (!cutf_inline_is_valid_codepoint(c) || !latin1_encode_codepoint(c, mode, p_out + pos))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+    }
+    *p_consumed = pos;
+    *p_written = pos;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    if (pos != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+bool cutf_fits_latin1_s8(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        // Skip blocks of ASCII characters
+        if (pos + SWAR_BLOCK <= sz_in && (swar_load(p_in + pos) & SWAR_HIGH_BITS) == 0)
+        {
+            pos += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const read =
+            utf8_read_in_codepoint(sz_in - pos, p_in + pos, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type != CUTF_STATE_CLEAR || read.state.value > LATIN1_MAX_VALUE)
+            return false;
+        pos += read.consumed;
+    }
+
+    return true;
+}
+
+bool cutf_fits_latin1_s16(const size_t sz_in, const char16_t p_in[const static sz_in])
+{
+    // Accumulate instead of returning early, so that the loop can be vectorized
+    char16_t combined = 0;
+    for (size_t i = 0; i < sz_in; ++i)
+    {
+        combined |= p_in[i];
+    }
+    return combined <= LATIN1_MAX_VALUE;
+}
+
+bool cutf_fits_latin1_s32(const size_t sz_in, const char32_t p_in[const static sz_in])
+{
+    // Accumulate instead of returning early, so that the loop can be vectorized
+    char32_t combined = 0;
+    for (size_t i = 0; i < sz_in; ++i)
+    {
+        combined |= p_in[i];
+    }
+    return combined <= LATIN1_MAX_VALUE;
+}
+
+static cutf_width_class_t width_class_of_codepoint(const char32_t c)
+{
+    if (c < UTF8_PREFIX_CONTINUATION)
+        return CUTF_WIDTH_ASCII;
+
+    if (c <= LATIN1_MAX_VALUE)
+        return CUTF_WIDTH_LATIN1;
+
+    if (c < UTF16_SURROGATE_PAIR_START)
+        return CUTF_WIDTH_BMP;
+
+    return CUTF_WIDTH_ASTRAL;
+}
+
+size_t cutf_width_class_size(const cutf_width_class_t width_class)
+{
+    switch (width_class)
+    {
+    case CUTF_WIDTH_ASCII:
+    case CUTF_WIDTH_LATIN1:
+        return sizeof(unsigned char);
+
+    case CUTF_WIDTH_BMP:
+        return sizeof(char16_t);
+
+    case CUTF_WIDTH_ASTRAL:
+        return sizeof(char32_t);
+
+    default:
+        return 0;
+    }
+}
+
+cutf_result_t cutf_analyze_s8(const size_t sz_in, const char8_t p_in[const static sz_in], size_t *const valid_count,
+                              cutf_analysis_t *const p_analysis)
+{
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos = 0, count = 0;
+    char32_t max_codepoint = 0;
+    while (pos < sz_in)
+    {
+        // Blocks of ASCII have one codepoint per unit and do not change the maximum
+        if (pos + SWAR_BLOCK <= sz_in && (swar_load(p_in + pos) & SWAR_HIGH_BITS) == 0)
+        {
+            pos += SWAR_BLOCK;
+            count += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const read =
+            utf8_read_in_codepoint(sz_in - pos, p_in + pos, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+
+        if (read.state.value > max_codepoint)
+            max_codepoint = read.state.value;
+        pos += read.consumed;
+        count += 1;
+    }
+
+    *valid_count = pos;
+    *p_analysis = (cutf_analysis_t){.count = count, .width_class = width_class_of_codepoint(max_codepoint)};
+    return res;
+}
+
+cutf_result_t cutf_analyze_s16(const size_t sz_in, const char16_t p_in[const static sz_in], size_t *const valid_count,
+                               cutf_analysis_t *const p_analysis)
+{
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos = 0, count = 0;
+    char32_t max_codepoint = 0;
+    while (pos < sz_in)
+    {
+        // Blocks of ASCII have one codepoint per unit and do not change the maximum
+        if (pos + SWAR_BLOCK_16 <= sz_in && (swar_load_16(p_in + pos) & SWAR_NON_ASCII_16) == 0)
+        {
+            pos += SWAR_BLOCK_16;
+            count += SWAR_BLOCK_16;
+            continue;
+        }
+
+        auto const read =
+            utf16_read_in_codepoint(sz_in - pos, p_in + pos, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+
+        if (read.state.value > max_codepoint)
+            max_codepoint = read.state.value;
+        pos += read.consumed;
+        count += 1;
+    }
+
+    *valid_count = pos;
+    *p_analysis = (cutf_analysis_t){.count = count, .width_class = width_class_of_codepoint(max_codepoint)};
+    return res;
+}
+
+// Convert UTF-8 into UCS-2, which is UTF-16 without surrogate pairs.
+static cutf_result_t s8toucs2(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                              size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                              cutf_state_t *const state)
+{
+    if (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U8_1 &&
+        state->state_type != CUTF_STATE_U8_2 && state->state_type != CUTF_STATE_U8_3)
+    {
+        // Unrecognized state
+        return CUTF_INVALID_INPUT;
+    }
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < sz_in && pos_out < sz_out)
+    {
+        // Widen blocks of ASCII characters directly
+        if (state->state_type == CUTF_STATE_CLEAR && pos_in + SWAR_BLOCK <= sz_in && pos_out + SWAR_BLOCK <= sz_out &&
+            (swar_load(p_in + pos_in) & SWAR_HIGH_BITS) == 0)
+        {
+            for (size_t i = 0; i < SWAR_BLOCK; ++i)
+            {
+                p_out[pos_out + i] = p_in[pos_in + i];
+            }
+            pos_in += SWAR_BLOCK;
+            pos_out += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const read = utf8_read_in_codepoint(sz_in - pos_in, p_in + pos_in, *state);
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            // Codepoint is completed by the next call
+            pos_in += read.consumed;
+            *state = read.state;
+            break;
+        }
+
+        auto const c = read.state.value;
+        if (!cutf_inline_is_valid_codepoint(c) || c >= UTF16_SURROGATE_PAIR_START)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        p_out[pos_out] = (char16_t)c;
+        pos_in += read.consumed;
+        pos_out += 1;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    // Was the input complete?
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INCOMPLETE_INPUT;
+
+    // Check if we ran out of output buffer before the end of the input
+    if (pos_in != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_s8tonarrow(const size_t sz_in, const char8_t p_in[const static sz_in],
+                              const cutf_width_class_t width_class, const size_t sz_out, size_t *const p_consumed,
+                              void *const p_out, size_t *const p_written, cutf_state_t *const state)
+{
+    switch (width_class)
+    {
+    case CUTF_WIDTH_ASCII:
+    case CUTF_WIDTH_LATIN1:
+        return cutf_s8tosl1(sz_in, p_in, sz_out, p_consumed, p_out, p_written, CUTF_LATIN1_STRICT, state);
+
+    case CUTF_WIDTH_BMP:
+        return s8toucs2(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    case CUTF_WIDTH_ASTRAL:
+        return cutf_s8tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    default:
+        return CUTF_INVALID_INPUT;
+    }
+}
+
+// Convert UTF-16 into UCS-2, which only requires checking there are no surrogates.
+static cutf_result_t s16toucs2(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                               size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                               const cutf_state_t *const state)
+{
+    // Nothing is ever left over, so the state must always be clear
+    if (state->state_type != CUTF_STATE_CLEAR)
+        return CUTF_INVALID_INPUT;
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos;
+    auto const count = sz_in < sz_out ? sz_in : sz_out;
+    for (pos = 0; pos < count; ++pos)
+    {
+        auto const c = p_in[pos];
+        if (c >= UTF16_SURROGATE_HIGH_START && c <= UTF16_SURROGATE_LOW_END)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        p_out[pos] = c;
+    }
+    *p_consumed = pos;
+    *p_written = pos;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    if (pos != sz_in)
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_s16tonarrow(const size_t sz_in, const char16_t p_in[const static sz_in],
+                               const cutf_width_class_t width_class, const size_t sz_out, size_t *const p_consumed,
+                               void *const p_out, size_t *const p_written, cutf_state_t *const state)
+{
+    switch (width_class)
+    {
+    case CUTF_WIDTH_ASCII:
+    case CUTF_WIDTH_LATIN1:
+        return cutf_s16tosl1(sz_in, p_in, sz_out, p_consumed, p_out, p_written, CUTF_LATIN1_STRICT, state);
+
+    case CUTF_WIDTH_BMP:
+        return s16toucs2(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    case CUTF_WIDTH_ASTRAL:
+        return cutf_s16tos32(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    default:
+        return CUTF_INVALID_INPUT;
+    }
+}
+
+// Encode any value up to U+10FFFF as UTF-8, including surrogates, returning the number of units written.
+static unsigned utf8_encode_generalized(const char32_t c, char8_t p_out[const static 4])
+{
+    if (c < UTF8_PREFIX_CONTINUATION)
+    {
+        p_out[0] = (char8_t)c;
+        return 1;
+    }
+    if (c < UTF8_MAX_TWO_UNITS)
+    {
+        p_out[0] = (char8_t)UTF8_PREFIX_TWO_UNITS | (char8_t)(c >> 6);
+        p_out[1] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)(c & MASK_BOTTOM_6_BITS);
+        return 2;
+    }
+    if (c < UTF8_MAX_THREE_UNITS)
+    {
+        p_out[0] = (char8_t)UTF8_PREFIX_THREE_UNITS | (char8_t)(c >> 12);
+        p_out[1] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)((c >> 6) & MASK_BOTTOM_6_BITS);
+        p_out[2] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)(c & MASK_BOTTOM_6_BITS);
+        return 3;
+    }
+    p_out[0] = (char8_t)UTF8_PREFIX_FOUR_UNITS | (char8_t)(c >> 18);
+    p_out[1] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)((c >> 12) & MASK_BOTTOM_6_BITS);
+    p_out[2] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)((c >> 6) & MASK_BOTTOM_6_BITS);
+    p_out[3] = (char8_t)UTF8_PREFIX_CONTINUATION | (char8_t)(c & MASK_BOTTOM_6_BITS);
+    return 4;
+}
+
+// Encode a high surrogate and the unit following it (if it is known) in the given UTF-8 variant. Returns the number
+// of UTF-8 units written, or zero if the variant does not allow it. Number of UTF-16 units used is added to consumed.
+static unsigned utf8_variant_encode_high_surrogate(const char16_t high, const bool has_next, const char16_t next,
+                                                   const cutf_utf8_variant_t variant, char8_t p_out[const static 6],
+                                                   size_t *const p_consumed)
+{
+    if (has_next && cutf_inline_utf16_is_low_surrogate(next))
+    {
+        *p_consumed += 2;
+        if (variant == CUTF_UTF8_WTF8)
+        {
+            auto const c = UTF16_SURROGATE_PAIR_START + ((char32_t)(high & MASK_BOTTOM_10_BITS) << 10) +
+                           (next & MASK_BOTTOM_10_BITS);
+            return utf8_encode_generalized(c, p_out);
+        }
+        // Each surrogate is encoded on its own
+        auto const first = utf8_encode_generalized(high, p_out);
+        return first + utf8_encode_generalized(next, p_out + first);
+    }
+
+    // Lone surrogate
+    if (variant == CUTF_UTF8_CESU8)
+        return 0;
+
+    *p_consumed += 1;
+    return utf8_encode_generalized(high, p_out);
+}
+
+cutf_result_t cutf_s16tos8_variant(const size_t sz_in, const char16_t p_in[const static sz_in], const size_t sz_out,
+                                   size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written,
+                                   const cutf_utf8_variant_t variant, cutf_state_t *const state)
+{
+    if (variant == CUTF_UTF8_STANDARD)
+        return cutf_s16tos8(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    if ((variant != CUTF_UTF8_WTF8 && variant != CUTF_UTF8_CESU8 && variant != CUTF_UTF8_MUTF8) ||
+        (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U16_1))
+        return CUTF_INVALID_INPUT;
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos_in = 0, pos_out = 0;
+
+    // High surrogate left over from the previous call
+    if (state->state_type == CUTF_STATE_U16_1)
+    {
+        // When there is no more input, it has to be written out as a lone surrogate
+        if (sz_in == 0 && variant == CUTF_UTF8_CESU8)
+        {
+            *p_consumed = 0;
+            *p_written = 0;
+            return CUTF_INCOMPLETE_INPUT;
+        }
+
+        char8_t buffer[6];
+        size_t used = 0;
+        auto const high = (char16_t)(UTF16_SURROGATE_HIGH_START | state->value);
+        auto const len =
+            utf8_variant_encode_high_surrogate(high, sz_in != 0, sz_in != 0 ? p_in[0] : 0, variant, buffer, &used);
+        if (len == 0)
+        {
+            *p_consumed = 0;
+            *p_written = 0;
+            return CUTF_INVALID_INPUT;
+        }
+        if (len > sz_out)
+        {
+            *p_consumed = 0;
+            *p_written = 0;
+            return CUTF_INSUFFICIENT_BUFFER;
+        }
+        memcpy(p_out, buffer, len);
+        pos_out = len;
+        // The high surrogate itself was already consumed by the previous call
+        pos_in = used - 1;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+    }
+
+    // Used to check for U+0000 in Modified UTF-8
+    constexpr uint64_t low_units = 0x0001000100010001;
+    constexpr uint64_t high_units = 0x8000800080008000;
+
+    while (pos_in < sz_in)
+    {
+        // Copy blocks of ASCII characters directly, except for U+0000 in Modified UTF-8
+        if (pos_in + SWAR_BLOCK_16 <= sz_in && pos_out + SWAR_BLOCK_16 <= sz_out)
+        {
+            auto const block = swar_load_16(p_in + pos_in);
+            if ((block & SWAR_NON_ASCII_16) == 0 &&
+                (variant != CUTF_UTF8_MUTF8 || ((block - low_units) & ~block & high_units) == 0))
+            {
+                for (size_t i = 0; i < SWAR_BLOCK_16; ++i)
+                {
+                    p_out[pos_out + i] = (char8_t)p_in[pos_in + i];
+                }
+                pos_in += SWAR_BLOCK_16;
+                pos_out += SWAR_BLOCK_16;
+                continue;
+            }
+        }
+
+        auto const c = p_in[pos_in];
+        char8_t buffer[6];
+        size_t used = 0;
+        unsigned len;
+        if (cutf_inline_utf16_is_high_surrogate(c))
+        {
+            if (pos_in + 1 == sz_in)
+            {
+                // Keep it in the state until we know what follows it
+                *state = (cutf_state_t){.state_type = CUTF_STATE_U16_1, .value = c & MASK_BOTTOM_10_BITS};
+                pos_in += 1;
+                break;
+            }
+            len = utf8_variant_encode_high_surrogate(c, true, p_in[pos_in + 1], variant, buffer, &used);
+        }
+        else if (cutf_inline_utf16_is_low_surrogate(c) && variant == CUTF_UTF8_CESU8)
+        {
+            // Lone low surrogate
+            len = 0;
+        }
+        else if (c == 0 && variant == CUTF_UTF8_MUTF8)
+        {
+            buffer[0] = UTF8_PREFIX_TWO_UNITS;
+            buffer[1] = UTF8_PREFIX_CONTINUATION;
+            len = 2;
+            used = 1;
+        }
+        else
+        {
+            len = utf8_encode_generalized(c, buffer);
+            used = 1;
+        }
+
+        if (len == 0)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        // Only write out complete sequences
+        if (pos_out + len > sz_out)
+            break;
+
+        memcpy(p_out + pos_out, buffer, len);
+        pos_out += len;
+        pos_in += used;
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    if (pos_in != sz_in) // Could not process all input data, meaning that we ran out of output buffer
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    if (state->state_type != CUTF_STATE_CLEAR) // We consumed all input but it was not complete
+        return CUTF_INCOMPLETE_INPUT;
+
+    return CUTF_SUCCESS;
+}
+
+// While ``cutf_s8tos16_variant`` reads the units of the codepoint after a high surrogate, the surrogate is kept in the
+// upper half of the value of the UTF-8 state, which values of partially read codepoints never reach.
+static constexpr unsigned VARIANT_PENDING_SHIFT = 16;
+
+cutf_result_t cutf_s8tos16_variant(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                   size_t *const p_consumed, char16_t p_out[const sz_out], size_t *const p_written,
+                                   const cutf_utf8_variant_t variant, cutf_state_t *const state)
+{
+    if (variant == CUTF_UTF8_STANDARD)
+        return cutf_s8tos16(sz_in, p_in, sz_out, p_consumed, p_out, p_written, state);
+
+    if ((variant != CUTF_UTF8_WTF8 && variant != CUTF_UTF8_CESU8 && variant != CUTF_UTF8_MUTF8) ||
+        (state->state_type != CUTF_STATE_CLEAR && state->state_type != CUTF_STATE_U8_1 &&
+         state->state_type != CUTF_STATE_U8_2 && state->state_type != CUTF_STATE_U8_3 &&
+         (state->state_type != CUTF_STATE_U16_1 || variant == CUTF_UTF8_MUTF8)))
+        return CUTF_INVALID_INPUT;
+
+    // High surrogate left over from the previous call, which has to be written out as a lone surrogate in WTF-8 when
+    // there is no more input
+    if (sz_in == 0 && state->state_type == CUTF_STATE_U16_1 && variant == CUTF_UTF8_WTF8)
+    {
+        *p_consumed = 0;
+        *p_written = 0;
+        if (sz_out == 0)
+            return CUTF_INSUFFICIENT_BUFFER;
+
+        p_out[0] = (char16_t)(UTF16_SURROGATE_HIGH_START | state->value);
+        *p_written = 1;
+        *state = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+        return CUTF_SUCCESS;
+    }
+
+    // Only Modified UTF-8 encodes U+0000 as two units, and never as one
+    auto const allow = variant == CUTF_UTF8_MUTF8 ? UTF8_ALLOW_SURROGATES | UTF8_ALLOW_OVERLONG_NULL
+                                                  : UTF8_ALLOW_SURROGATES;
+
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < sz_in)
+    {
+        // Widen blocks of ASCII characters directly
+        if (state->state_type == CUTF_STATE_CLEAR && pos_in + SWAR_BLOCK <= sz_in && pos_out + SWAR_BLOCK <= sz_out)
+        {
+            auto const block = swar_load(p_in + pos_in);
+            if ((block & SWAR_HIGH_BITS) == 0 && (variant != CUTF_UTF8_MUTF8 || swar_mark_zero(block) == 0))
+            {
+                for (size_t i = 0; i < SWAR_BLOCK; ++i)
+                {
+                    p_out[pos_out + i] = p_in[pos_in + i];
+                }
+                pos_in += SWAR_BLOCK;
+                pos_out += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        // Separate the high surrogate waiting for the codepoint after it from the units read of that codepoint
+        char16_t pending = 0;
+        auto previous = *state;
+        if (state->state_type == CUTF_STATE_U16_1)
+        {
+            pending = (char16_t)(UTF16_SURROGATE_HIGH_START | state->value);
+            previous = (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+        }
+        else
+        {
+            pending = (char16_t)(state->value >> VARIANT_PENDING_SHIFT);
+            previous.value &= ((char32_t)1 << VARIANT_PENDING_SHIFT) - 1;
+        }
+
+        auto const read = utf8_read_in_codepoint_allowing(sz_in - pos_in, p_in + pos_in, previous, allow);
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            // Codepoint is completed by the next call
+            pos_in += read.consumed;
+            *state = (cutf_state_t){.state_type = read.state.state_type,
+                                    .value = read.state.value | (char32_t)pending << VARIANT_PENDING_SHIFT};
+            break;
+        }
+
+        auto const c = read.state.value;
+        auto const is_low = cutf_inline_utf16_is_low_surrogate(c);
+        auto const single_null = c == 0 && previous.state_type == CUTF_STATE_CLEAR && read.consumed == 1;
+        // Only WTF-8 may contain four unit sequences, others use a pair of encoded surrogates. CESU-8 allows surrogates
+        // only in pairs, while WTF-8 only allows them unpaired.
+        if (c > UNICODE_MAX_VALUE || (c >= UTF16_SURROGATE_PAIR_START && variant != CUTF_UTF8_WTF8) ||
+            (variant == CUTF_UTF8_CESU8 && (pending != 0) != is_low) ||
+            (variant == CUTF_UTF8_WTF8 && pending != 0 && is_low) || (variant == CUTF_UTF8_MUTF8 && single_null))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+
+        // High surrogates are kept until we know what follows them, except in Modified UTF-8, which allows anything
+        auto const keep = cutf_inline_utf16_is_high_surrogate(c) && variant != CUTF_UTF8_MUTF8;
+        auto const needed = (pending != 0) + (keep ? 0 : c >= UTF16_SURROGATE_PAIR_START ? 2 : 1);
+        // Only write out complete surrogate pairs
+        if (pos_out + needed > sz_out)
+            break;
+
+        if (pending != 0)
+            p_out[pos_out++] = pending;
+        if (c >= UTF16_SURROGATE_PAIR_START)
+        {
+            auto const adjusted = c - UTF16_SURROGATE_PAIR_START;
+            p_out[pos_out] = (char16_t)(UTF16_SURROGATE_HIGH_START | (adjusted >> 10));
+            p_out[pos_out + 1] = (char16_t)(UTF16_SURROGATE_LOW_START | (adjusted & MASK_BOTTOM_10_BITS));
+            pos_out += 2;
+        }
+        else if (!keep)
+        {
+            // Surrogates are written out as they are
+            p_out[pos_out++] = (char16_t)c;
+        }
+        pos_in += read.consumed;
+        *state = keep ? (cutf_state_t){.state_type = CUTF_STATE_U16_1, .value = c & MASK_BOTTOM_10_BITS}
+                      : (cutf_state_t){.state_type = CUTF_STATE_CLEAR};
+    }
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+
+    if (res != CUTF_SUCCESS)
+        return res;
+
+    if (pos_in != sz_in) // Could not process all input data, meaning that we ran out of output buffer
+        return CUTF_INSUFFICIENT_BUFFER;
+
+    if (state->state_type != CUTF_STATE_CLEAR) // We consumed all input but it was not complete
+        return CUTF_INCOMPLETE_INPUT;
+
+    return CUTF_SUCCESS;
+}
+
+static constexpr char32_t CUTF_WHITESPACE_CHARACTERS[] = {
+    U'\x0009', // Tab
+    U'\x000A', // Line feed
+    U'\x000B', // Line tab
+    U'\x000C', // Form feed
+    U'\x000D', // Carriage return
+    U'\x0020', // Space
+    U'\x0085', // Next line
+    U'\x00A0', // No-break space
+    U'\x1680', // Ogham space mark
+    U'\x2000', // En quad
+    U'\x2001', // Em quad
+    U'\x2002', // En space
+    U'\x2003', // Em space
+    U'\x2004', // Three-per-em space
+    U'\x2005', // Four-per-em space
+    U'\x2006', // Six-per-em space
+    U'\x2007', // Figure space
+    U'\x2008', // Punctuation space
+    U'\x2009', // Thin space
+    U'\x200A', // Hair space
+    U'\x2028', // Line separator
+    U'\x2029', // Paragraph separator
+    U'\x202F', // Narrow no-break space
+    U'\x205F', // Medium mathematical space
+    U'\x3000', // Ideographic
+};
+
+static constexpr size_t CUTF_WHITESPACE_CHARACTERS_COUNT = sizeof(CUTF_WHITESPACE_CHARACTERS) / sizeof(char32_t);
+
+bool cutf_is_whitespace(const char32_t c)
+{
+    for (size_t i = 0; i < CUTF_WHITESPACE_CHARACTERS_COUNT; ++i)
+    {
+        auto const whitespace_char = CUTF_WHITESPACE_CHARACTERS[i];
+        if (c == whitespace_char)
+            return true;
+
+        if (c < whitespace_char)
+            return false;
+    }
+    return false;
+}
+
+static constexpr char32_t CUTF_LINE_TERMINATORS[] = {
+    U'\x000A', // Line feed
+    U'\x000D', // Carriage return
+    U'\x0085', // Next line
+    U'\x2028', // Line separator
+    U'\x2029', // Paragraph separator
+};
+
+static constexpr size_t CUTF_LINE_TERMINATORS_COUNT = sizeof(CUTF_LINE_TERMINATORS) / sizeof(char32_t);
+
+bool cutf_is_line_terminator(const char32_t c)
+{
+    for (size_t i = 0; i < CUTF_LINE_TERMINATORS_COUNT; ++i)
+    {
+        auto const line_terminator = CUTF_LINE_TERMINATORS[i];
+        if (c == line_terminator)
+            return true;
+
+        if (c < line_terminator)
+            return false;
+    }
+    return false;
+}
+
+static constexpr char32_t CUTF_MAY_BREAK[] = {
+    U'\x0009', // Tab
+    U'\x000A', // Line feed
+    U'\x000B', // Line tab
+    U'\x000C', // Form feed
+    U'\x000D', // Carriage return
+    U'\x0020', // Space
+    U'\x0085', // Next line
+    U'\x1680', // Ogham space mark
+    U'\x180E', // Mongolian vowel separator
+    U'\x2000', // En quad
+    U'\x2001', // Em quad
+    U'\x2002', // En space
+    U'\x2003', // Em space
+    U'\x2004', // Three-per-em space
+    U'\x2005', // Four-per-em space
+    U'\x2006', // Six-per-em space
+    U'\x2008', // Punctuation space
+    U'\x2009', // Thin space
+    U'\x200A', // Hair space
+    U'\x200B', // Zero width space
+    U'\x200C', // Zero width non-joiner
+    U'\x200D', // Zero width joiner
+    U'\x2028', // Line separator
+    U'\x2029', // Paragraph separator
+    U'\x205F', // Medium mathematical space
+    U'\x3000', // Ideographic
+};
+
+static constexpr size_t CUTF_MAY_BREAK_COUNT = sizeof(CUTF_MAY_BREAK) / sizeof(char32_t);
+
+bool cutf_is_allowed_to_break(const char32_t c)
+{
+    for (size_t i = 0; i < CUTF_MAY_BREAK_COUNT; ++i)
+    {
+        auto const break_char = CUTF_MAY_BREAK[i];
+        if (c == break_char)
+            return true;
+
+        if (c < break_char)
+            return false;
+    }
+    return false;
+}
+
+typedef struct
+{
+    size_t sz_out;
+    cutf_span_t *p_out;
+    size_t written;
+} span_writer_t;
+
+static bool span_writer_push(span_writer_t *const writer, const size_t start, const size_t end)
+{
+    if (writer->written == writer->sz_out)
+        return false;
+
+    writer->p_out[writer->written] = (cutf_span_t){.start = start, .length = end - start};
+    writer->written += 1;
+    return true;
+}
+
+cutf_result_t cutf_utf8_wrap(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t width,
+                             const size_t sz_out, size_t *const p_consumed, cutf_span_t p_out[const sz_out],
+                             size_t *const p_written)
+{
+    if (width == 0)
+        return CUTF_INVALID_INPUT;
+
+    span_writer_t writer = {.sz_out = sz_out, .p_out = p_out, .written = 0};
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t line_start = 0, pos = 0, column = 0;
+    // Position of the last character in the line which allows breaking, with the column after it
+    bool has_break = false;
+    size_t break_start = 0, break_end = 0, break_column = 0;
+
+    while (pos < sz_in)
+    {
+        // Printable ASCII characters neither break lines nor allow breaking, so skip them in blocks
+        if (pos + SWAR_BLOCK <= sz_in && column + SWAR_BLOCK <= width)
+        {
+            auto const block = swar_load(p_in + pos);
+            if (((block & SWAR_HIGH_BITS) | swar_mark_less_than(block, 0x21)) == 0)
+            {
+                column += SWAR_BLOCK;
+                pos += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        auto const read =
+            utf8_read_in_codepoint(sz_in - pos, p_in + pos, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+        if (read.state.state_type == CUTF_STATE_ERROR)
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        if (read.state.state_type != CUTF_STATE_CLEAR)
+        {
+            res = CUTF_INCOMPLETE_INPUT;
+            break;
+        }
+        auto const c = read.state.value;
+
+        if (cutf_is_line_terminator(c))
+        {
+            size_t next = pos + read.consumed;
+            // Carriage return followed by line feed is a single line terminator
+            if (c == U'\r' && next < sz_in && p_in[next] == u8'\n')
+                next += 1;
+
+            if (!span_writer_push(&writer, line_start, pos))
+            {
+                res = CUTF_INSUFFICIENT_BUFFER;
+                break;
+            }
+            line_start = pos = next;
+            column = 0;
+            has_break = false;
+            continue;
+        }
+
+        if (cutf_is_allowed_to_break(c))
+        {
+            if (column >= width)
+            {
+                // Line is already full, so break it here
+                if (!span_writer_push(&writer, line_start, pos))
+                {
+                    res = CUTF_INSUFFICIENT_BUFFER;
+                    break;
+                }
+                line_start = pos = pos + read.consumed;
+                column = 0;
+                has_break = false;
+                continue;
+            }
+
+            column += 1;
+            has_break = true;
+            break_start = pos;
+            break_end = pos + read.consumed;
+            break_column = column;
+            pos = break_end;
+            continue;
+        }
+
+        if (column >= width)
+        {
+            // Line is full, so break at the last place allowed, or right here if there is none
+            if (has_break)
+            {
+                if (!span_writer_push(&writer, line_start, break_start))
+                {
+                    res = CUTF_INSUFFICIENT_BUFFER;
+                    break;
+                }
+                line_start = break_end;
+                column -= break_column;
+            }
+            else
+            {
+                if (!span_writer_push(&writer, line_start, pos))
+                {
+                    res = CUTF_INSUFFICIENT_BUFFER;
+                    break;
+                }
+                line_start = pos;
+                column = 0;
+            }
+            has_break = false;
+        }
+
+        column += 1;
+        pos += read.consumed;
+    }
+
+    // Whatever is left is the last line
+    if (res == CUTF_SUCCESS && line_start < sz_in)
+    {
+        if (span_writer_push(&writer, line_start, sz_in))
+            line_start = sz_in;
+        else
+            res = CUTF_INSUFFICIENT_BUFFER;
+    }
+
+    *p_consumed = res == CUTF_SUCCESS ? sz_in : line_start;
+    *p_written = writer.written;
+    return res;
+}
+
+// Number of UTF-8 units of the whitespace character at the start of the input, or zero if it is not whitespace.
+static size_t utf8_leading_whitespace_units(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    auto const c = p_in[0];
+    if (c < UTF8_PREFIX_CONTINUATION)
+        return cutf_is_whitespace(c) ? 1 : 0;
+
+    // All non-ASCII whitespace characters start with one of these units, so only decode those
+    if (c != 0xC2 && c != 0xE1 && c != 0xE2 && c != 0xE3)
+        return 0;
+
+    auto const read = utf8_read_in_codepoint(sz_in, p_in, (cutf_state_t){.state_type = CUTF_STATE_CLEAR});
+    if (read.state.state_type != CUTF_STATE_CLEAR || !cutf_is_whitespace(read.state.value))
+        return 0;
+
+    return read.consumed;
+}
+
+// Number of UTF-8 units of the whitespace character at the end of the input, or zero if it is not whitespace.
+static size_t utf8_trailing_whitespace_units(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    auto const c = p_in[sz_in - 1];
+    if (c < UTF8_PREFIX_CONTINUATION)
+        return cutf_is_whitespace(c) ? 1 : 0;
+
+    size_t units;
+    if (cutf_utf8_prev_codepoint(sz_in, p_in, &units) != CUTF_SUCCESS)
+        return 0;
+
+    return utf8_leading_whitespace_units(units, p_in + sz_in - units) == units ? units : 0;
+}
+
+size_t cutf_utf8_skip_whitespace(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    // Runs of spaces (such as indentation) are skipped in whole blocks
+    constexpr uint64_t all_spaces = SWAR_LOW_BITS * u8' ';
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        if (pos + SWAR_BLOCK <= sz_in && swar_load(p_in + pos) == all_spaces)
+        {
+            pos += SWAR_BLOCK;
+            continue;
+        }
+
+        auto const units = utf8_leading_whitespace_units(sz_in - pos, p_in + pos);
+        if (units == 0)
+            break;
+        pos += units;
+    }
+
+    return pos;
+}
+
+cutf_span_t cutf_utf8_trim(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    auto const start = cutf_utf8_skip_whitespace(sz_in, p_in);
+    size_t end = sz_in;
+    while (end > start)
+    {
+        auto const units = utf8_trailing_whitespace_units(end - start, p_in + start);
+        if (units == 0)
+            break;
+        end -= units;
+    }
+
+    return (cutf_span_t){.start = start, .length = end - start};
+}
+
+bool cutf_utf8_split_whitespace(const size_t sz_in, const char8_t p_in[const static sz_in], size_t *const p_pos,
+                                cutf_span_t *const p_span)
+{
+    size_t pos = *p_pos;
+    if (pos < sz_in)
+        pos += cutf_utf8_skip_whitespace(sz_in - pos, p_in + pos);
+
+    if (pos >= sz_in)
+    {
+        *p_pos = sz_in;
+        return false;
+    }
+
+    auto const start = pos;
+    while (pos < sz_in)
+    {
+        // Blocks of printable ASCII characters contain no whitespace
+        if (pos + SWAR_BLOCK <= sz_in)
+        {
+            auto const block = swar_load(p_in + pos);
+            if (((block & SWAR_HIGH_BITS) | swar_mark_less_than(block, 0x21)) == 0)
+            {
+                pos += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        if (utf8_leading_whitespace_units(sz_in - pos, p_in + pos) != 0)
+            break;
+        pos += 1;
+    }
+
+    *p_span = (cutf_span_t){.start = start, .length = pos - start};
+    *p_pos = pos;
+    return true;
+}
+
+bool cutf_is_xid_start(const char32_t c)
+{
+    return c <= UNICODE_MAX_VALUE && (cutf_identifier_lookup(c) & IDENTIFIER_START) != 0;
+}
+
+bool cutf_is_xid_continue(const char32_t c)
+{
+    return c <= UNICODE_MAX_VALUE && (cutf_identifier_lookup(c) & IDENTIFIER_CONTINUE) != 0;
+}
+
+// Mark the bytes of a block of ASCII characters which are letters, digits, or underscores.
+static uint64_t swar_mark_ascii_identifier(const uint64_t v)
+{
+    auto const lower = v | (SWAR_LOW_BITS * 0x20);
+    auto const letters = swar_mark_ascii_less_than(lower, u8'z' + 1) & ~swar_mark_ascii_less_than(lower, u8'a');
+    auto const digits = swar_mark_ascii_less_than(v, u8'9' + 1) & ~swar_mark_ascii_less_than(v, u8'0');
+    return letters | digits | swar_mark_zero(v ^ (SWAR_LOW_BITS * u8'_'));
+}
+
+size_t cutf_utf8_scan_identifier(const size_t sz_in, const char8_t p_in[const static sz_in])
+{
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        // Blocks of ASCII letters, digits and underscores are taken whole, once the identifier has started
+        if (pos != 0 && pos + SWAR_BLOCK <= sz_in)
+        {
+            auto const block = swar_load(p_in + pos);
+            if ((block & SWAR_HIGH_BITS) == 0 && swar_mark_ascii_identifier(block) == SWAR_HIGH_BITS)
+            {
+                pos += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        char32_t c;
+        size_t consumed;
+        if (cutf_inline_utf8_decode(sz_in - pos, p_in + pos, &consumed, &c) != CUTF_SUCCESS)
+            break;
+        if (pos == 0 ? !cutf_is_xid_start(c) && c != U'_' : !cutf_is_xid_continue(c))
+            break;
+        pos += consumed;
+    }
+
+    return pos;
+}
+
+cutf_result_t cutf_iter_next_block(cutf_iter_t *const iter, const size_t sz_out, char32_t p_out[const sz_out],
+                                   size_t *const p_written)
+{
+    size_t pos_out = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_out < sz_out && !cutf_iter_done(iter))
+    {
+        auto const remaining = iter->size - iter->position;
+        // Blocks of ASCII (UTF-8) or units without surrogates (UTF-16) are widened directly
+        if (iter->encoding == CUTF_ENCODING_UTF8 && remaining >= SWAR_BLOCK && sz_out - pos_out >= SWAR_BLOCK &&
+            (swar_load(iter->p8 + iter->position) & SWAR_HIGH_BITS) == 0)
+        {
+            for (unsigned j = 0; j < SWAR_BLOCK; ++j)
+                p_out[pos_out + j] = iter->p8[iter->position + j];
+            iter->position += SWAR_BLOCK;
+            pos_out += SWAR_BLOCK;
+            continue;
+        }
+        if (iter->encoding == CUTF_ENCODING_UTF16 && remaining >= SWAR_BLOCK_16 && sz_out - pos_out >= SWAR_BLOCK_16 &&
+            !swar_has_surrogate_16(swar_load_16(iter->p16 + iter->position)))
+        {
+            for (unsigned j = 0; j < SWAR_BLOCK_16; ++j)
+                p_out[pos_out + j] = iter->p16[iter->position + j];
+            iter->position += SWAR_BLOCK_16;
+            pos_out += SWAR_BLOCK_16;
+            continue;
+        }
+
+        res = cutf_iter_next(iter, p_out + pos_out, nullptr);
+        if (res != CUTF_SUCCESS)
+            break;
+        pos_out += 1;
+    }
+
+    *p_written = pos_out;
+    return res;
+}
+
+// Classes which may follow each class without a break between them, according to the rules GB3 to GB9b and GB12 of
+// UAX #29. The remaining rules look further back than the previous codepoint and are applied by grapheme_joins.
+enum grapheme_joins_t
+{
+    GRAPHEME_JOINS_ALWAYS = 1u << GRAPHEME_EXTEND | 1u << GRAPHEME_ZWJ | 1u << GRAPHEME_SPACING_MARK,
+    GRAPHEME_JOINS_ALL = (1u << GRAPHEME_CLASS_COUNT) - 1,
+    GRAPHEME_JOINS_CONTROLS = 1u << GRAPHEME_CR | 1u << GRAPHEME_LF | 1u << GRAPHEME_CONTROL,
+};
+
+static const uint16_t GRAPHEME_JOINS[GRAPHEME_CLASS_COUNT] = {
+    [GRAPHEME_OTHER] = GRAPHEME_JOINS_ALWAYS,
+    [GRAPHEME_CR] = 1u << GRAPHEME_LF,
+    [GRAPHEME_LF] = 0,
+    [GRAPHEME_CONTROL] = 0,
+    [GRAPHEME_EXTEND] = GRAPHEME_JOINS_ALWAYS,
+    [GRAPHEME_ZWJ] = GRAPHEME_JOINS_ALWAYS,
+    [GRAPHEME_REGIONAL_INDICATOR] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_REGIONAL_INDICATOR,
+    [GRAPHEME_PREPEND] = GRAPHEME_JOINS_ALL & ~GRAPHEME_JOINS_CONTROLS,
+    [GRAPHEME_SPACING_MARK] = GRAPHEME_JOINS_ALWAYS,
+    [GRAPHEME_L] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_L | 1u << GRAPHEME_V | 1u << GRAPHEME_LV | 1u << GRAPHEME_LVT,
+    [GRAPHEME_V] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_V | 1u << GRAPHEME_T,
+    [GRAPHEME_T] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_T,
+    [GRAPHEME_LV] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_V | 1u << GRAPHEME_T,
+    [GRAPHEME_LVT] = GRAPHEME_JOINS_ALWAYS | 1u << GRAPHEME_T,
+};
+
+typedef enum
+{
+    GRAPHEME_SEQUENCE_NONE,    // Not inside a sequence
+    GRAPHEME_SEQUENCE_STARTED, // Inside a sequence which can not be joined yet
+    GRAPHEME_SEQUENCE_JOINED,  // Inside a sequence which joins the next codepoint, if it is of the right kind
+} grapheme_sequence_t;
+
+typedef struct
+{
+    uint8_t previous;                 // Properties of the last codepoint of the cluster
+    bool odd_regional;                // The cluster ends with an odd number of regional indicators
+    grapheme_sequence_t pictographic; // Extended_Pictographic Extend* (started), followed by ZWJ (joined)
+    grapheme_sequence_t conjunct;     // Consonant followed by Extend or Linker (started), including a Linker (joined)
+} grapheme_state_t;
+
+static void grapheme_advance(grapheme_state_t *const state, const uint8_t next)
+{
+    auto const next_class = next & GRAPHEME_CLASS_MASK;
+    auto const next_conjunct = next >> GRAPHEME_CONJUNCT_SHIFT;
+
+    state->odd_regional = next_class == GRAPHEME_REGIONAL_INDICATOR && !state->odd_regional;
+
+    if (next & GRAPHEME_PICTOGRAPHIC)
+        state->pictographic = GRAPHEME_SEQUENCE_STARTED;
+    else if (state->pictographic == GRAPHEME_SEQUENCE_STARTED && next_class == GRAPHEME_EXTEND)
+        state->pictographic = GRAPHEME_SEQUENCE_STARTED;
+    else if (state->pictographic == GRAPHEME_SEQUENCE_STARTED && next_class == GRAPHEME_ZWJ)
+        state->pictographic = GRAPHEME_SEQUENCE_JOINED;
+    else
+        state->pictographic = GRAPHEME_SEQUENCE_NONE;
+
+    if (next_conjunct == GRAPHEME_CONJUNCT_CONSONANT)
+        state->conjunct = GRAPHEME_SEQUENCE_STARTED;
+    else if (state->conjunct != GRAPHEME_SEQUENCE_NONE && next_conjunct == GRAPHEME_CONJUNCT_LINKER)
+        state->conjunct = GRAPHEME_SEQUENCE_JOINED;
+    else if (state->conjunct == GRAPHEME_SEQUENCE_NONE || next_conjunct != GRAPHEME_CONJUNCT_EXTEND)
+        state->conjunct = GRAPHEME_SEQUENCE_NONE;
+
+    state->previous = next;
+}
+
+// Check if there is no break between the cluster so far and the next codepoint, and if so, add it to the cluster.
+static bool grapheme_joins(grapheme_state_t *const state, const uint8_t next)
+{
+    auto const previous_class = state->previous & GRAPHEME_CLASS_MASK;
+    auto const next_class = next & GRAPHEME_CLASS_MASK;
+
+    bool joins = (GRAPHEME_JOINS[previous_class] >> next_class) & 1;
+    // GB12 and GB13, regional indicators are joined in pairs
+    if (previous_class == GRAPHEME_REGIONAL_INDICATOR && next_class == GRAPHEME_REGIONAL_INDICATOR)
+        joins = state->odd_regional;
+    // GB9c, consonants joined by a linker
+    else if (!joins && state->conjunct == GRAPHEME_SEQUENCE_JOINED)
+        joins = next >> GRAPHEME_CONJUNCT_SHIFT == GRAPHEME_CONJUNCT_CONSONANT;
+    // GB11, pictographs joined by a zero width joiner
+    else if (!joins && state->pictographic == GRAPHEME_SEQUENCE_JOINED)
+        joins = (next & GRAPHEME_PICTOGRAPHIC) != 0;
+
+    if (joins)
+        grapheme_advance(state, next);
+    return joins;
+}
+
+static char32_t iter_unit_at(const cutf_iter_t *const iter, const size_t pos)
+{
+    switch (iter->encoding)
+    {
+    case CUTF_ENCODING_UTF8:
+        return iter->p8[pos];
+
+    case CUTF_ENCODING_UTF16:
+        return iter->p16[pos];
+
+    default:
+        return iter->p32[pos];
+    }
+}
+
+// Check if the next unit is an ASCII character other than CR, which is followed by another ASCII character or the end
+// of the string. These form a cluster on their own, without needing to look up their properties.
+static bool grapheme_is_single_ascii(const cutf_iter_t *const iter)
+{
+    auto const first = iter_unit_at(iter, iter->position);
+    return first < 0x80 && first != U'\r' &&
+           (iter->position + 1 == iter->size || iter_unit_at(iter, iter->position + 1) < 0x80);
+}
+
+// Find the number of single unit clusters at the start of a block of ASCII characters without CR.
+static size_t grapheme_ascii_block(const cutf_iter_t *const iter)
+{
+    auto const remaining = iter->size - iter->position;
+    size_t block;
+    switch (iter->encoding)
+    {
+    case CUTF_ENCODING_UTF8: {
+        if (remaining < SWAR_BLOCK)
+            return 0;
+        auto const v = swar_load(iter->p8 + iter->position);
+        if (((v & SWAR_HIGH_BITS) | swar_mark_zero(v ^ (SWAR_LOW_BITS * U'\r'))) != 0)
+            return 0;
+        block = SWAR_BLOCK;
+        break;
+    }
+
+    case CUTF_ENCODING_UTF16: {
+        if (remaining < SWAR_BLOCK_16)
+            return 0;
+        auto const v = swar_load_16(iter->p16 + iter->position);
+        if ((v & SWAR_NON_ASCII_16) != 0 || swar_mark_zero_16(v ^ (SWAR_LOW_BITS_16 * U'\r')) != 0)
+            return 0;
+        block = SWAR_BLOCK_16;
+        break;
+    }
+
+    default:
+        return 0;
+    }
+
+    // The last character of the block may be extended by what follows it
+    if (remaining > block && iter_unit_at(iter, iter->position + block) >= 0x80)
+        return block - 1;
+    return block;
+}
+
+// GB9c looks back past the start of the cluster, as a few linkers are not extending characters, so that a cluster can
+// start with them. Find the state of the conjunct sequence which ends right before the iterator.
+static grapheme_sequence_t grapheme_conjunct_before(const cutf_iter_t *const iter)
+{
+    bool linked = false;
+    for (auto prev = *iter; prev.position != 0;)
+    {
+        size_t length = 1;
+        if (prev.encoding == CUTF_ENCODING_UTF8 &&
+            cutf_utf8_prev_codepoint(prev.position, prev.p8, &length) != CUTF_SUCCESS)
+            break;
+        if (prev.encoding == CUTF_ENCODING_UTF16 &&
+            cutf_utf16_prev_codepoint(prev.position, prev.p16, &length) != CUTF_SUCCESS)
+            break;
+
+        prev.position -= length;
+        auto decoded = prev;
+        char32_t c;
+        if (cutf_iter_next(&decoded, &c, nullptr) != CUTF_SUCCESS)
+            break;
+
+        switch (cutf_grapheme_lookup(c) >> GRAPHEME_CONJUNCT_SHIFT)
+        {
+        case GRAPHEME_CONJUNCT_CONSONANT:
+            return linked ? GRAPHEME_SEQUENCE_JOINED : GRAPHEME_SEQUENCE_STARTED;
+
+        case GRAPHEME_CONJUNCT_LINKER:
+            linked = true;
+            break;
+
+        case GRAPHEME_CONJUNCT_EXTEND:
+            break;
+
+        default:
+            return GRAPHEME_SEQUENCE_NONE;
+        }
+    }
+    return GRAPHEME_SEQUENCE_NONE;
+}
+
+cutf_result_t cutf_iter_next_grapheme(cutf_iter_t *const iter, cutf_span_t *const p_span)
+{
+    if (cutf_iter_done(iter))
+        return CUTF_INCOMPLETE_INPUT;
+
+    auto const start = iter->position;
+    if (grapheme_is_single_ascii(iter))
+        iter->position += 1;
+    else
+    {
+        char32_t c;
+        auto const res = cutf_iter_next(iter, &c, nullptr);
+        if (res != CUTF_SUCCESS)
+            return res;
+
+        auto const first = cutf_grapheme_lookup(c);
+        grapheme_state_t state = {};
+        if (first >> GRAPHEME_CONJUNCT_SHIFT >= GRAPHEME_CONJUNCT_EXTEND)
+        {
+            auto start_iter = *iter;
+            start_iter.position = start;
+            state.conjunct = grapheme_conjunct_before(&start_iter);
+        }
+        grapheme_advance(&state, first);
+        // The cluster also ends before units which can not be decoded, which are reported by the next call
+        for (cutf_iter_t next = *iter; cutf_iter_next(&next, &c, nullptr) == CUTF_SUCCESS &&
+                                       grapheme_joins(&state, cutf_grapheme_lookup(c));)
+            *iter = next;
+    }
+
+    if (p_span)
+        *p_span = (cutf_span_t){.start = start, .length = iter->position - start};
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_iter_skip_graphemes(cutf_iter_t *const iter, const size_t count, size_t *const p_skipped)
+{
+    size_t skipped = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (skipped < count && !cutf_iter_done(iter))
+    {
+        auto const block = grapheme_ascii_block(iter);
+        if (block != 0 && count - skipped >= block)
+        {
+            iter->position += block;
+            skipped += block;
+            continue;
+        }
+
+        res = cutf_iter_next_grapheme(iter, nullptr);
+        if (res != CUTF_SUCCESS)
+            break;
+        skipped += 1;
+    }
+
+    *p_skipped = skipped;
+    return res;
+}
+
+size_t cutf_codepoint_display_width(const char32_t c)
+{
+    return c <= UNICODE_MAX_VALUE ? cutf_width_lookup(c) : 0;
+}
+
+// Columns taken by a grapheme cluster, which are those of its widest codepoint. An emoji presentation selector makes
+// the character before it as wide as an emoji.
+static size_t cluster_display_width(cutf_iter_t cluster)
+{
+    size_t width = 0;
+    char32_t c;
+    while (cutf_iter_next(&cluster, &c, nullptr) == CUTF_SUCCESS)
+    {
+        const size_t columns = c == U'\uFE0F' && width != 0 ? 2 : cutf_width_lookup(c);
+        if (columns > width)
+            width = columns;
+    }
+    return width;
+}
+
+static cutf_result_t utf8_display_width(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                        const size_t max_width, size_t *const p_consumed, size_t *const p_width)
+{
+    auto iter = cutf_iter_utf8(sz_in, p_in);
+    size_t width = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (!cutf_iter_done(&iter))
+    {
+        // Blocks of ASCII followed by ASCII take a column for each character which is not a control character
+        auto const pos = iter.position;
+        if (pos + SWAR_BLOCK <= sz_in && (pos + SWAR_BLOCK == sz_in || p_in[pos + SWAR_BLOCK] < 0x80))
+        {
+            auto const block = swar_load(p_in + pos);
+            if ((block & SWAR_HIGH_BITS) == 0)
+            {
+                auto const controls =
+                    swar_mark_ascii_less_than(block, 0x20) | swar_mark_zero(block ^ (SWAR_LOW_BITS * 0x7F));
+                auto const columns = SWAR_BLOCK - swar_count_marked(controls);
+                if (max_width - width >= columns)
+                {
+                    width += columns;
+                    iter.position += SWAR_BLOCK;
+                    continue;
+                }
+            }
+        }
+
+        auto next = iter;
+        cutf_span_t span;
+        res = cutf_iter_next_grapheme(&next, &span);
+        if (res != CUTF_SUCCESS)
+            break;
+
+        auto const columns = cluster_display_width(cutf_iter_utf8(span.length, p_in + span.start));
+        if (max_width - width < columns)
+            break;
+        width += columns;
+        iter = next;
+    }
+
+    *p_consumed = iter.position;
+    *p_width = width;
+    return res;
+}
+
+cutf_result_t cutf_utf8_display_width(const size_t sz_in, const char8_t p_in[const static sz_in], size_t *const p_valid,
+                                      size_t *const p_width)
+{
+    return utf8_display_width(sz_in, p_in, SIZE_MAX, p_valid, p_width);
+}
+
+cutf_result_t cutf_utf8_truncate_width(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                       const size_t max_width, size_t *const p_consumed, size_t *const p_width)
+{
+    return utf8_display_width(sz_in, p_in, max_width, p_consumed, p_width);
+}
+
+char32_t cutf_simple_casefold(const char32_t c)
+{
+    if (c > UNICODE_MAX_VALUE)
+        return c;
+    return (char32_t)((int32_t)c + cutf_casefold_deltas[cutf_casefold_lookup(c)]);
+}
+
+// Fold the upper case letters of a block of ASCII characters to lower case.
+static uint64_t swar_fold_ascii(const uint64_t v)
+{
+    auto const upper = swar_mark_ascii_less_than(v, u8'Z' + 1) & ~swar_mark_ascii_less_than(v, u8'A');
+    return v | (upper >> 2);
+}
+
+// Case fold UTF-8 into the output, or only count the units of the output if there is none.
+static cutf_result_t utf8_casefold(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                   size_t *const p_consumed, char8_t *const p_out, size_t *const p_written)
+{
+    size_t pos_in = 0, pos_out = 0;
+    cutf_result_t res = CUTF_SUCCESS;
+    while (pos_in < sz_in)
+    {
+        if (pos_in + SWAR_BLOCK <= sz_in && sz_out - pos_out >= SWAR_BLOCK)
+        {
+            auto const block = swar_load(p_in + pos_in);
+            if ((block & SWAR_HIGH_BITS) == 0)
+            {
+                if (p_out)
+                {
+                    auto const folded = swar_fold_ascii(block);
+                    memcpy(p_out + pos_out, &folded, sizeof(folded));
+                }
+                pos_in += SWAR_BLOCK;
+                pos_out += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        char32_t c;
+        size_t consumed;
+        res = cutf_inline_utf8_decode(sz_in - pos_in, p_in + pos_in, &consumed, &c);
+        if (res != CUTF_SUCCESS)
+            break;
+
+        char8_t units[4];
+        auto const length = cutf_inline_utf8_encode(cutf_simple_casefold(c), units);
+        if (sz_out - pos_out < length)
+        {
+            res = CUTF_INSUFFICIENT_BUFFER;
+            break;
+        }
+
+        if (p_out)
+            memcpy(p_out + pos_out, units, length);
+        pos_in += consumed;
+        pos_out += length;
+    }
+
+    *p_consumed = pos_in;
+    *p_written = pos_out;
+    return res;
+}
+
+cutf_result_t cutf_utf8_casefold_count(const size_t sz_in, const char8_t p_in[const static sz_in],
+                                       size_t *const p_valid, size_t *const p_count)
+{
+    return utf8_casefold(sz_in, p_in, SIZE_MAX, p_valid, nullptr, p_count);
+}
+
+cutf_result_t cutf_utf8_casefold(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_out,
+                                 size_t *const p_consumed, char8_t p_out[const sz_out], size_t *const p_written)
+{
+    return utf8_casefold(sz_in, p_in, sz_out, p_consumed, p_out, p_written);
+}
+
+cutf_result_t cutf_utf8_casecmp(const size_t sz_a, const char8_t p_a[const static sz_a], const size_t sz_b,
+                                const char8_t p_b[const static sz_b], int *const p_order)
+{
+    size_t pos_a = 0, pos_b = 0;
+    while (pos_a < sz_a && pos_b < sz_b)
+    {
+        // Blocks of ASCII which are the same after folding are skipped whole
+        if (pos_a + SWAR_BLOCK <= sz_a && pos_b + SWAR_BLOCK <= sz_b)
+        {
+            auto const block_a = swar_load(p_a + pos_a);
+            auto const block_b = swar_load(p_b + pos_b);
+            if (((block_a | block_b) & SWAR_HIGH_BITS) == 0 && swar_fold_ascii(block_a) == swar_fold_ascii(block_b))
+            {
+                pos_a += SWAR_BLOCK;
+                pos_b += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        char32_t c_a, c_b;
+        size_t consumed_a, consumed_b;
+        auto res = cutf_inline_utf8_decode(sz_a - pos_a, p_a + pos_a, &consumed_a, &c_a);
+        if (res != CUTF_SUCCESS)
+            return res;
+        res = cutf_inline_utf8_decode(sz_b - pos_b, p_b + pos_b, &consumed_b, &c_b);
+        if (res != CUTF_SUCCESS)
+            return res;
+
+        c_a = cutf_simple_casefold(c_a);
+        c_b = cutf_simple_casefold(c_b);
+        if (c_a != c_b)
+        {
+            *p_order = c_a < c_b ? -1 : 1;
+            return CUTF_SUCCESS;
+        }
+        pos_a += consumed_a;
+        pos_b += consumed_b;
+    }
+
+    *p_order = (pos_a < sz_a) - (pos_b < sz_b);
+    return CUTF_SUCCESS;
+}
+
+// Hashing of codepoint sequences, which hashes their UTF-8 encoding eight bytes at a time, whatever the encoding of the
+// input is. The mixing follows the 64-bit lanes of MurmurHash3.
+static constexpr uint64_t HASH_K1 = 0x87C37B91114253D5;
+static constexpr uint64_t HASH_K2 = 0x4CF5AD432745937F;
+
+typedef struct
+{
+    uint64_t hash;
+    uint64_t length;
+    size_t sz_pending;
+    char8_t pending[sizeof(uint64_t)];
+} hash_state_t;
+
+static uint64_t hash_rotate(const uint64_t v, const unsigned bits)
+{
+    return (v << bits) | (v >> (64 - bits));
+}
+
+static uint64_t hash_scramble(uint64_t block)
+{
+    block *= HASH_K1;
+    block = hash_rotate(block, 31);
+    return block * HASH_K2;
+}
+
+static void hash_mix(hash_state_t *const state, const char8_t p_in[static SWAR_BLOCK])
+{
+    state->hash = hash_rotate(state->hash ^ hash_scramble(swar_load(p_in)), 27) * 5 + 0x52DCE729;
+}
+
+// Add up to a block of UTF-8 units, mixing in the pending ones once they fill a block.
+static void hash_append(hash_state_t *const state, const char8_t p_in[const], const size_t sz_in)
+{
+    state->length += sz_in;
+    if (state->sz_pending == 0 && sz_in == SWAR_BLOCK)
+    {
+        hash_mix(state, p_in);
+        return;
+    }
+
+    auto const room = SWAR_BLOCK - state->sz_pending;
+    if (sz_in < room)
+    {
+        memcpy(state->pending + state->sz_pending, p_in, sz_in);
+        state->sz_pending += sz_in;
+        return;
+    }
+    memcpy(state->pending + state->sz_pending, p_in, room);
+    hash_mix(state, state->pending);
+    memcpy(state->pending, p_in + room, sz_in - room);
+    state->sz_pending = sz_in - room;
+}
+
+// Add a codepoint as its UTF-8 encoding, failing for values which are not valid codepoints.
+static bool hash_append_codepoint(hash_state_t *const state, const char32_t c)
+{
+    char8_t units[4];
+    auto const length = cutf_inline_utf8_encode(c, units);
+    if (length == 0)
+        return false;
+    hash_append(state, units, length);
+    return true;
+}
+
+static uint64_t hash_finish(hash_state_t *const state)
+{
+    auto hash = state->hash;
+    if (state->sz_pending != 0)
+    {
+        memset(state->pending + state->sz_pending, 0, SWAR_BLOCK - state->sz_pending);
+        hash ^= hash_scramble(swar_load(state->pending));
+    }
+
+    hash ^= state->length;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCD;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53;
+    return hash ^ (hash >> 33);
+}
+
+cutf_result_t cutf_hash_utf8(const size_t sz_in, const char8_t p_in[const static sz_in], const uint64_t seed,
+                             size_t *const p_valid, uint64_t *const p_hash)
+{
+    hash_state_t state = {.hash = seed};
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        if (pos + SWAR_BLOCK <= sz_in && (swar_load(p_in + pos) & SWAR_HIGH_BITS) == 0)
+        {
+            hash_append(&state, p_in + pos, SWAR_BLOCK);
+            pos += SWAR_BLOCK;
+            continue;
+        }
+
+        // Overlong encodings, which would hash differently from the same codepoints in other encodings, are rejected
+        char32_t c;
+        size_t consumed;
+        res = cutf_inline_utf8_decode(sz_in - pos, p_in + pos, &consumed, &c);
+        if (res != CUTF_SUCCESS)
+            break;
+
+        hash_append(&state, p_in + pos, consumed);
+        pos += consumed;
+    }
+
+    *p_valid = pos;
+    *p_hash = hash_finish(&state);
+    return res;
+}
+
+cutf_result_t cutf_hash_utf16(const size_t sz_in, const char16_t p_in[const static sz_in], const uint64_t seed,
+                              size_t *const p_valid, uint64_t *const p_hash)
+{
+    hash_state_t state = {.hash = seed};
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        if (pos + SWAR_BLOCK <= sz_in &&
+            ((swar_load_16(p_in + pos) | swar_load_16(p_in + pos + SWAR_BLOCK_16)) & SWAR_NON_ASCII_16) == 0)
+        {
+            char8_t units[SWAR_BLOCK];
+            for (size_t i = 0; i < SWAR_BLOCK; ++i)
+                units[i] = (char8_t)p_in[pos + i];
+            hash_append(&state, units, SWAR_BLOCK);
+            pos += SWAR_BLOCK;
+            continue;
+        }
+
+        char32_t c;
+        size_t consumed;
+        res = cutf_inline_utf16_decode(sz_in - pos, p_in + pos, &consumed, &c);
+        if (res != CUTF_SUCCESS)
+            break;
+        hash_append_codepoint(&state, c);
+        pos += consumed;
+    }
+
+    *p_valid = pos;
+    *p_hash = hash_finish(&state);
+    return res;
+}
+
+cutf_result_t cutf_hash_utf32(const size_t sz_in, const char32_t p_in[const static sz_in], const uint64_t seed,
+                              size_t *const p_valid, uint64_t *const p_hash)
+{
+    hash_state_t state = {.hash = seed};
+    cutf_result_t res = CUTF_SUCCESS;
+    size_t pos = 0;
+    while (pos < sz_in)
+    {
+        if (pos + SWAR_BLOCK <= sz_in)
+        {
+            char32_t all = 0;
+            char8_t units[SWAR_BLOCK];
+            for (size_t i = 0; i < SWAR_BLOCK; ++i)
+            {
+                all |= p_in[pos + i];
+                units[i] = (char8_t)p_in[pos + i];
+            }
+            if (all < 0x80)
+            {
+                hash_append(&state, units, SWAR_BLOCK);
+                pos += SWAR_BLOCK;
+                continue;
+            }
+        }
+
+        if (!hash_append_codepoint(&state, p_in[pos]))
+        {
+            res = CUTF_INVALID_INPUT;
+            break;
+        }
+        ++pos;
+    }
+
+    *p_valid = pos;
+    *p_hash = hash_finish(&state);
+    return res;
+}
+
+// Narrow the next block of units of the iterator to UTF-8 units, if they are all ASCII.
+static bool compare_ascii_block(const cutf_iter_t *const iter, char8_t p_out[static SWAR_BLOCK])
+{
+    if (iter->size - iter->position < SWAR_BLOCK)
+        return false;
+
+    switch (iter->encoding)
+    {
+    case CUTF_ENCODING_UTF8:
+        memcpy(p_out, iter->p8 + iter->position, SWAR_BLOCK);
+        return (swar_load(p_out) & SWAR_HIGH_BITS) == 0;
+
+    case CUTF_ENCODING_UTF16: {
+        auto const p_in = iter->p16 + iter->position;
+        if (((swar_load_16(p_in) | swar_load_16(p_in + SWAR_BLOCK_16)) & SWAR_NON_ASCII_16) != 0)
+            return false;
+        for (size_t i = 0; i < SWAR_BLOCK; ++i)
+            p_out[i] = (char8_t)p_in[i];
+        return true;
+    }
+
+    case CUTF_ENCODING_UTF32: {
+        auto const p_in = iter->p32 + iter->position;
+        char32_t all = 0;
+        for (size_t i = 0; i < SWAR_BLOCK; ++i)
+        {
+            all |= p_in[i];
+            p_out[i] = (char8_t)p_in[i];
+        }
+        return all < 0x80;
+    }
+
+    default:
+        return false;
+    }
+}
+
+// Compare the codepoints of two strings in any encoding, stopping at the first one which differs.
+static cutf_result_t compare_iters(cutf_iter_t a, cutf_iter_t b, int *const p_order)
+{
+    while (!cutf_iter_done(&a) && !cutf_iter_done(&b))
+    {
+        char8_t block_a[SWAR_BLOCK], block_b[SWAR_BLOCK];
+        if (compare_ascii_block(&a, block_a) && compare_ascii_block(&b, block_b))
+        {
+            auto const cmp = memcmp(block_a, block_b, SWAR_BLOCK);
+            if (cmp != 0)
+            {
+                *p_order = cmp < 0 ? -1 : 1;
+                return CUTF_SUCCESS;
+            }
+            a.position += SWAR_BLOCK;
+            b.position += SWAR_BLOCK;
+            continue;
+        }
+
+        char32_t c_a, c_b;
+        auto res = cutf_iter_next(&a, &c_a, nullptr);
+        if (res != CUTF_SUCCESS)
+            return res;
+        res = cutf_iter_next(&b, &c_b, nullptr);
+        if (res != CUTF_SUCCESS)
+            return res;
+
+        if (c_a != c_b)
+        {
+            *p_order = c_a < c_b ? -1 : 1;
+            return CUTF_SUCCESS;
+        }
+    }
+
+    *p_order = !cutf_iter_done(&a) - !cutf_iter_done(&b);
+    return CUTF_SUCCESS;
+}
+
+cutf_result_t cutf_compare_s8_s16(const size_t sz_a, const char8_t p_a[const static sz_a], const size_t sz_b,
+                                  const char16_t p_b[const static sz_b], int *const p_order)
+{
+    return compare_iters(cutf_iter_utf8(sz_a, p_a), cutf_iter_utf16(sz_b, p_b), p_order);
+}
+
+cutf_result_t cutf_compare_s8_s32(const size_t sz_a, const char8_t p_a[const static sz_a], const size_t sz_b,
+                                  const char32_t p_b[const static sz_b], int *const p_order)
+{
+    return compare_iters(cutf_iter_utf8(sz_a, p_a), cutf_iter_utf32(sz_b, p_b), p_order);
+}
+
+cutf_result_t cutf_compare_s16_s32(const size_t sz_a, const char16_t p_a[const static sz_a], const size_t sz_b,
+                                   const char32_t p_b[const static sz_b], int *const p_order)
+{
+    return compare_iters(cutf_iter_utf16(sz_a, p_a), cutf_iter_utf32(sz_b, p_b), p_order);
+}
+
+cutf_result_t cutf_compare_s16_s16(const size_t sz_a, const char16_t p_a[const static sz_a], const size_t sz_b,
+                                   const char16_t p_b[const static sz_b], int *const p_order)
+{
+    return compare_iters(cutf_iter_utf16(sz_a, p_a), cutf_iter_utf16(sz_b, p_b), p_order);
+}
+
+// Check that a match of the needle ends on a codepoint boundary. It starts on one, as the needle does not start with a
+// continuation unit.
+static bool find_ends_on_boundary(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t end)
+{
+    return end == sz_in || (p_in[end] & 0xC0) != UTF8_PREFIX_CONTINUATION;
+}
+
+// Check if any of the positions of a block of the input has both the first and the last unit of the needle, given as
+// repeated in every byte.
+static bool find_has_candidate(const char8_t *const p_in, const size_t sz_needle, const uint64_t first,
+                               const uint64_t last)
+{
+    return (swar_mark_zero(swar_load(p_in) ^ first) & swar_mark_zero(swar_load(p_in + sz_needle - 1) ^ last)) != 0;
+}
+
+bool cutf_utf8_find(const size_t sz_in, const char8_t p_in[const static sz_in], const size_t sz_needle,
+                    const char8_t p_needle[const static sz_needle], size_t *const p_offset,
+                    size_t *const p_codepoint_offset)
+{
+    if (sz_needle > sz_in || (sz_needle != 0 && (p_needle[0] & 0xC0) == UTF8_PREFIX_CONTINUATION))
+        return false;
+
+    size_t pos = 0;
+    if (sz_needle != 0)
+    {
+        auto const first = SWAR_LOW_BITS * p_needle[0];
+        auto const last = SWAR_LOW_BITS * p_needle[sz_needle - 1];
+        auto const last_start = sz_in - sz_needle;
+        for (;; ++pos)
+        {
+            // Blocks of positions where the first and last units of the needle do not both match are skipped whole
+            while (pos + SWAR_BLOCK <= last_start + 1 && !find_has_candidate(p_in + pos, sz_needle, first, last))
+                pos += SWAR_BLOCK;
+
+            if (pos > last_start)
+                return false;
+            if (p_in[pos] == p_needle[0] && memcmp(p_in + pos + 1, p_needle + 1, sz_needle - 1) == 0 &&
+                find_ends_on_boundary(sz_in, p_in, pos + sz_needle))
+                break;
+        }
+    }
+
+    *p_offset = pos;
+    if (p_codepoint_offset)
+        *p_codepoint_offset = cutf_count_s8asc32_complete(pos, p_in);
+    return true;
+}
+
+bool cutf_utf8_find_codepoint(const size_t sz_in, const char8_t p_in[const static sz_in], const char32_t c,
+                              size_t *const p_offset, size_t *const p_codepoint_offset)
+{
+    char8_t units[4];
+    auto const length = cutf_inline_utf8_encode(c, units);
+    return length != 0 && cutf_utf8_find(sz_in, p_in, length, units, p_offset, p_codepoint_offset);
 }
@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/cutf_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Number of input bytes converted before the pages of the mappings which were processed are released, so that the
+// memory used stays bounded no matter how large the files are.
+static constexpr size_t FILE_CHUNK_SIZE = 64 << 20;
+
+typedef struct
+{
+    unsigned char *p_data;
+    size_t size;
+} file_mapping_t;
+
+static bool map_file(const int fd, const size_t size, const bool writable, file_mapping_t *const p_mapping)
+{
+    *p_mapping = (file_mapping_t){.p_data = nullptr, .size = size};
+    // Empty files can not be mapped, but there is nothing to access either
+    if (size == 0)
+        return true;
+
+    auto const p_data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                             writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (p_data == MAP_FAILED)
+        return false;
+
+    // Both files are accessed from start to end
+    posix_madvise(p_data, size, POSIX_MADV_SEQUENTIAL);
+    p_mapping->p_data = p_data;
+    return true;
+}
+
+static void unmap_file(const file_mapping_t mapping)
+{
+    if (mapping.p_data)
+        munmap(mapping.p_data, mapping.size);
+}
+
+// Release the whole pages between the offsets, which are no longer needed. Their contents stay in the page cache.
+static void release_pages(const file_mapping_t mapping, const size_t begin, const size_t end)
+{
+#ifdef MADV_DONTNEED
+    auto const page_size = (size_t)sysconf(_SC_PAGESIZE);
+    auto const first = (begin + page_size - 1) / page_size * page_size;
+    auto const last = end / page_size * page_size;
+    if (first < last)
+        madvise(mapping.p_data + first, last - first, MADV_DONTNEED);
+#else
+    (void)mapping;
+    (void)begin;
+    (void)end;
+#endif
+}
+
+static cutf_result_t convert_mappings(const file_mapping_t in, const cutf_encoding_t from, const file_mapping_t out,
+                                      const cutf_encoding_t to)
+{
+    auto const in_unit = cutf_encoding_unit_size(from);
+    auto const out_unit = cutf_encoding_unit_size(to);
+    cutf_state_t state = CUTF_STATE_INITIALIZER;
+    size_t pos_in = 0, pos_out = 0;
+    while (pos_in < in.size)
+    {
+        auto const chunk = in.size - pos_in < FILE_CHUNK_SIZE ? in.size - pos_in : FILE_CHUNK_SIZE;
+        size_t consumed, written;
+        auto const res = cutf_convert(from, chunk / in_unit, in.p_data + pos_in, to, (out.size - pos_out) / out_unit,
+                                      &consumed, out.p_data + pos_out, &written, &state);
+        // Codepoints may be split between chunks, which is fine, since the state carries them over
+        if (res != CUTF_SUCCESS && res != CUTF_INCOMPLETE_INPUT)
+            return res;
+
+        release_pages(in, pos_in, pos_in + consumed * in_unit);
+        release_pages(out, pos_out, pos_out + written * out_unit);
+        pos_in += consumed * in_unit;
+        pos_out += written * out_unit;
+    }
+
+    return cutf_state_is_clean(state) ? CUTF_SUCCESS : CUTF_INCOMPLETE_INPUT;
+}
+
+cutf_result_t cutf_convert_file(const char *const in_path, const cutf_encoding_t from, const char *const out_path,
+                                const cutf_encoding_t to, size_t *const p_written)
+{
+    auto const in_unit = cutf_encoding_unit_size(from);
+    auto const out_unit = cutf_encoding_unit_size(to);
+    if (in_unit == 0 || out_unit == 0)
+        return CUTF_INVALID_INPUT;
+
+    auto const in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0)
+        return CUTF_FILE_ERROR;
+
+    struct stat in_stat;
+    if (fstat(in_fd, &in_stat) != 0 || (uintmax_t)in_stat.st_size > SIZE_MAX)
+    {
+        close(in_fd);
+        return CUTF_FILE_ERROR;
+    }
+    auto const in_size = (size_t)in_stat.st_size;
+
+    file_mapping_t in;
+    if (!map_file(in_fd, in_size, false, &in))
+    {
+        close(in_fd);
+        return CUTF_FILE_ERROR;
+    }
+    close(in_fd);
+
+    // Counting checks the whole input, so the output is not created for input which can not be converted
+    size_t valid_count, out_units;
+    auto res = in_size % in_unit != 0
+                   ? CUTF_INCOMPLETE_INPUT
+                   : cutf_count_converted(from, in_size / in_unit, in.p_data, to, &valid_count, &out_units);
+    if (res != CUTF_SUCCESS)
+    {
+        unmap_file(in);
+        return res;
+    }
+
+    // The output is only truncated once it is known not to be the input, which is still being read from its mapping
+    auto const out_fd = open(out_path, O_RDWR | O_CREAT, 0666);
+    struct stat out_stat;
+    if (out_fd < 0 || fstat(out_fd, &out_stat) != 0)
+    {
+        if (out_fd >= 0)
+            close(out_fd);
+        unmap_file(in);
+        return CUTF_FILE_ERROR;
+    }
+    if (out_stat.st_dev == in_stat.st_dev && out_stat.st_ino == in_stat.st_ino)
+    {
+        close(out_fd);
+        unmap_file(in);
+        errno = EINVAL;
+        return CUTF_FILE_ERROR;
+    }
+
+    file_mapping_t out = {0};
+    if (ftruncate(out_fd, 0) != 0 || ftruncate(out_fd, (off_t)(out_units * out_unit)) != 0 ||
+        !map_file(out_fd, out_units * out_unit, true, &out))
+    {
+        close(out_fd);
+        unmap_file(in);
+        return CUTF_FILE_ERROR;
+    }
+    close(out_fd);
+
+    res = convert_mappings(in, from, out, to);
+    unmap_file(in);
+    unmap_file(out);
+
+    if (res == CUTF_SUCCESS)
+        *p_written = out_units;
+    return res;
+}
@@ -0,0 +1,91 @@
+// Generated by tools/gen_unicode_tables.py from Unicode 17.0, do not edit.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <uchar.h>
+
+enum
+{
+    CUTF_TABLE_SHIFT = 7,
+    CUTF_TABLE_MASK = (1 << CUTF_TABLE_SHIFT) - 1,
+};
+
+// Grapheme_Cluster_Break, Extended_Pictographic and Indic_Conjunct_Break
+typedef enum
+{
+    GRAPHEME_OTHER,
+    GRAPHEME_CR,
+    GRAPHEME_LF,
+    GRAPHEME_CONTROL,
+    GRAPHEME_EXTEND,
+    GRAPHEME_ZWJ,
+    GRAPHEME_REGIONAL_INDICATOR,
+    GRAPHEME_PREPEND,
+    GRAPHEME_SPACING_MARK,
+    GRAPHEME_L,
+    GRAPHEME_V,
+    GRAPHEME_T,
+    GRAPHEME_LV,
+    GRAPHEME_LVT,
+    GRAPHEME_CLASS_COUNT,
+    GRAPHEME_CLASS_MASK = 0x0F,
+    GRAPHEME_PICTOGRAPHIC = 0x10, // Extended_Pictographic
+} grapheme_class_t;
+
+typedef enum
+{
+    GRAPHEME_CONJUNCT_NONE,
+    GRAPHEME_CONJUNCT_CONSONANT,
+    GRAPHEME_CONJUNCT_EXTEND,
+    GRAPHEME_CONJUNCT_LINKER,
+    GRAPHEME_CONJUNCT_SHIFT = 5,
+} grapheme_conjunct_t;
+
+extern const uint8_t cutf_grapheme_stage1[8704];
+extern const uint8_t cutf_grapheme_stage2[21120];
+
+static inline uint8_t cutf_grapheme_lookup(const char32_t c)
+{
+    return cutf_grapheme_stage2[(size_t)cutf_grapheme_stage1[c >> CUTF_TABLE_SHIFT] << CUTF_TABLE_SHIFT |
+                                (c & CUTF_TABLE_MASK)];
+}
+
+// Display width in columns
+
+extern const uint8_t cutf_width_stage1[8704];
+extern const uint8_t cutf_width_stage2[28032];
+
+static inline uint8_t cutf_width_lookup(const char32_t c)
+{
+    return cutf_width_stage2[(size_t)cutf_width_stage1[c >> CUTF_TABLE_SHIFT] << CUTF_TABLE_SHIFT |
+                             (c & CUTF_TABLE_MASK)];
+}
+
+// XID_Start and XID_Continue
+typedef enum
+{
+    IDENTIFIER_START = 1,
+    IDENTIFIER_CONTINUE = 2,
+} identifier_class_t;
+
+extern const uint8_t cutf_identifier_stage1[8704];
+extern const uint8_t cutf_identifier_stage2[26880];
+
+static inline uint8_t cutf_identifier_lookup(const char32_t c)
+{
+    return cutf_identifier_stage2[(size_t)cutf_identifier_stage1[c >> CUTF_TABLE_SHIFT] << CUTF_TABLE_SHIFT |
+                                  (c & CUTF_TABLE_MASK)];
+}
+
+// Simple case folding, as the index of the difference to the folded codepoint in cutf_casefold_deltas
+extern const int32_t cutf_casefold_deltas[104];
+
+extern const uint8_t cutf_casefold_stage1[8704];
+extern const uint8_t cutf_casefold_stage2[5248];
+
+static inline uint8_t cutf_casefold_lookup(const char32_t c)
+{
+    return cutf_casefold_stage2[(size_t)cutf_casefold_stage1[c >> CUTF_TABLE_SHIFT] << CUTF_TABLE_SHIFT |
+                                (c & CUTF_TABLE_MASK)];
+}
@@ -0,0 +1,72 @@
+#include "test_common.h"
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        // Walk backwards through the string, recording the boundaries
+        bool boundary8[256] = {0}, boundary16[256] = {0};
+        size_t starts8[256], starts16[256];
+        size_t pos8 = test_pairs[i].sz8, pos16 = test_pairs[i].sz16;
+        boundary8[pos8] = boundary16[pos16] = true;
+        for (size_t j = test_pairs[i].sz32; j > 0; --j)
+        {
+            size_t consumed;
+            TEST_ASSERT(cutf_utf8_prev_codepoint(pos8, test_pairs[i].p8, &consumed) == CUTF_SUCCESS);
+            pos8 -= consumed;
+            TEST_ASSERT(cutf_utf16_prev_codepoint(pos16, test_pairs[i].p16, &consumed) == CUTF_SUCCESS);
+            pos16 -= consumed;
+            boundary8[pos8] = boundary16[pos16] = true;
+            starts8[j - 1] = pos8;
+            starts16[j - 1] = pos16;
+        }
+        TEST_ASSERT(pos8 == 0 && pos16 == 0);
+
+        // Snapping gives the nearest boundary before each offset
+        size_t last8 = 0, last16 = 0;
+        for (size_t offset = 0; offset <= test_pairs[i].sz8 + 1; ++offset)
+        {
+            if (offset <= test_pairs[i].sz8 && boundary8[offset])
+                last8 = offset;
+            TEST_ASSERT(cutf_utf8_snap_boundary(test_pairs[i].sz8, test_pairs[i].p8, offset) == last8);
+        }
+        for (size_t offset = 0; offset <= test_pairs[i].sz16 + 1; ++offset)
+        {
+            if (offset <= test_pairs[i].sz16 && boundary16[offset])
+                last16 = offset;
+            TEST_ASSERT(cutf_utf16_snap_boundary(test_pairs[i].sz16, test_pairs[i].p16, offset) == last16);
+        }
+
+        // Seeking back by a number of codepoints agrees with walking backwards
+        for (size_t count = 1; count <= test_pairs[i].sz32; ++count)
+        {
+            size_t offset;
+            TEST_ASSERT(cutf_utf8_seek_back(test_pairs[i].sz8, test_pairs[i].p8, count, &offset) == CUTF_SUCCESS);
+            TEST_ASSERT(offset == starts8[test_pairs[i].sz32 - count]);
+            TEST_ASSERT(cutf_utf16_seek_back(test_pairs[i].sz16, test_pairs[i].p16, count, &offset) == CUTF_SUCCESS);
+            TEST_ASSERT(offset == starts16[test_pairs[i].sz32 - count]);
+        }
+        size_t offset;
+        TEST_ASSERT(cutf_utf8_seek_back(test_pairs[i].sz8, test_pairs[i].p8, test_pairs[i].sz32 + 1, &offset) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf16_seek_back(test_pairs[i].sz16, test_pairs[i].p16, test_pairs[i].sz32 + 1, &offset) ==
+                    CUTF_INCOMPLETE_INPUT);
+    }
+
+    // Errors
+    {
+        size_t consumed;
+        TEST_ASSERT(cutf_utf8_prev_codepoint(0, u8"", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf8_prev_codepoint(3, u8"a\xE3\x81", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf8_prev_codepoint(2, u8"\x81\x81", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf8_prev_codepoint(3, u8"\xC3\x81\x81", &consumed) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_utf8_prev_codepoint(5, u8"a\x81\x81\x81\x81", &consumed) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_utf8_snap_boundary(5, u8"a\x81\x81\x81\x81", 4) == 4);
+        TEST_ASSERT(cutf_utf16_prev_codepoint(0, u"", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf16_prev_codepoint(2, u"a\xD800", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf16_prev_codepoint(1, u"\xDC00", &consumed) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf16_prev_codepoint(2, u"a\xDC00", &consumed) == CUTF_INVALID_INPUT);
+    }
+
+    return 0;
+}
@@ -17,5 +17,25 @@ int main(void)
         TEST_ASSERT(memcmp(out, test_pairs[i].p32, test_pairs[i].sz32 * sizeof(char32_t)) == 0);
     }
 
+    // Check the conversion is correct when the input is split into two parts at any point
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        for (size_t split = 0; split <= test_pairs[i].sz16; ++split)
+        {
+            size_t consumed, written1, written2;
+            cutf_state_t ctx = {0};
+            auto const sz_out = sizeof(out) / sizeof(*out);
+            auto res = cutf_s16tos32(split, test_pairs[i].p16, sz_out, &consumed, out, &written1, &ctx);
+            TEST_ASSERT(res == CUTF_SUCCESS || res == CUTF_INCOMPLETE_INPUT);
+            TEST_ASSERT(consumed == split);
+            res = cutf_s16tos32(test_pairs[i].sz16 - split, test_pairs[i].p16 + split, sz_out - written1, &consumed,
+                                out + written1, &written2, &ctx);
+            TEST_ASSERT(res == CUTF_SUCCESS);
+            TEST_ASSERT(consumed == test_pairs[i].sz16 - split);
+            TEST_ASSERT(written1 + written2 == test_pairs[i].sz32);
+            TEST_ASSERT(memcmp(out, test_pairs[i].p32, test_pairs[i].sz32 * sizeof(char32_t)) == 0);
+        }
+    }
+
     return 0;
 }
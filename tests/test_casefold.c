@@ -0,0 +1,146 @@
+#include "test_common.h"
+#include <string.h>
+
+enum
+{
+    SZ_BUFFER = 64,
+};
+
+typedef struct
+{
+    const char8_t *str;
+    const char8_t *folded;
+} casefold_case_t;
+
+static const casefold_case_t cases[] = {
+    {u8"", u8""},
+    {u8"Hello, World!", u8"hello, world!"},
+    {u8"ABCDEFGHIJKLMNOPQRSTUVWXYZ@[`{", u8"abcdefghijklmnopqrstuvwxyz@[`{"},
+    {u8"\u212AKelvin", u8"kkelvin"},                                            // Kelvin sign folds to fewer units
+    {u8"STRA\u1E9EE", u8"stra\u00DFe"},                                         // Capital sharp s
+    {u8"\u023A\u023E", u8"\u2C65\u2C66"},                                       // Folding to more units
+    {u8"\u03A3\u03C2\u03C3", u8"\u03C3\u03C3\u03C3"},                           // Final sigma
+    {u8"\uAB70\u13F8", u8"\u13A0\u13F0"},                                       // Cherokee folds to upper case
+    {u8"\U00010400\U0001E900", u8"\U00010428\U0001E922"},                       // Deseret and Adlam
+    {u8"\u00C9T\u00C9 \u65E5 \U0001F600", u8"\u00E9t\u00E9 \u65E5 \U0001F600"}, // Uncased characters
+};
+
+static const size_t num_cases = sizeof(cases) / sizeof(*cases);
+
+static int casecmp(const char8_t *const a, const char8_t *const b)
+{
+    int order = 2;
+    TEST_ASSERT(cutf_utf8_casecmp(strlen((const char *)a), a, strlen((const char *)b), b, &order) == CUTF_SUCCESS);
+    return order;
+}
+
+int main(void)
+{
+    // Single codepoints
+    TEST_ASSERT(cutf_simple_casefold(U'A') == U'a' && cutf_simple_casefold(U'a') == U'a');
+    TEST_ASSERT(cutf_simple_casefold(U'\u212A') == U'k' && cutf_simple_casefold(U'\u1E9E') == U'\u00DF');
+    TEST_ASSERT(cutf_simple_casefold(U'\u0130') == U'\u0130' && cutf_simple_casefold(U'\u00DF') == U'\u00DF');
+    TEST_ASSERT(cutf_simple_casefold(U'1') == U'1' && cutf_simple_casefold(0x110000) == 0x110000);
+
+    for (unsigned i = 0; i < num_cases; ++i)
+    {
+        auto const str = cases[i].str;
+        auto const sz = strlen((const char *)str);
+        auto const sz_folded = strlen((const char *)cases[i].folded);
+
+        size_t valid, count;
+        TEST_ASSERT(cutf_utf8_casefold_count(sz, str, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == sz && count == sz_folded);
+
+        char8_t out[SZ_BUFFER];
+        size_t consumed, written;
+        TEST_ASSERT(cutf_utf8_casefold(sz, str, sizeof(out), &consumed, out, &written) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == sz && written == sz_folded && memcmp(out, cases[i].folded, written) == 0);
+
+        // Outputs which are too small take whole codepoints only, and folding resumes from there
+        for (size_t sz_out = 0; sz_out < sz_folded; ++sz_out)
+        {
+            TEST_ASSERT(cutf_utf8_casefold(sz, str, sz_out, &consumed, out, &written) == CUTF_INSUFFICIENT_BUFFER);
+            TEST_ASSERT(written <= sz_out);
+            size_t rest;
+            TEST_ASSERT(cutf_utf8_casefold(sz - consumed, str + consumed, sizeof(out) - written, &consumed,
+                                           out + written, &rest) == CUTF_SUCCESS);
+            TEST_ASSERT(written + rest == sz_folded && memcmp(out, cases[i].folded, sz_folded) == 0);
+        }
+
+        TEST_ASSERT(casecmp(str, cases[i].folded) == 0 && casecmp(cases[i].folded, str) == 0);
+    }
+
+    // Incomplete and invalid input
+    {
+        char8_t out[SZ_BUFFER];
+        size_t consumed, written;
+        TEST_ASSERT(cutf_utf8_casefold(4, u8"ABC\xC3", sizeof(out), &consumed, out, &written) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 3 && written == 3 && memcmp(out, u8"abc", 3) == 0);
+        TEST_ASSERT(cutf_utf8_casefold(4, u8"AB\x80" "C", sizeof(out), &consumed, out, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 2 && written == 2);
+        TEST_ASSERT(cutf_utf8_casefold(4, u8"\xED\xA0\x80" "A", sizeof(out), &consumed, out, &written) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 0 && written == 0);
+
+        // Overlong sequences, surrogates and values beyond U+10FFFF are rejected rather than folded
+        const char8_t *const invalid[] = {u8"AB\xC1\x81", u8"AB\xE0\x80\x80", u8"AB\xED\xB0\x80",
+                                          u8"AB\xF4\x90\x80\x80", u8"AB\xF7\xBF\xBF\xBF"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        {
+            auto const sz = strlen((const char *)invalid[i]);
+            TEST_ASSERT(cutf_utf8_casefold(sz, invalid[i], sizeof(out), &consumed, out, &written) ==
+                        CUTF_INVALID_INPUT);
+            TEST_ASSERT(consumed == 2 && written == 2 && memcmp(out, u8"ab", 2) == 0);
+            size_t valid, count;
+            TEST_ASSERT(cutf_utf8_casefold_count(sz, invalid[i], &valid, &count) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2 && count == 2);
+            int order;
+            TEST_ASSERT(cutf_utf8_casecmp(sz, invalid[i], sz, invalid[i], &order) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(cutf_utf8_casecmp(3, u8"abA", sz, invalid[i], &order) == CUTF_INVALID_INPUT);
+        }
+
+        size_t valid, count;
+        TEST_ASSERT(cutf_utf8_casefold_count(12, u8"ABCDEFGHIJ\xC3\xA9", &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == 12 && count == 12);
+        TEST_ASSERT(cutf_utf8_casefold_count(11, u8"ABCDEFGHIJ\xC3", &valid, &count) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(valid == 10 && count == 10);
+    }
+
+    // Ordering by the first folded codepoint which differs
+    TEST_ASSERT(casecmp(u8"apple", u8"BANANA") < 0 && casecmp(u8"BANANA", u8"apple") > 0);
+    TEST_ASSERT(casecmp(u8"abc", u8"ABCD") < 0 && casecmp(u8"ABCD", u8"abc") > 0);
+    TEST_ASSERT(casecmp(u8"a_long_ASCII_prefix_x", u8"A_LONG_ascii_PREFIX_Y") < 0);
+    TEST_ASSERT(casecmp(u8"A_LONG_ASCII_PREFIX_[", u8"a_long_ascii_prefix_a") < 0); // Upper case is folded to lower
+    TEST_ASSERT(casecmp(u8"Stra\u1E9Ee", u8"STRA\u00DFE") == 0);
+    TEST_ASSERT(casecmp(u8"\u00E9", u8"f") > 0 && casecmp(u8"\u00C9", u8"\u00E9") == 0);
+    {
+        int order;
+        TEST_ASSERT(cutf_utf8_casecmp(2, u8"a\x80", 2, u8"ab", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_utf8_casecmp(2, u8"a\x80", 2, u8"bb", &order) == CUTF_SUCCESS && order < 0);
+    }
+
+    // Every ASCII character in every position of the blocks
+    for (unsigned c = 1; c < 0x80; ++c)
+    {
+        auto const folded = (c >= u8'A' && c <= u8'Z') ? c + 0x20 : c;
+        for (size_t pos = 0; pos < 24; ++pos)
+        {
+            char8_t str[24], out[24];
+            memset(str, u8'Q', sizeof(str));
+            str[pos] = (char8_t)c;
+            size_t consumed, written;
+            TEST_ASSERT(cutf_utf8_casefold(sizeof(str), str, sizeof(out), &consumed, out, &written) == CUTF_SUCCESS);
+            TEST_ASSERT(written == sizeof(str) && out[pos] == folded && out[pos ? 0 : 1] == u8'q');
+
+            char8_t lower[24];
+            memset(lower, u8'q', sizeof(lower));
+            lower[pos] = (char8_t)folded;
+            int order;
+            TEST_ASSERT(cutf_utf8_casecmp(sizeof(str), str, sizeof(lower), lower, &order) == CUTF_SUCCESS);
+            TEST_ASSERT(order == 0);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "test_common.h"
+#include <string.h>
+
+enum
+{
+    SZ_BUFFER = 32,
+};
+
+typedef struct
+{
+    size_t sz8, sz16, sz32;
+    char8_t p8[4 * SZ_BUFFER];
+    char16_t p16[2 * SZ_BUFFER];
+    char32_t p32[SZ_BUFFER];
+} encoded_t;
+
+static encoded_t encode(const size_t sz32, const char32_t p32[const static sz32])
+{
+    encoded_t str = {.sz32 = sz32};
+    memcpy(str.p32, p32, sz32 * sizeof(*p32));
+    size_t consumed;
+    cutf_state_t state = {0};
+    TEST_ASSERT(cutf_s32tos8(sz32, p32, sizeof(str.p8), &consumed, str.p8, &str.sz8, &state) == CUTF_SUCCESS);
+    TEST_ASSERT(cutf_s32tos16(sz32, p32, 2 * SZ_BUFFER, &consumed, str.p16, &str.sz16, &state) == CUTF_SUCCESS);
+    return str;
+}
+
+// Order of the codepoints, which is the order of the UTF-32 units
+static int reference_order(const encoded_t *const a, const encoded_t *const b)
+{
+    for (size_t i = 0; i < a->sz32 && i < b->sz32; ++i)
+    {
+        if (a->p32[i] != b->p32[i])
+            return a->p32[i] < b->p32[i] ? -1 : 1;
+    }
+    return (a->sz32 > b->sz32) - (a->sz32 < b->sz32);
+}
+
+static void check_order(const encoded_t *const a, const encoded_t *const b)
+{
+    auto const expected = reference_order(a, b);
+    int order = 2;
+    TEST_ASSERT(cutf_compare_s8_s16(a->sz8, a->p8, b->sz16, b->p16, &order) == CUTF_SUCCESS && order == expected);
+    TEST_ASSERT(cutf_compare_s8_s32(a->sz8, a->p8, b->sz32, b->p32, &order) == CUTF_SUCCESS && order == expected);
+    TEST_ASSERT(cutf_compare_s16_s32(a->sz16, a->p16, b->sz32, b->p32, &order) == CUTF_SUCCESS && order == expected);
+    TEST_ASSERT(cutf_compare_s16_s16(a->sz16, a->p16, b->sz16, b->p16, &order) == CUTF_SUCCESS && order == expected);
+}
+
+static const char32_t *const strings[] = {
+    U"",
+    U"a",
+    U"ab",
+    U"b",
+    U"abcdefghijklmnopqrstuvwxyz",
+    U"abcdefghijklmnopqrstuvwxyZ",
+    U"abcdefghijklmnopqrstuvwxyz0",
+    U"abcdefgh\u00E9",
+    U"abcdefgh\uFF5E",
+    U"abcdefgh\U0001F600", // Before U+FF5E in the order of UTF-16 units, but after it in codepoint order
+    U"abcdefgh\U0001F600z",
+    U"\uE000",
+    U"\uD7FF",
+    U"\U00010000",
+    U"\U0010FFFF",
+    U"\u65E5\u672C\u8A9E",
+    U"\u65E5\u672C\u8A9E abcdefghijklmnop",
+    U"\u65E5\u672C\u8A9E abcdefghijklmnoq",
+};
+
+static const size_t num_strings = sizeof(strings) / sizeof(*strings);
+
+static size_t length(const char32_t *const str)
+{
+    size_t sz = 0;
+    while (str[sz])
+        ++sz;
+    return sz;
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_strings; ++i)
+    {
+        for (unsigned j = 0; j < num_strings; ++j)
+        {
+            auto const a = encode(length(strings[i]), strings[i]);
+            auto const b = encode(length(strings[j]), strings[j]);
+            check_order(&a, &b);
+        }
+    }
+
+    // A single difference at every position, before, inside and after blocks of ASCII
+    for (size_t pos = 0; pos < SZ_BUFFER; ++pos)
+    {
+        char32_t str[SZ_BUFFER];
+        for (size_t i = 0; i < SZ_BUFFER; ++i)
+            str[i] = U'a' + i % 26;
+        auto const a = encode(SZ_BUFFER, str);
+        for (const char32_t *c = U"\x01`b\u00FF\uFFFD\U0001F600"; *c; ++c)
+        {
+            str[pos] = *c;
+            auto const b = encode(SZ_BUFFER, str);
+            check_order(&a, &b);
+            check_order(&b, &a);
+        }
+    }
+
+    // Strings which are not correctly encoded before the first difference
+    {
+        int order;
+        TEST_ASSERT(cutf_compare_s8_s16(2, u8"a\x80", 2, u"ab", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s8_s16(2, u8"a\xC3", 2, u"ab", &order) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_compare_s8_s16(2, u8"\xC1\x81", 1, u"A", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s8_s32(3, u8"\xED\xA0\x80", 1, U"\xD800", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s8_s32(4, u8"\xF4\x90\x80\x80", 1, U"\x110000", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s16_s32(1, u"\xDC00", 1, U"a", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s16_s32(1, u"a", 1, U"\x110000", &order) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_compare_s16_s16(2, u"a\xD83D", 2, u"ab", &order) == CUTF_INCOMPLETE_INPUT);
+
+        // Once a difference is found, the rest of the strings is not looked at
+        TEST_ASSERT(cutf_compare_s8_s16(2, u8"a\x80", 2, u"bb", &order) == CUTF_SUCCESS && order < 0);
+        TEST_ASSERT(cutf_compare_s16_s32(2, u"b\xDC00", 1, U"a", &order) == CUTF_SUCCESS && order > 0);
+    }
+
+    return 0;
+}
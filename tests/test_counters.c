@@ -0,0 +1,46 @@
+#include "test_common.h"
+
+#include <string.h>
+
+int main(void)
+{
+    static constexpr char8_t text[] = u8"plain ascii text then ケツを食べる";
+    enum
+    {
+        SZ_TEXT = sizeof(text) - 1,
+    };
+    char16_t buffer[SZ_TEXT];
+    size_t consumed, written;
+    cutf_state_t state = CUTF_STATE_INITIALIZER;
+
+    cutf_stats_reset();
+    // Convert in two calls, splitting the last codepoint
+    TEST_ASSERT(cutf_s8tos16(SZ_TEXT - 1, text, SZ_TEXT, &consumed, buffer, &written, &state) ==
+                CUTF_INCOMPLETE_INPUT);
+    auto const written_first = written;
+    TEST_ASSERT(cutf_s8tos16(1, text + SZ_TEXT - 1, SZ_TEXT - written_first, &consumed, buffer + written_first, &written,
+                             &state) == CUTF_SUCCESS);
+    TEST_ASSERT(cutf_s8tos16(2, u8"\xFF" "a", SZ_TEXT, &consumed, buffer, &written, &state) == CUTF_INVALID_INPUT);
+    auto const counters = cutf_stats_snapshot();
+
+#if defined(CUTF_ENABLE_STATS)
+    TEST_ASSERT(counters.calls == 3);
+    TEST_ASSERT(counters.bytes_in == SZ_TEXT);
+    TEST_ASSERT(counters.bytes_out == (written_first + written) * sizeof(char16_t));
+    // "plain as" and "cii text" are converted as blocks, and the remaining 12 codepoints one at a time
+    TEST_ASSERT(counters.fast_blocks == 2);
+    TEST_ASSERT(counters.slow_codepoints == 12);
+    TEST_ASSERT(counters.restarts == 1);
+    TEST_ASSERT(counters.incomplete_input == 1 && counters.insufficient_buffer == 0 && counters.invalid_input == 1);
+
+    cutf_stats_reset();
+    auto const reset = cutf_stats_snapshot();
+    TEST_ASSERT(reset.calls == 0 && reset.bytes_in == 0 && reset.invalid_input == 0);
+#else
+    // Nothing is counted
+    static constexpr cutf_counters_t zero = {0};
+    TEST_ASSERT(memcmp(&counters, &zero, sizeof(zero)) == 0);
+#endif
+
+    return 0;
+}
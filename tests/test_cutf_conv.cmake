@@ -0,0 +1,97 @@
+# Converts a file through every encoding and back using cutf-conv. The input is larger than a single block of the
+# pipeline, with codepoints split between blocks.
+
+function(run_conv)
+    execute_process(COMMAND ${CUTF_CONV} ${ARGN} WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE res)
+    if (NOT res EQUAL 0)
+        message(FATAL_ERROR "cutf-conv ${ARGN} failed")
+    endif ()
+endfunction()
+
+string(REPEAT "ケツを食べる 🗿💢 amogus ඞ\n" 50000 text)
+file(WRITE ${WORK_DIR}/conv_input.txt "${text}")
+
+foreach (encoding utf16le utf16be utf32le utf32be)
+    # With a byte-order mark, the encoding is detected when converting back
+    run_conv(-t ${encoding} -b conv_input.txt conv_${encoding}_bom.txt)
+    run_conv(-t utf8 conv_${encoding}_bom.txt conv_${encoding}_bom_back.txt)
+    file(READ ${WORK_DIR}/conv_${encoding}_bom_back.txt back)
+    if (NOT back STREQUAL text)
+        message(FATAL_ERROR "Round trip through ${encoding} with a byte-order mark changed the text")
+    endif ()
+
+    # Without a byte-order mark, the encoding must be given
+    run_conv(-t ${encoding} conv_input.txt conv_${encoding}.txt)
+    run_conv(-f ${encoding} -t utf8 conv_${encoding}.txt conv_${encoding}_back.txt)
+    file(READ ${WORK_DIR}/conv_${encoding}_back.txt back)
+    if (NOT back STREQUAL text)
+        message(FATAL_ERROR "Round trip through ${encoding} changed the text")
+    endif ()
+endforeach ()
+
+# Conversion between UTF-16 and UTF-32 of different byte orders
+run_conv(-t utf32be conv_utf16le_bom.txt conv_utf32be_from_utf16.txt)
+file(SHA256 ${WORK_DIR}/conv_utf32be_from_utf16.txt converted)
+file(SHA256 ${WORK_DIR}/conv_utf32be.txt expected)
+if (NOT converted STREQUAL expected)
+    message(FATAL_ERROR "Conversion from UTF-16LE to UTF-32BE is not correct")
+endif ()
+
+# Input in the encoding of the output is checked while it is copied, with codepoints split between blocks
+run_conv(-f utf8 -t utf8 conv_input.txt conv_utf8_copy.txt)
+file(READ ${WORK_DIR}/conv_utf8_copy.txt copy)
+if (NOT copy STREQUAL text)
+    message(FATAL_ERROR "Copying UTF-8 changed the text")
+endif ()
+run_conv(-f utf16le -t utf16be conv_utf16le.txt conv_utf16be_from_utf16le.txt)
+file(SHA256 ${WORK_DIR}/conv_utf16be_from_utf16le.txt converted)
+file(SHA256 ${WORK_DIR}/conv_utf16be.txt expected)
+if (NOT converted STREQUAL expected)
+    message(FATAL_ERROR "Conversion from UTF-16LE to UTF-16BE is not correct")
+endif ()
+
+# Invalid input is rejected
+function(expect_failure content)
+    file(WRITE ${WORK_DIR}/conv_invalid.txt "${content}")
+    execute_process(COMMAND ${CUTF_CONV} ${ARGN} conv_invalid.txt conv_invalid_out.txt WORKING_DIRECTORY ${WORK_DIR}
+            RESULT_VARIABLE res ERROR_QUIET)
+    if (res EQUAL 0)
+        message(FATAL_ERROR "cutf-conv ${ARGN} accepted invalid input")
+    endif ()
+endfunction()
+
+# Too large to be a codepoint in either byte order
+expect_failure("abcd" -f utf32le -t utf8)
+expect_failure("abcd" -f utf32be -t utf8)
+# Not a whole number of units
+expect_failure("abc" -f utf16le -t utf8)
+
+# Input which is not correctly encoded is reported as such, also when it only needs to be copied
+function(expect_not_encoded content)
+    file(WRITE ${WORK_DIR}/conv_invalid.txt "${content}")
+    execute_process(COMMAND ${CUTF_CONV} ${ARGN} conv_invalid.txt conv_invalid_out.txt WORKING_DIRECTORY ${WORK_DIR}
+            RESULT_VARIABLE res ERROR_VARIABLE error)
+    if (res EQUAL 0 OR NOT error MATCHES "input is not correctly encoded")
+        message(FATAL_ERROR "cutf-conv ${ARGN} did not report incorrectly encoded input")
+    endif ()
+endfunction()
+
+string(ASCII 255 254 not_utf8)
+expect_not_encoded("${not_utf8}" -f utf8 -t utf8)
+# Lone low surrogate U+DC41
+string(ASCII 65 220 lone_surrogate)
+expect_not_encoded("${lone_surrogate}" -f utf16le -t utf16be)
+expect_not_encoded("${lone_surrogate}" -f utf16le -t utf16le)
+
+# Converting a file into itself is refused before the output is truncated, also through another path
+if (UNIX)
+    file(WRITE ${WORK_DIR}/conv_same.txt "${text}")
+    foreach (out_path conv_same.txt ./conv_same.txt)
+        execute_process(COMMAND ${CUTF_CONV} -f utf8 -t utf16le conv_same.txt ${out_path} WORKING_DIRECTORY ${WORK_DIR}
+                RESULT_VARIABLE res ERROR_VARIABLE error)
+        file(READ ${WORK_DIR}/conv_same.txt same)
+        if (res EQUAL 0 OR NOT error MATCHES "same file" OR NOT same STREQUAL text)
+            message(FATAL_ERROR "cutf-conv converted conv_same.txt into ${out_path}")
+        endif ()
+    endforeach ()
+endif ()
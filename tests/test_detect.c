@@ -0,0 +1,111 @@
+#include "test_common.h"
+
+#include <string.h>
+
+// Detect the encoding of a string converted into the encoding and byte order given, and check it is the best guess.
+static void check_detected(const test_pair_t *const p_pair, const cutf_encoding_t encoding,
+                           const utf_endianness_t endianness, const bool with_bom)
+{
+    char32_t buffer[128];
+    auto const p_bytes = (unsigned char *)buffer;
+    size_t sz = 0;
+    if (encoding == CUTF_ENCODING_UTF8)
+    {
+        if (with_bom)
+            memcpy(p_bytes, "\xEF\xBB\xBF", sz = 3);
+        memcpy(p_bytes + sz, p_pair->p8, p_pair->sz8);
+        sz += p_pair->sz8;
+    }
+    else if (encoding == CUTF_ENCODING_UTF16)
+    {
+        auto const p16 = (char16_t *)buffer;
+        size_t units = 0;
+        if (with_bom)
+            p16[units++] = 0xFEFF;
+        memcpy(p16 + units, p_pair->p16, p_pair->sz16 * sizeof(char16_t));
+        units += p_pair->sz16;
+        if (endianness == CUTF_ENDIANNESS_REVERSE)
+            cutf_utf16_swap_endianness(units, p16, p16);
+        sz = units * sizeof(char16_t);
+    }
+    else
+    {
+        size_t units = 0;
+        if (with_bom)
+            buffer[units++] = 0xFEFF;
+        memcpy(buffer + units, p_pair->p32, p_pair->sz32 * sizeof(char32_t));
+        units += p_pair->sz32;
+        if (endianness == CUTF_ENDIANNESS_REVERSE)
+            cutf_utf32_swap_endianness(units, buffer, buffer);
+        sz = units * sizeof(char32_t);
+    }
+
+    cutf_encoding_guess_t guesses[CUTF_MAX_ENCODING_GUESSES];
+    auto const count = cutf_detect_encoding(sz, buffer, CUTF_MAX_ENCODING_GUESSES, guesses);
+    TEST_ASSERT(count >= 1);
+    TEST_ASSERT(guesses[0].encoding == encoding && guesses[0].endianness == endianness);
+    TEST_ASSERT(guesses[0].bom_length == (with_bom ? sz - (encoding == CUTF_ENCODING_UTF8   ? p_pair->sz8
+                                                           : encoding == CUTF_ENCODING_UTF16 ? p_pair->sz16 * 2
+                                                                                             : p_pair->sz32 * 4)
+                                                   : 0));
+    for (size_t i = 1; i < count; ++i)
+        TEST_ASSERT(guesses[i].confidence <= guesses[i - 1].confidence && guesses[i].confidence > 0);
+}
+
+int main(void)
+{
+    // With a byte-order mark every encoding is detected
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF8, CUTF_ENDIANNESS_NATIVE, true);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_NATIVE, true);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_REVERSE, true);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_NATIVE, true);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_REVERSE, true);
+    }
+
+    // Without one, UTF-8 and UTF-32 are told apart by validity, and ASCII text in UTF-16 by its zero bytes
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF8, CUTF_ENDIANNESS_NATIVE, false);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_NATIVE, false);
+        check_detected(&test_pairs[i], CUTF_ENCODING_UTF32, CUTF_ENDIANNESS_REVERSE, false);
+    }
+    check_detected(&test_pairs[0], CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_NATIVE, false);
+    check_detected(&test_pairs[0], CUTF_ENCODING_UTF16, CUTF_ENDIANNESS_REVERSE, false);
+
+    // Surrogate pairs show the byte order of UTF-16, also when they are split between the chunks checked
+    {
+        char16_t emoji[601];
+        for (unsigned i = 0; i < 300; ++i)
+            memcpy(emoji + 2 * i + 1, u"🗿", 2 * sizeof(char16_t));
+        emoji[0] = u'a';
+        cutf_encoding_guess_t guess;
+        TEST_ASSERT(cutf_detect_encoding(sizeof(emoji), emoji, 1, &guess) == 1);
+        TEST_ASSERT(guess.encoding == CUTF_ENCODING_UTF16 && guess.endianness == CUTF_ENDIANNESS_NATIVE);
+        cutf_utf16_swap_endianness(601, emoji, emoji);
+        TEST_ASSERT(cutf_detect_encoding(sizeof(emoji), emoji, 1, &guess) == 1);
+        TEST_ASSERT(guess.encoding == CUTF_ENCODING_UTF16 && guess.endianness == CUTF_ENDIANNESS_REVERSE);
+    }
+
+    // Only the best guesses are written when the output is short
+    {
+        cutf_encoding_guess_t guesses[CUTF_MAX_ENCODING_GUESSES], best;
+        auto const count = cutf_detect_encoding(10, u"hello", CUTF_MAX_ENCODING_GUESSES, guesses);
+        TEST_ASSERT(count > 1);
+        TEST_ASSERT(cutf_detect_encoding(10, u"hello", 1, &best) == 1);
+        TEST_ASSERT(memcmp(&best, &guesses[0], sizeof(best)) == 0);
+    }
+
+    // Odd lengths rule out UTF-16 and UTF-32, and bytes which are not text rule out everything
+    {
+        cutf_encoding_guess_t guesses[CUTF_MAX_ENCODING_GUESSES];
+        TEST_ASSERT(cutf_detect_encoding(5, "hello", CUTF_MAX_ENCODING_GUESSES, guesses) == 1);
+        TEST_ASSERT(guesses[0].encoding == CUTF_ENCODING_UTF8 && guesses[0].confidence == 95);
+        TEST_ASSERT(cutf_detect_encoding(3, "\xFF\xFF\xFF", CUTF_MAX_ENCODING_GUESSES, guesses) == 0);
+        TEST_ASSERT(cutf_detect_encoding(0, "", CUTF_MAX_ENCODING_GUESSES, guesses) == 1);
+        TEST_ASSERT(guesses[0].encoding == CUTF_ENCODING_UTF8);
+    }
+
+    return 0;
+}
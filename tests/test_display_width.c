@@ -0,0 +1,98 @@
+#include "test_common.h"
+#include <stdint.h>
+#include <string.h>
+
+static size_t width_of(const char8_t *const str)
+{
+    size_t valid, width;
+    auto const length = strlen((const char *)str);
+    TEST_ASSERT(cutf_utf8_display_width(length, str, &valid, &width) == CUTF_SUCCESS);
+    TEST_ASSERT(valid == length);
+    return width;
+}
+
+int main(void)
+{
+    // Single codepoints
+    TEST_ASSERT(cutf_codepoint_display_width(U'a') == 1);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\t') == 0);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\x7F') == 0);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\u0301') == 0);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\u200B') == 0);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\u00AD') == 1);
+    TEST_ASSERT(cutf_codepoint_display_width(U'é') == 1);
+    TEST_ASSERT(cutf_codepoint_display_width(U'一') == 2);
+    TEST_ASSERT(cutf_codepoint_display_width(U'Ａ') == 2);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\U0001F600') == 2);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\U00020000') == 2);
+    TEST_ASSERT(cutf_codepoint_display_width(U'\u1161') == 0);
+    TEST_ASSERT(cutf_codepoint_display_width(0x110000) == 0);
+
+    // Strings, measured by grapheme clusters
+    TEST_ASSERT(width_of(u8"") == 0);
+    TEST_ASSERT(width_of(u8"hello, world") == 12);
+    TEST_ASSERT(width_of(u8"tab\tand\r\nnewline\x7F") == 13);
+    TEST_ASSERT(width_of(u8"\x01 \x01 \x1F !\x1F\x7F~") == 5);
+    TEST_ASSERT(width_of(u8"e\u0301te\u0301") == 3);
+    TEST_ASSERT(width_of(u8"日本語") == 6);
+    TEST_ASSERT(width_of(u8"\u1100\u1161\u11A8") == 2);
+    TEST_ASSERT(width_of(u8"\U0001F469\u200D\U0001F4BB") == 2);
+    TEST_ASSERT(width_of(u8"\U0001F44B\U0001F3FB!") == 3);
+    TEST_ASSERT(width_of(u8"\U0001F1E7\U0001F1F7") == 2);
+    TEST_ASSERT(width_of(u8"❤\uFE0F ❤") == 4);
+    TEST_ASSERT(width_of(u8"\u06001") == 1);
+    TEST_ASSERT(width_of(u8"a long line of ASCII text, followed by 日本") == 43);
+    TEST_ASSERT(width_of(u8"ascii text with a combining mark after the blocke\u0301") == 49);
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        size_t valid, width;
+        TEST_ASSERT(cutf_utf8_display_width(test_pairs[i].sz8, test_pairs[i].p8, &valid, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz8 && width != 0);
+    }
+
+    // Errors stop the measurement
+    {
+        size_t valid, width;
+        TEST_ASSERT(cutf_utf8_display_width(14, u8"abcdefghij\x80xyz", &valid, &width) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == 10 && width == 10);
+        TEST_ASSERT(cutf_utf8_display_width(3, u8"a\xE6\x97", &valid, &width) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(valid == 1 && width == 1);
+        TEST_ASSERT(cutf_utf8_display_width(5, u8"\xF7\xBF\xBF\xBF" "a", &valid, &width) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == 0 && width == 0);
+
+        // Surrogates, values beyond U+10FFFF and overlong sequences stop the measurement and the truncation
+        const char8_t *const invalid[] = {u8"ab\xED\xA0\x80", u8"ab\xF4\x90\x80\x80", u8"ab\xC1\x81",
+                                          u8"ab\xE0\x80\x80"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        {
+            auto const length = strlen((const char *)invalid[i]);
+            TEST_ASSERT(cutf_utf8_display_width(length, invalid[i], &valid, &width) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2 && width == 2);
+            TEST_ASSERT(cutf_utf8_truncate_width(length, invalid[i], 10, &valid, &width) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2 && width == 2);
+            TEST_ASSERT(cutf_utf8_truncate_width(length, invalid[i], 1, &valid, &width) == CUTF_SUCCESS);
+            TEST_ASSERT(valid == 1 && width == 1);
+        }
+    }
+
+    // Truncation keeps whole clusters and does not split wide characters
+    {
+        const char8_t *const str = u8"abcdefghijklmnop日本e\u0301x";
+        auto const length = strlen((const char *)str);
+        size_t consumed, width;
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, 5, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 5 && width == 5);
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, 17, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 16 && width == 16);
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, 18, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 19 && width == 18);
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, 21, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 25 && width == 21);
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, SIZE_MAX, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == length && width == 22);
+        TEST_ASSERT(cutf_utf8_truncate_width(length, str, 0, &consumed, &width) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 0 && width == 0);
+    }
+
+    return 0;
+}
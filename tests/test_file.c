@@ -0,0 +1,157 @@
+#include "test_common.h"
+#include <cutf_file.h>
+#include <string.h>
+
+static const char *const IN_PATH = "test_file_in.txt";
+static const char *const OUT_PATH = "test_file_out.txt";
+
+static void write_file(const char *const path, const size_t size, const void *const p_data)
+{
+    FILE *const file = fopen(path, "wb");
+    TEST_ASSERT(file);
+    TEST_ASSERT(fwrite(p_data, 1, size, file) == size);
+    fclose(file);
+}
+
+static size_t read_file(const char *const path, const size_t size, void *const p_data)
+{
+    FILE *const file = fopen(path, "rb");
+    TEST_ASSERT(file);
+    auto const read = fread(p_data, 1, size, file);
+    fclose(file);
+    return read;
+}
+
+int main(void)
+{
+    // Convert between every pair of encodings
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        const struct
+        {
+            cutf_encoding_t encoding;
+            size_t size;
+            const void *p_data;
+        } files[] = {
+            {CUTF_ENCODING_UTF8, test_pairs[i].sz8 * sizeof(char8_t), test_pairs[i].p8},
+            {CUTF_ENCODING_UTF16, test_pairs[i].sz16 * sizeof(char16_t), test_pairs[i].p16},
+            {CUTF_ENCODING_UTF32, test_pairs[i].sz32 * sizeof(char32_t), test_pairs[i].p32},
+        };
+        for (unsigned from = 0; from < 3; ++from)
+        {
+            write_file(IN_PATH, files[from].size, files[from].p_data);
+            for (unsigned to = 0; to < 3; ++to)
+            {
+                size_t written;
+                TEST_ASSERT(cutf_convert_file(IN_PATH, files[from].encoding, OUT_PATH, files[to].encoding,
+                                              &written) == CUTF_SUCCESS);
+                TEST_ASSERT(written * cutf_encoding_unit_size(files[to].encoding) == files[to].size);
+
+                unsigned char buffer[1024];
+                TEST_ASSERT(read_file(OUT_PATH, sizeof(buffer), buffer) == files[to].size);
+                TEST_ASSERT(memcmp(buffer, files[to].p_data, files[to].size) == 0);
+            }
+        }
+    }
+
+    // Empty files
+    {
+        size_t written;
+        write_file(IN_PATH, 0, "");
+        TEST_ASSERT(cutf_convert_file(IN_PATH, CUTF_ENCODING_UTF8, OUT_PATH, CUTF_ENCODING_UTF16, &written) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(written == 0);
+    }
+
+    // Invalid input does not create the output
+    {
+        size_t written;
+        remove(OUT_PATH);
+        write_file(IN_PATH, 3, "a\xFF" "b");
+        TEST_ASSERT(cutf_convert_file(IN_PATH, CUTF_ENCODING_UTF8, OUT_PATH, CUTF_ENCODING_UTF16, &written) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(fopen(OUT_PATH, "rb") == nullptr);
+        write_file(IN_PATH, 3, "abc");
+        TEST_ASSERT(cutf_convert_file(IN_PATH, CUTF_ENCODING_UTF16, OUT_PATH, CUTF_ENCODING_UTF8, &written) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_convert_file("does_not_exist.txt", CUTF_ENCODING_UTF8, OUT_PATH, CUTF_ENCODING_UTF16,
+                                      &written) == CUTF_FILE_ERROR);
+    }
+
+    // The input can not be converted into itself, which would truncate it while it is read
+    {
+        size_t written = 42;
+        write_file(IN_PATH, 3, "abc");
+        TEST_ASSERT(cutf_convert_file(IN_PATH, CUTF_ENCODING_UTF8, IN_PATH, CUTF_ENCODING_UTF16, &written) ==
+                    CUTF_FILE_ERROR);
+        char buffer[4];
+        TEST_ASSERT(read_file(IN_PATH, sizeof(buffer), buffer) == 3 && memcmp(buffer, "abc", 3) == 0);
+        TEST_ASSERT(written == 42);
+    }
+
+    // Units of the same encoding are checked, and codepoints split between calls are kept in the state
+    {
+        char8_t out8[8];
+        char16_t out16[8];
+        size_t consumed, written;
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 3, u8"a\xFF" "b", CUTF_ENCODING_UTF8, 8, &consumed, out8, &written,
+                                 &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 4, u8"a\xED\xA0\x80", CUTF_ENCODING_UTF8, 8, &consumed, out8,
+                                 &written, &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF16, 2, u"\xDC00" "a", CUTF_ENCODING_UTF16, 8, &consumed, out16,
+                                 &written, &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF32, 1, U"\x110000", CUTF_ENCODING_UTF32, 8, &consumed,
+                                 (char32_t[8]){}, &written, &state) == CUTF_INVALID_INPUT);
+
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 3, u8"ab\xE6", CUTF_ENCODING_UTF8, 8, &consumed, out8, &written,
+                                 &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 3 && written == 2 && !cutf_state_is_clean(state));
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 1, u8"\x97", CUTF_ENCODING_UTF8, 6, &consumed, out8 + 2, &written,
+                                 &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 1 && written == 0);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 2, u8"\xA5" "c", CUTF_ENCODING_UTF8, 2, &consumed, out8 + 2,
+                                 &written, &state) == CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 0 && written == 0);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 2, u8"\xA5" "c", CUTF_ENCODING_UTF8, 6, &consumed, out8 + 2,
+                                 &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 2 && written == 4 && cutf_state_is_clean(state));
+        TEST_ASSERT(memcmp(out8, u8"ab\u65E5" "c", 6) == 0);
+
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF16, 2, u"a\xD83D", CUTF_ENCODING_UTF16, 8, &consumed, out16,
+                                 &written, &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 2 && written == 1);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF16, 0, u"", CUTF_ENCODING_UTF16, 7, &consumed, out16 + 1, &written,
+                                 &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF16, 2, u"\xDE00" "b", CUTF_ENCODING_UTF16, 7, &consumed, out16 + 1,
+                                 &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 2 && written == 3 && memcmp(out16, u"a\U0001F600" "b", 4 * sizeof(char16_t)) == 0);
+
+        // Only whole codepoints are copied into outputs which are too small
+        TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, 5, u8"a\u65E5" "b", CUTF_ENCODING_UTF8, 3, &consumed, out8,
+                                 &written, &state) == CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 1 && written == 1 && cutf_state_is_clean(state));
+
+        // Starts of codepoints which can not become valid are invalid for every output encoding, also when counting
+        const char8_t *const invalid[] = {u8"a\xE0\x80", u8"a\xF4\x90\x80", u8"a\xED\xA0"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        {
+            auto const sz = strlen((const char *)invalid[i]);
+            for (cutf_encoding_t to = CUTF_ENCODING_UTF8; to <= CUTF_ENCODING_UTF32; ++to)
+            {
+                char32_t out[8];
+                state = CUTF_STATE_INITIALIZER;
+                TEST_ASSERT(cutf_convert(CUTF_ENCODING_UTF8, sz, invalid[i], to, 8, &consumed, out, &written, &state) ==
+                            CUTF_INVALID_INPUT);
+                size_t valid, count;
+                TEST_ASSERT(cutf_count_converted(CUTF_ENCODING_UTF8, sz, invalid[i], to, &valid, &count) ==
+                            CUTF_INVALID_INPUT);
+                TEST_ASSERT(valid == 1);
+            }
+        }
+    }
+
+    remove(IN_PATH);
+    remove(OUT_PATH);
+    return 0;
+}
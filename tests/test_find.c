@@ -0,0 +1,78 @@
+#include "test_common.h"
+#include <string.h>
+
+static size_t find(const char8_t *const str, const char8_t *const needle, size_t *const p_codepoint_offset)
+{
+    size_t offset = SIZE_MAX;
+    if (!cutf_utf8_find(strlen((const char *)str), str, strlen((const char *)needle), needle, &offset,
+                        p_codepoint_offset))
+        return SIZE_MAX;
+    return offset;
+}
+
+static bool is_boundary(const size_t sz, const char8_t *const str, const size_t pos)
+{
+    return pos == sz || (str[pos] & 0xC0) != 0x80;
+}
+
+// Check the search for every substring of the string, including ones which split codepoints, against a plain search
+static void check_all_needles(const char8_t *const str)
+{
+    auto const sz = strlen((const char *)str);
+    for (size_t start = 0; start < sz; ++start)
+    {
+        for (size_t length = 1; start + length <= sz && length <= 12; ++length)
+        {
+            auto const needle = str + start;
+            size_t expected = SIZE_MAX;
+            for (size_t pos = 0; pos + length <= sz && expected == SIZE_MAX; ++pos)
+            {
+                if (memcmp(str + pos, needle, length) == 0 && is_boundary(sz, str, pos) &&
+                    is_boundary(sz, str, pos + length))
+                    expected = pos;
+            }
+
+            size_t offset = SIZE_MAX, codepoint_offset;
+            auto const found = cutf_utf8_find(sz, str, length, needle, &offset, &codepoint_offset);
+            TEST_ASSERT(found == (expected != SIZE_MAX) && (!found || offset == expected));
+            if (found)
+                TEST_ASSERT(codepoint_offset == cutf_count_s8asc32_complete(offset, str));
+        }
+    }
+}
+
+int main(void)
+{
+    size_t codepoint_offset = SIZE_MAX;
+    TEST_ASSERT(find(u8"hello world", u8"world", &codepoint_offset) == 6 && codepoint_offset == 6);
+    TEST_ASSERT(find(u8"hello world", u8"hello", nullptr) == 0);
+    TEST_ASSERT(find(u8"hello world", u8"", &codepoint_offset) == 0 && codepoint_offset == 0);
+    TEST_ASSERT(find(u8"hello world", u8"worlds", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"", u8"a", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"\u65E5\u672C\u8A9E\u306E\u30ED\u30B0: error", u8"error", &codepoint_offset) == 20);
+    TEST_ASSERT(codepoint_offset == 8);
+    TEST_ASSERT(find(u8"a long line of a log file without the needle in it at all", u8"needle!", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"a long line of a log file with a needle at its end", u8"end", nullptr) == 47);
+
+    // Needles which only occur inside of multi-unit sequences are not found
+    TEST_ASSERT(find(u8"\u00E9\u00E9", u8"\xA9", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"\u00E9\u00E9", u8"\xA9\xC3", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"\u00E9\u00E9", u8"\xC3", nullptr) == SIZE_MAX);
+    TEST_ASSERT(find(u8"\u20AC\u20AC", u8"\xE2\x82\xAC", &codepoint_offset) == 0 && codepoint_offset == 0);
+    TEST_ASSERT(find(u8"\u00E9t\u00E9 \u20AC", u8"\u20AC", &codepoint_offset) == 6 && codepoint_offset == 4);
+
+    // Codepoints
+    size_t offset;
+    TEST_ASSERT(cutf_utf8_find_codepoint(7, u8"ab\U0001F600c", U'\U0001F600', &offset, &codepoint_offset));
+    TEST_ASSERT(offset == 2 && codepoint_offset == 2);
+    TEST_ASSERT(cutf_utf8_find_codepoint(11, u8"abcdefghijk", U'k', &offset, nullptr) && offset == 10);
+    TEST_ASSERT(!cutf_utf8_find_codepoint(3, u8"\xED\xA0\x80", 0xD800, &offset, nullptr));
+    TEST_ASSERT(!cutf_utf8_find_codepoint(3, u8"abc", 0x110000, &offset, nullptr));
+
+    check_all_needles(u8"the quick brown fox jumps over the lazy dog, the quick brown fox");
+    check_all_needles(u8"\u00E9t\u00E9 \u00E9t\u00E9 \u65E5\u672C \U0001F600\U0001F601 "
+                      u8"\u00C3\u00A9 caf\u00E9 cafe\u0301");
+    check_all_needles(u8"aaaaaaaaaaaaaaaaaaaaaaaaab\u0101\u0101\u0101\u0101\u0101\u0101\u0101\u0101aab");
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "test_common.h"
+#include <cutf_inline.h>
+#include <stdint.h>
+#include <string.h>
+
+enum
+{
+    MAX_CLUSTERS = 8,
+    SZ_BUFFER = 256,
+};
+
+typedef struct
+{
+    const char8_t *clusters[MAX_CLUSTERS];
+} grapheme_case_t;
+
+// Strings split into their grapheme clusters
+static const grapheme_case_t cases[] = {
+    {{u8"e\u0301", u8"x"}},                                                 // Combining mark
+    {{u8"\r\n", u8"\r", u8"a", u8"\n"}},                                    // CR LF
+    {{u8"\U0001F1E7\U0001F1F7", u8"\U0001F1E7\U0001F1F7", u8"\U0001F1EB"}}, // Regional indicators in pairs
+    {{u8"\U0001F469\u200D\U0001F4BB", u8"\U0001F44B\U0001F3FB"}},           // Joined pictographs, skin tone modifier
+    {{u8"\U0001F3F3\uFE0F\u200D\U0001F308", u8"x"}},                        // Extend before the joiner
+    {{u8"a\u200D", u8"b"}},                                                 // Joiner which is not between pictographs
+    {{u8"\u0915\u094D\u0937", u8"a"}},                                      // Consonants joined by a virama
+    {{u8"\u0915\u094D\u200D\u0937"}},                                       // Joiner between virama and consonant
+    {{u8"\u0915", u8"\u1CF6\U00010A1E"}},                                   // Linker which starts a cluster
+    {{u8"\u0915\u093F"}},                                                   // Spacing mark
+    {{u8"\u1100\u1161\u11A8", u8"\uAC00"}},                                 // Hangul jamo and syllables
+    {{u8"\u06001"}},                                                        // Prepend
+    {{u8"\x01", u8"\u0301"}},                                               // Control
+    {{u8"t", u8"e", u8"x", u8"t", u8"\r\n", u8"e\u0301", u8"!", u8" "}},    // Runs of ASCII
+};
+
+static const size_t num_cases = sizeof(cases) / sizeof(*cases);
+
+// Counts of clusters in the strings of test_common.h
+static const size_t test_pair_clusters[] = {5, 5, 6, 11, 3, 7, 8};
+
+static void check_case(const grapheme_case_t *const test)
+{
+    char8_t str8[SZ_BUFFER];
+    char16_t str16[SZ_BUFFER];
+    size_t ends8[MAX_CLUSTERS], ends16[MAX_CLUSTERS];
+    size_t sz8 = 0, sz16 = 0, num_clusters = 0;
+    for (; num_clusters < MAX_CLUSTERS && test->clusters[num_clusters]; ++num_clusters)
+    {
+        auto const cluster = test->clusters[num_clusters];
+        auto const length = strlen((const char *)cluster);
+        memcpy(str8 + sz8, cluster, length);
+        sz8 += length;
+        ends8[num_clusters] = sz8;
+
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s8tos16(length, cluster, SZ_BUFFER - sz16, &consumed, str16 + sz16, &written, &state) ==
+                    CUTF_SUCCESS);
+        sz16 += written;
+        ends16[num_clusters] = sz16;
+    }
+
+    // Clusters found one at a time
+    cutf_iter_t iters[] = {cutf_iter_utf8(sz8, str8), cutf_iter_utf16(sz16, str16)};
+    const size_t *const ends[] = {ends8, ends16};
+    for (unsigned j = 0; j < 2; ++j)
+    {
+        auto iter = iters[j];
+        for (size_t i = 0; i < num_clusters; ++i)
+        {
+            cutf_span_t span;
+            TEST_ASSERT(cutf_iter_next_grapheme(&iter, &span) == CUTF_SUCCESS);
+            TEST_ASSERT(span.start == (i == 0 ? 0 : ends[j][i - 1]) && span.start + span.length == ends[j][i]);
+        }
+        TEST_ASSERT(cutf_iter_done(&iter));
+        TEST_ASSERT(cutf_iter_next_grapheme(&iter, nullptr) == CUTF_INCOMPLETE_INPUT);
+
+        // Skipping stops at the same boundaries
+        for (size_t i = 1; i <= num_clusters; ++i)
+        {
+            iter = iters[j];
+            size_t skipped;
+            TEST_ASSERT(cutf_iter_skip_graphemes(&iter, i, &skipped) == CUTF_SUCCESS);
+            TEST_ASSERT(skipped == i && iter.position == ends[j][i - 1]);
+        }
+    }
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_cases; ++i)
+        check_case(&cases[i]);
+
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        cutf_iter_t iters[] = {
+            cutf_iter_utf8(test_pairs[i].sz8, test_pairs[i].p8),
+            cutf_iter_utf16(test_pairs[i].sz16, test_pairs[i].p16),
+            cutf_iter_utf32(test_pairs[i].sz32, test_pairs[i].p32),
+        };
+        for (unsigned j = 0; j < sizeof(iters) / sizeof(*iters); ++j)
+        {
+            size_t skipped;
+            TEST_ASSERT(cutf_iter_skip_graphemes(&iters[j], SIZE_MAX, &skipped) == CUTF_SUCCESS);
+            TEST_ASSERT(skipped == test_pair_clusters[i] && cutf_iter_done(&iters[j]));
+        }
+    }
+
+    // Runs of ASCII are skipped in blocks, up to the character which a combining mark extends
+    {
+        const char8_t *const str = u8"abcdefghijklmnoe\u0301fgh";
+        auto iter = cutf_iter_utf8(strlen((const char *)str), str);
+        size_t skipped;
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, 16, &skipped) == CUTF_SUCCESS);
+        TEST_ASSERT(skipped == 16 && iter.position == 18);
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, SIZE_MAX, &skipped) == CUTF_SUCCESS);
+        TEST_ASSERT(skipped == 3 && cutf_iter_done(&iter));
+
+        const char16_t *const str16 = u"abcdefghijklmnoe\u0301fgh";
+        iter = cutf_iter_utf16(20, str16);
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, 15, &skipped) == CUTF_SUCCESS);
+        TEST_ASSERT(skipped == 15 && iter.position == 15);
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, 1, &skipped) == CUTF_SUCCESS);
+        TEST_ASSERT(skipped == 1 && iter.position == 17);
+    }
+
+    // Invalid units end the cluster before them and are reported by the next call
+    {
+        const char8_t *const str = u8"abcdefghije\u0301\x80xyz";
+        auto iter = cutf_iter_utf8(17, str);
+        size_t skipped;
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, SIZE_MAX, &skipped) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(skipped == 11 && iter.position == 13);
+        TEST_ASSERT(cutf_iter_next_grapheme(&iter, nullptr) == CUTF_INVALID_INPUT && iter.position == 13);
+
+        // Values beyond U+10FFFF, surrogates and overlong sequences are not codepoints
+        iter = cutf_iter_utf8(5, u8"\xF7\xBF\xBF\xBF" "a");
+        TEST_ASSERT(cutf_iter_skip_graphemes(&iter, SIZE_MAX, &skipped) == CUTF_INVALID_INPUT && skipped == 0);
+        TEST_ASSERT(cutf_iter_next_grapheme(&iter, nullptr) == CUTF_INVALID_INPUT && iter.position == 0);
+        const char8_t *const invalid[] = {u8"e\u0301\xF4\x90\x80\x80", u8"e\u0301\xED\xA0\x80",
+                                          u8"e\u0301\xE0\x80\x80"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        {
+            iter = cutf_iter_utf8(strlen((const char *)invalid[i]), invalid[i]);
+            TEST_ASSERT(cutf_iter_next_grapheme(&iter, nullptr) == CUTF_SUCCESS && iter.position == 3);
+            TEST_ASSERT(cutf_iter_next_grapheme(&iter, nullptr) == CUTF_INVALID_INPUT && iter.position == 3);
+        }
+
+        // A surrogate pair cut off at the end of the input
+        iter = cutf_iter_utf16(2, u"a\xD83D");
+        cutf_span_t span;
+        TEST_ASSERT(cutf_iter_next_grapheme(&iter, &span) == CUTF_SUCCESS);
+        TEST_ASSERT(span.start == 0 && span.length == 1);
+        TEST_ASSERT(cutf_iter_next_grapheme(&iter, &span) == CUTF_INCOMPLETE_INPUT && iter.position == 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "test_common.h"
+#include <string.h>
+
+enum
+{
+    SZ_BUFFER = 64,
+};
+
+static uint64_t hash8(const size_t sz, const char8_t *const p, const uint64_t seed)
+{
+    size_t valid;
+    uint64_t hash;
+    TEST_ASSERT(cutf_hash_utf8(sz, p, seed, &valid, &hash) == CUTF_SUCCESS && valid == sz);
+    return hash;
+}
+
+static uint64_t hash16(const size_t sz, const char16_t *const p, const uint64_t seed)
+{
+    size_t valid;
+    uint64_t hash;
+    TEST_ASSERT(cutf_hash_utf16(sz, p, seed, &valid, &hash) == CUTF_SUCCESS && valid == sz);
+    return hash;
+}
+
+static uint64_t hash32(const size_t sz, const char32_t *const p, const uint64_t seed)
+{
+    size_t valid;
+    uint64_t hash;
+    TEST_ASSERT(cutf_hash_utf32(sz, p, seed, &valid, &hash) == CUTF_SUCCESS && valid == sz);
+    return hash;
+}
+
+// Check that all encodings of the codepoints hash the same
+static uint64_t check_codepoints(const size_t sz32, const char32_t *const p32, const uint64_t seed)
+{
+    char8_t str8[4 * SZ_BUFFER];
+    char16_t str16[2 * SZ_BUFFER];
+    size_t consumed, sz8, sz16;
+    cutf_state_t state = {0};
+    TEST_ASSERT(cutf_s32tos8(sz32, p32, sizeof(str8), &consumed, str8, &sz8, &state) == CUTF_SUCCESS);
+    TEST_ASSERT(cutf_s32tos16(sz32, p32, 2 * SZ_BUFFER, &consumed, str16, &sz16, &state) == CUTF_SUCCESS);
+
+    auto const hash = hash32(sz32, p32, seed);
+    TEST_ASSERT(hash8(sz8, str8, seed) == hash && hash16(sz16, str16, seed) == hash);
+    return hash;
+}
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        auto const pair = &test_pairs[i];
+        auto const hash = hash8(pair->sz8, pair->p8, 0);
+        TEST_ASSERT(hash16(pair->sz16, pair->p16, 0) == hash && hash32(pair->sz32, pair->p32, 0) == hash);
+        TEST_ASSERT(hash8(pair->sz8, pair->p8, 1) != hash);
+        TEST_ASSERT(check_codepoints(pair->sz32, pair->p32, 0) == hash);
+    }
+
+    // Runs of ASCII at every offset after other codepoints, so that blocks start in the middle of the pending units
+    {
+        char32_t str[SZ_BUFFER];
+        for (size_t offset = 0; offset < 12; ++offset)
+        {
+            for (size_t i = 0; i < SZ_BUFFER; ++i)
+                str[i] = i < offset ? U"\u00E9\u65E5\U0001F600"[i % 3] : (char32_t)(u8'a' + i % 26);
+            for (size_t sz = offset; sz <= SZ_BUFFER; ++sz)
+                check_codepoints(sz, str, 42);
+        }
+    }
+
+    // Strings which differ in length or in a single codepoint hash differently
+    TEST_ASSERT(hash8(0, u8"", 0) != hash8(1, u8"\0", 0));
+    TEST_ASSERT(hash8(8, u8"abcdefgh", 0) != hash8(9, u8"abcdefgh\0", 0));
+    TEST_ASSERT(hash8(9, u8"abcdefghi", 0) != hash8(9, u8"abcdefghj", 0));
+    TEST_ASSERT(hash8(17, u8"abcdefghijklmnopq", 0) != hash8(17, u8"bbcdefghijklmnopq", 0));
+    TEST_ASSERT(hash8(0, u8"", 0) != hash8(0, u8"", 1));
+
+    // Input which is not correctly encoded
+    {
+        size_t valid;
+        uint64_t hash;
+        TEST_ASSERT(cutf_hash_utf8(11, u8"abcdefghij\xC3", 0, &valid, &hash) == CUTF_INCOMPLETE_INPUT && valid == 10);
+        TEST_ASSERT(hash == hash8(10, u8"abcdefghij", 0));
+        TEST_ASSERT(cutf_hash_utf8(3, u8"a\xC1\x81", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 1);
+        TEST_ASSERT(cutf_hash_utf8(4, u8"a\xED\xA0\x80", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 1);
+        TEST_ASSERT(cutf_hash_utf8(5, u8"a\xF4\x90\x80\x80", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 1);
+        TEST_ASSERT(cutf_hash_utf8(4, u8"\xF7\xBF\xBF\xBF", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 0);
+        TEST_ASSERT(cutf_hash_utf16(2, u"a\xD83D", 0, &valid, &hash) == CUTF_INCOMPLETE_INPUT && valid == 1);
+        TEST_ASSERT(cutf_hash_utf16(2, u"\xDC00" "a", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 0);
+        TEST_ASSERT(cutf_hash_utf32(2, U"a\xD800", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 1);
+        TEST_ASSERT(cutf_hash_utf32(1, U"\x110000", 0, &valid, &hash) == CUTF_INVALID_INPUT && valid == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "test_common.h"
+#include <string.h>
+
+static size_t scan(const char8_t *const str)
+{
+    return cutf_utf8_scan_identifier(strlen((const char *)str), str);
+}
+
+int main(void)
+{
+    // Properties of single characters
+    TEST_ASSERT(cutf_is_xid_start(U'a') && cutf_is_xid_start(U'Z') && cutf_is_xid_start(U'\u00E9'));
+    TEST_ASSERT(cutf_is_xid_start(U'日') && cutf_is_xid_start(U'℘'));
+    TEST_ASSERT(!cutf_is_xid_start(U'0') && !cutf_is_xid_start(U'_') && !cutf_is_xid_start(U'$'));
+    TEST_ASSERT(!cutf_is_xid_start(U'\u0301') && !cutf_is_xid_start(U'\U0001F600') && !cutf_is_xid_start(0x110000));
+    TEST_ASSERT(cutf_is_xid_continue(U'a') && cutf_is_xid_continue(U'0') && cutf_is_xid_continue(U'_'));
+    TEST_ASSERT(cutf_is_xid_continue(U'\u0301') && cutf_is_xid_continue(U'\u00B7'));
+    TEST_ASSERT(!cutf_is_xid_continue(U' ') && !cutf_is_xid_continue(U'-') && !cutf_is_xid_continue(0x110000));
+
+    // Identifiers at the start of strings
+    TEST_ASSERT(scan(u8"") == 0);
+    TEST_ASSERT(scan(u8"foo_bar1 = 2") == 8);
+    TEST_ASSERT(scan(u8"_x") == 2);
+    TEST_ASSERT(scan(u8"1abc") == 0);
+    TEST_ASSERT(scan(u8"\u00B7a") == 0);
+    TEST_ASSERT(scan(u8"日本語x+") == 10);
+    TEST_ASSERT(scan(u8"e\u0301t\u00B7e\u0301") == 9);
+    TEST_ASSERT(scan(u8"x\U0001F600") == 1);
+    TEST_ASSERT(scan(u8"a_very_long_identifier_name_123+1") == 31);
+    TEST_ASSERT(scan(u8"identifier_with_\u00FCmlaut(") == 23);
+    TEST_ASSERT(cutf_utf8_scan_identifier(4, u8"abc\x80") == 3);
+    TEST_ASSERT(cutf_utf8_scan_identifier(5, u8"abc\xC3\xA9") == 5);
+    TEST_ASSERT(cutf_utf8_scan_identifier(4, u8"abc\xC3") == 3);
+
+    // Every ASCII character in every position of the blocks
+    for (unsigned c = 1; c < 0x80; ++c)
+    {
+        auto const is_identifier = (c >= u8'a' && c <= u8'z') || (c >= u8'A' && c <= u8'Z') ||
+                                   (c >= u8'0' && c <= u8'9') || c == u8'_';
+        for (size_t pos = 1; pos < 24; ++pos)
+        {
+            char8_t str[24];
+            memset(str, u8'q', sizeof(str));
+            str[pos] = (char8_t)c;
+            TEST_ASSERT(cutf_utf8_scan_identifier(sizeof(str), str) == (is_identifier ? sizeof(str) : pos));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "test_common.h"
+#include <cutf_inline.h>
+
+int main(void)
+{
+    // Inline conversions give the same results as the library ones
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        char32_t out32[256];
+        size_t consumed, written;
+        TEST_ASSERT(cutf_inline_s8tos32(test_pairs[i].sz8, test_pairs[i].p8, 256, &consumed, out32, &written) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == test_pairs[i].sz8 && written == test_pairs[i].sz32);
+        for (unsigned j = 0; j < written; ++j)
+            TEST_ASSERT(out32[j] == test_pairs[i].p32[j]);
+
+        TEST_ASSERT(cutf_inline_s16tos32(test_pairs[i].sz16, test_pairs[i].p16, 256, &consumed, out32, &written) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == test_pairs[i].sz16 && written == test_pairs[i].sz32);
+        for (unsigned j = 0; j < written; ++j)
+            TEST_ASSERT(out32[j] == test_pairs[i].p32[j]);
+
+        char8_t out8[256];
+        TEST_ASSERT(cutf_inline_s32tos8(test_pairs[i].sz32, test_pairs[i].p32, 256, &consumed, out8, &written) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == test_pairs[i].sz32 && written == test_pairs[i].sz8);
+        for (unsigned j = 0; j < written; ++j)
+            TEST_ASSERT(out8[j] == test_pairs[i].p8[j]);
+
+        // Single codepoint encoding of UTF-16
+        size_t pos16 = 0;
+        for (unsigned j = 0; j < test_pairs[i].sz32; ++j)
+        {
+            char16_t units[2];
+            auto const count = cutf_inline_utf16_encode(test_pairs[i].p32[j], units);
+            TEST_ASSERT(count != 0);
+            for (unsigned k = 0; k < count; ++k)
+                TEST_ASSERT(units[k] == test_pairs[i].p16[pos16 + k]);
+            pos16 += count;
+        }
+        TEST_ASSERT(pos16 == test_pairs[i].sz16);
+    }
+
+    // Every leading byte and continuation combination behaves the same as the library
+    for (unsigned lead = 0; lead < 0x100; ++lead)
+    {
+        for (unsigned next = 0; next < 0x100; next += 0x10)
+        {
+            const char8_t str[4] = {(char8_t)lead, (char8_t)next, 0x80, 0x80};
+            for (size_t sz = 1; sz <= 4; ++sz)
+            {
+                size_t consumed_inline = 0, consumed_library = 0;
+                auto const res_inline = cutf_inline_utf8_next_codepoint(sz, str, &consumed_inline);
+                auto const res_library = cutf_utf8_next_codepoint(sz, str, &consumed_library);
+                TEST_ASSERT(res_inline == res_library && consumed_inline == consumed_library);
+
+                // Decoded values match the ones from conversion
+                char32_t c_inline, c_library;
+                if (cutf_inline_utf8_decode(sz, str, &consumed_inline, &c_inline) != CUTF_SUCCESS)
+                    continue;
+                size_t written;
+                cutf_state_t state = {0};
+                TEST_ASSERT(cutf_s8tos32(consumed_inline, str, 1, &consumed_library, &c_library, &written, &state) ==
+                            CUTF_SUCCESS);
+                TEST_ASSERT(c_inline == c_library);
+            }
+        }
+    }
+
+    // Errors
+    {
+        char8_t out8[4];
+        char32_t out32[4];
+        size_t consumed, written;
+        TEST_ASSERT(cutf_inline_utf8_encode(0xD800, out8) == 0);
+        TEST_ASSERT(cutf_inline_utf8_encode(0x110000, out8) == 0);
+        TEST_ASSERT(cutf_inline_s8tos32(4, u8"ab\xE3\x81", 4, &consumed, out32, &written) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 2 && written == 2);
+        TEST_ASSERT(cutf_inline_s8tos32(3, u8"a\x80" "b", 4, &consumed, out32, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(cutf_inline_s32tos8(2, U"a🗿", 4, &consumed, out8, &written) == CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(cutf_inline_s16tos32(2, u"a\xDBFF", 4, &consumed, out32, &written) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(cutf_inline_s16tos32(2, u"\xDC00" "a", 4, &consumed, out32, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 0 && written == 0);
+    }
+
+    return 0;
+}
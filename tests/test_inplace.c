@@ -0,0 +1,79 @@
+#include "test_common.h"
+
+#include <string.h>
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        auto const pair = test_pairs[i];
+        char32_t buffer[64];
+        size_t consumed, written;
+
+        // UTF-32 to UTF-16 and UTF-8, within the input's bytes
+        memcpy(buffer, pair.p32, pair.sz32 * sizeof(char32_t));
+        TEST_ASSERT(cutf_s32tos16_inplace(pair.sz32, buffer, &consumed, &written) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == pair.sz32 && written == pair.sz16);
+        TEST_ASSERT(memcmp(buffer, pair.p16, pair.sz16 * sizeof(char16_t)) == 0);
+
+        memcpy(buffer, pair.p32, pair.sz32 * sizeof(char32_t));
+        TEST_ASSERT(cutf_s32tos8_inplace(pair.sz32, buffer, &consumed, &written) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == pair.sz32 && written == pair.sz8);
+        TEST_ASSERT(memcmp(buffer, pair.p8, pair.sz8) == 0);
+
+        // UTF-16 to UTF-8, starting the input after the headroom
+        size_t headroom;
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(pair.sz16, pair.p16, &headroom) == CUTF_SUCCESS);
+        TEST_ASSERT(headroom + pair.sz16 * sizeof(char16_t) <= sizeof(buffer));
+        memcpy((char8_t *)buffer + headroom, pair.p16, pair.sz16 * sizeof(char16_t));
+        TEST_ASSERT(cutf_s16tos8_inplace(pair.sz16, buffer, headroom, &consumed, &written) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == pair.sz16 && written == pair.sz8);
+        TEST_ASSERT(memcmp(buffer, pair.p8, pair.sz8) == 0);
+
+        // Without enough headroom, the conversion stops before overwriting any input
+        if (headroom != 0)
+        {
+            memcpy((char8_t *)buffer + headroom - 1, pair.p16, pair.sz16 * sizeof(char16_t));
+            TEST_ASSERT(cutf_s16tos8_inplace(pair.sz16, buffer, headroom - 1, &consumed, &written) ==
+                        CUTF_INSUFFICIENT_BUFFER);
+            TEST_ASSERT(consumed < pair.sz16);
+            TEST_ASSERT(memcmp((char8_t *)buffer + headroom - 1 + consumed * sizeof(char16_t), pair.p16 + consumed,
+                               (pair.sz16 - consumed) * sizeof(char16_t)) == 0);
+        }
+    }
+
+    // ASCII falls behind, so it needs no headroom, while three unit codepoints get ahead by one byte each
+    {
+        size_t headroom;
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(11, u"hello world", &headroom) == CUTF_SUCCESS && headroom == 0);
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(6, u"ケツを食べる", &headroom) == CUTF_SUCCESS);
+        TEST_ASSERT(headroom == 6);
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(9, u"abcケツを食べる", &headroom) == CUTF_SUCCESS);
+        TEST_ASSERT(headroom == 3);
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(2, u"a\xD800", &headroom) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_s16tos8_inplace_headroom(2, u"\xDC00" "a", &headroom) == CUTF_INVALID_INPUT);
+    }
+
+    // Invalid input stops the conversion, leaving the rest of the input unchanged
+    {
+        char32_t buffer[20];
+        for (unsigned i = 0; i < 20; ++i)
+            buffer[i] = U'a' + i;
+        buffer[13] = 0xD800;
+        size_t consumed, written;
+        TEST_ASSERT(cutf_s32tos16_inplace(20, buffer, &consumed, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 13 && written == 13);
+        TEST_ASSERT(buffer[13] == 0xD800 && buffer[14] == U'a' + 14);
+        TEST_ASSERT(memcmp(buffer, u"abcdefghijklm", 13 * sizeof(char16_t)) == 0);
+
+        for (unsigned i = 0; i < 20; ++i)
+            buffer[i] = U'a' + i;
+        buffer[13] = 0x110000;
+        TEST_ASSERT(cutf_s32tos8_inplace(20, buffer, &consumed, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 13 && written == 13);
+        TEST_ASSERT(buffer[13] == 0x110000 && buffer[14] == U'a' + 14);
+        TEST_ASSERT(memcmp(buffer, u8"abcdefghijklm", 13) == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "test_common.h"
+#include <cutf_inline.h>
+#include <string.h>
+
+int main(void)
+{
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        // Iterating one codepoint at a time yields the UTF-32 string and spans which cover the input
+        cutf_iter_t iters[] = {
+            cutf_iter_utf8(test_pairs[i].sz8, test_pairs[i].p8),
+            cutf_iter_utf16(test_pairs[i].sz16, test_pairs[i].p16),
+            cutf_iter_utf32(test_pairs[i].sz32, test_pairs[i].p32),
+        };
+        for (unsigned j = 0; j < sizeof(iters) / sizeof(*iters); ++j)
+        {
+            cutf_iter_t iter = iters[j];
+            size_t count = 0, end = 0;
+            while (!cutf_iter_done(&iter))
+            {
+                char32_t c;
+                cutf_span_t span;
+                TEST_ASSERT(cutf_iter_next(&iter, &c, &span) == CUTF_SUCCESS);
+                TEST_ASSERT(c == test_pairs[i].p32[count]);
+                TEST_ASSERT(span.start == end && span.length != 0);
+                end = span.start + span.length;
+                count += 1;
+            }
+            TEST_ASSERT(count == test_pairs[i].sz32);
+            TEST_ASSERT(end == iter.size);
+
+            // Block decoding gives the same result, no matter the size of the blocks
+            for (size_t block = 1; block <= 16; ++block)
+            {
+                iter = iters[j];
+                char32_t out[256];
+                count = 0;
+                while (!cutf_iter_done(&iter))
+                {
+                    size_t written;
+                    TEST_ASSERT(cutf_iter_next_block(&iter, block, out + count, &written) == CUTF_SUCCESS);
+                    TEST_ASSERT(written != 0 && written <= block);
+                    count += written;
+                }
+                TEST_ASSERT(count == test_pairs[i].sz32);
+                for (unsigned k = 0; k < count; ++k)
+                    TEST_ASSERT(out[k] == test_pairs[i].p32[k]);
+            }
+        }
+    }
+
+    // Errors stop the iterator at the codepoint which caused them
+    {
+        const char8_t *const str = u8"abcdefghij\x80klm";
+        cutf_iter_t iter = cutf_iter_utf8(14, str);
+        char32_t out[16];
+        size_t written;
+        TEST_ASSERT(cutf_iter_next_block(&iter, 16, out, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(written == 10 && iter.position == 10);
+        char32_t c;
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(iter.position == 10);
+
+        iter = cutf_iter_utf16(2, u"a\xD83D");
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_SUCCESS);
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(iter.position == 1);
+
+        iter = cutf_iter_utf32(1, U"\xD800");
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT);
+    }
+
+    // UTF-8 sequences which are well formed, but encode overlong values, surrogates or values above U+10FFFF
+    {
+        static const char8_t invalid[][5] = {
+            u8"\xC0\x80",         u8"\xC1\x81",         u8"\xE0\x80\x80", u8"\xE0\x9F\xBF",
+            u8"\xF0\x80\x80\x80", u8"\xF0\x8F\xBF\xBF", u8"\xED\xA0\x80", u8"\xED\xBF\xBF",
+            u8"\xF4\x90\x80\x80", u8"\xF7\xBF\xBF\xBF",
+        };
+        for (unsigned i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+        {
+            char8_t str[16] = u8"a";
+            auto const length = strlen((const char *)invalid[i]);
+            memcpy(str + 1, invalid[i], length);
+            auto iter = cutf_iter_utf8(1 + length, str);
+            char32_t c;
+            TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_SUCCESS && c == U'a');
+            TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT && iter.position == 1);
+
+            iter = cutf_iter_utf8(1 + length, str);
+            char32_t out[4];
+            size_t written;
+            TEST_ASSERT(cutf_iter_next_block(&iter, 4, out, &written) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(written == 1 && iter.position == 1);
+
+            // Input which ends after the first continuation unit can not be completed either
+            for (size_t cut = 3; cut < 1 + length; ++cut)
+            {
+                iter = cutf_iter_utf8(cut, str);
+                TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_SUCCESS);
+                TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT && iter.position == 1);
+            }
+        }
+        char32_t c;
+        auto iter = cutf_iter_utf8(1, u8"\xC1");
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT);
+        iter = cutf_iter_utf8(1, u8"\xF5");
+        TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INVALID_INPUT);
+
+        // Starts of codepoints which more units can still complete
+        static const char8_t incomplete[][4] = {u8"\xE0", u8"\xE0\xA0", u8"\xED\x9F", u8"\xF0\x90\x80", u8"\xF4\x8F"};
+        for (unsigned i = 0; i < sizeof(incomplete) / sizeof(*incomplete); ++i)
+        {
+            iter = cutf_iter_utf8(strlen((const char *)incomplete[i]), incomplete[i]);
+            TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_INCOMPLETE_INPUT && iter.position == 0);
+        }
+
+        // The lowest and highest values of each length are decoded
+        static const char8_t valid[][5] = {
+            u8"\xC2\x80",     u8"\xE0\xA0\x80",     u8"\xED\x9F\xBF",
+            u8"\xEE\x80\x80", u8"\xF0\x90\x80\x80", u8"\xF4\x8F\xBF\xBF",
+        };
+        static const char32_t values[] = {0x80, 0x800, 0xD7FF, 0xE000, 0x10000, 0x10FFFF};
+        for (unsigned i = 0; i < sizeof(valid) / sizeof(*valid); ++i)
+        {
+            auto iter = cutf_iter_utf8(strlen((const char *)valid[i]), valid[i]);
+            char32_t c;
+            TEST_ASSERT(cutf_iter_next(&iter, &c, nullptr) == CUTF_SUCCESS && c == values[i] && cutf_iter_done(&iter));
+        }
+    }
+
+    return 0;
+}
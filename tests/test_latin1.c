@@ -0,0 +1,104 @@
+#include "test_common.h"
+#include <string.h>
+
+int main(void)
+{
+    // Check all Latin-1 characters make the round trip through every encoding
+    {
+        unsigned char latin1[256], back[256];
+        for (unsigned i = 0; i < 256; ++i)
+            latin1[i] = (unsigned char)i;
+
+        char8_t out8[512];
+        char16_t out16[256];
+        char32_t out32[256];
+        size_t consumed, written, written_back;
+        cutf_state_t state = {0};
+
+        TEST_ASSERT(cutf_sl1tos8(256, latin1, 512, &consumed, out8, &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 256 && written == 128 + 2 * 128);
+        TEST_ASSERT(cutf_fits_latin1_s8(written, out8));
+        TEST_ASSERT(cutf_s8tosl1(written, out8, 256, &consumed, back, &written_back, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == written && written_back == 256);
+        TEST_ASSERT(memcmp(latin1, back, 256) == 0);
+
+        TEST_ASSERT(cutf_sl1tos16(256, latin1, 256, &consumed, out16, &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 256 && written == 256);
+        TEST_ASSERT(cutf_fits_latin1_s16(256, out16));
+        TEST_ASSERT(cutf_s16tosl1(256, out16, 256, &consumed, back, &written_back, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(memcmp(latin1, back, 256) == 0);
+
+        TEST_ASSERT(cutf_sl1tos32(256, latin1, 256, &consumed, out32, &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 256 && written == 256);
+        TEST_ASSERT(cutf_fits_latin1_s32(256, out32));
+        TEST_ASSERT(cutf_s32tosl1(256, out32, 256, &consumed, back, &written_back, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(memcmp(latin1, back, 256) == 0);
+
+        // Check conversion to UTF-8 works one unit at a time
+        size_t pos_in = 0, pos_out = 0;
+        while (pos_out < 384)
+        {
+            auto const res =
+                cutf_sl1tos8(256 - pos_in, latin1 + pos_in, 1, &consumed, out8 + pos_out, &written, &state);
+            TEST_ASSERT(res == CUTF_SUCCESS || res == CUTF_INSUFFICIENT_BUFFER);
+            TEST_ASSERT(written == 1);
+            pos_in += consumed;
+            pos_out += written;
+        }
+        TEST_ASSERT(pos_in == 256);
+        TEST_ASSERT(state.state_type == CUTF_STATE_CLEAR);
+        TEST_ASSERT(cutf_s8tosl1(384, out8, 256, &consumed, back, &written_back, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(memcmp(latin1, back, 256) == 0);
+    }
+
+    // Check characters which do not fit are rejected or substituted
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        unsigned char out[256];
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        auto const fits = cutf_fits_latin1_s32(test_pairs[i].sz32, test_pairs[i].p32);
+        TEST_ASSERT(fits == cutf_fits_latin1_s8(test_pairs[i].sz8, test_pairs[i].p8));
+        TEST_ASSERT(fits == cutf_fits_latin1_s16(test_pairs[i].sz16, test_pairs[i].p16));
+
+        auto res = cutf_s8tosl1(test_pairs[i].sz8, test_pairs[i].p8, 256, &consumed, out, &written, CUTF_LATIN1_STRICT,
+                                &state);
+        TEST_ASSERT(res == (fits ? CUTF_SUCCESS : CUTF_INVALID_INPUT));
+        res = cutf_s16tosl1(test_pairs[i].sz16, test_pairs[i].p16, 256, &consumed, out, &written, CUTF_LATIN1_STRICT,
+                            &state);
+        TEST_ASSERT(res == (fits ? CUTF_SUCCESS : CUTF_INVALID_INPUT));
+
+        state = (cutf_state_t){0};
+        res = cutf_s16tosl1(test_pairs[i].sz16, test_pairs[i].p16, 256, &consumed, out, &written,
+                            CUTF_LATIN1_SUBSTITUTE, &state);
+        TEST_ASSERT(res == CUTF_SUCCESS);
+        TEST_ASSERT(written == test_pairs[i].sz32);
+        for (unsigned j = 0; j < written; ++j)
+            TEST_ASSERT(out[j] == (test_pairs[i].p32[j] < 0x100 ? test_pairs[i].p32[j] : '?'));
+
+        res = cutf_s32tosl1(test_pairs[i].sz32, test_pairs[i].p32, 256, &consumed, out, &written,
+                            CUTF_LATIN1_SUBSTITUTE, &state);
+        TEST_ASSERT(res == CUTF_SUCCESS);
+        TEST_ASSERT(written == test_pairs[i].sz32);
+    }
+
+    // Check incomplete input is kept in the state
+    {
+        unsigned char out[4];
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s8tosl1(2, u8"a\xC3", 4, &consumed, out, &written, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 2 && written == 1);
+        TEST_ASSERT(cutf_s8tosl1(1, u8"\xA9", 3, &consumed, out + 1, &written, CUTF_LATIN1_STRICT, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(out[0] == 'a' && out[1] == 0xE9);
+    }
+
+    return 0;
+}
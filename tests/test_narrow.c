@@ -0,0 +1,97 @@
+#include "test_common.h"
+#include <string.h>
+
+static void check_narrow(const test_pair_t *const pair, const cutf_width_class_t expected_class)
+{
+    cutf_analysis_t analysis8, analysis16;
+    size_t valid8, valid16;
+    TEST_ASSERT(cutf_analyze_s8(pair->sz8, pair->p8, &valid8, &analysis8) == CUTF_SUCCESS);
+    TEST_ASSERT(cutf_analyze_s16(pair->sz16, pair->p16, &valid16, &analysis16) == CUTF_SUCCESS);
+    TEST_ASSERT(valid8 == pair->sz8 && valid16 == pair->sz16);
+    TEST_ASSERT(analysis8.count == pair->sz32 && analysis16.count == pair->sz32);
+    TEST_ASSERT(analysis8.width_class == expected_class && analysis16.width_class == expected_class);
+
+    // Convert into the chosen width and compare with UTF-32
+    char32_t buffer[256];
+    size_t consumed, written;
+    cutf_state_t state = {0};
+    TEST_ASSERT(cutf_s8tonarrow(pair->sz8, pair->p8, expected_class, 256, &consumed, buffer, &written, &state) ==
+                CUTF_SUCCESS);
+    TEST_ASSERT(consumed == pair->sz8 && written == pair->sz32);
+    for (unsigned i = 0; i < written; ++i)
+    {
+        char32_t c;
+        switch (cutf_width_class_size(expected_class))
+        {
+        case 1:
+            c = ((const unsigned char *)buffer)[i];
+            break;
+        case 2:
+            c = ((const char16_t *)buffer)[i];
+            break;
+        default:
+            c = buffer[i];
+            break;
+        }
+        TEST_ASSERT(c == pair->p32[i]);
+    }
+
+    char32_t buffer16[256];
+    TEST_ASSERT(cutf_s16tonarrow(pair->sz16, pair->p16, expected_class, 256, &consumed, buffer16, &written, &state) ==
+                CUTF_SUCCESS);
+    TEST_ASSERT(consumed == pair->sz16 && written == pair->sz32);
+    TEST_ASSERT(memcmp(buffer, buffer16, written * cutf_width_class_size(expected_class)) == 0);
+}
+
+int main(void)
+{
+    check_narrow(&test_pairs[0], CUTF_WIDTH_ASCII);
+    check_narrow(&test_pairs[1], CUTF_WIDTH_ASCII);
+    check_narrow(&test_pairs[2], CUTF_WIDTH_BMP);
+    check_narrow(&test_pairs[3], CUTF_WIDTH_ASTRAL);
+    check_narrow(&test_pairs[4], CUTF_WIDTH_ASTRAL);
+    check_narrow(&test_pairs[5], CUTF_WIDTH_BMP);
+    check_narrow(&test_pairs[6], CUTF_WIDTH_BMP);
+    check_narrow(&ADD_TEST_PAIR(a rather long café menu), CUTF_WIDTH_LATIN1);
+
+    // Check codepoints which do not fit are rejected
+    {
+        char16_t out[16];
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s8tonarrow(test_pairs[3].sz8, test_pairs[3].p8, CUTF_WIDTH_BMP, 16, &consumed, out, &written,
+                                    &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s16tonarrow(test_pairs[2].sz16, test_pairs[2].p16, CUTF_WIDTH_LATIN1, 16, &consumed, out,
+                                     &written, &state) == CUTF_INVALID_INPUT);
+    }
+
+    // Check invalid and incomplete input is reported
+    {
+        cutf_analysis_t analysis;
+        size_t valid;
+        TEST_ASSERT(cutf_analyze_s8(4, u8"ab\xF0\x9F", &valid, &analysis) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(valid == 2 && analysis.count == 2);
+        TEST_ASSERT(cutf_analyze_s16(3, u"ab\xDC00", &valid, &analysis) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == 2 && analysis.count == 2);
+        TEST_ASSERT(cutf_analyze_s16(3, u"ab\xD83D", &valid, &analysis) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(valid == 2);
+
+        // Surrogates, values above U+10FFFF and overlong encodings are rejected by the analysis and the conversion
+        static const char8_t invalid[][8] = {u8"ab\xED\xA0\x80", u8"ab\xF4\x90\x80\x80", u8"ab\xC1\x81",
+                                             u8"ab\xE0\x80\x80"};
+        for (unsigned i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+        {
+            auto const sz = strlen((const char *)invalid[i]);
+            TEST_ASSERT(cutf_analyze_s8(sz, invalid[i], &valid, &analysis) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2 && analysis.count == 2);
+
+            char32_t out[8];
+            size_t consumed, written;
+            cutf_state_t state = {0};
+            TEST_ASSERT(cutf_s8tonarrow(sz, invalid[i], CUTF_WIDTH_ASTRAL, 8, &consumed, out, &written, &state) ==
+                        CUTF_INVALID_INPUT);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "test_common.h"
+
+#include <string.h>
+
+int main(void)
+{
+    // Statistics of the test strings match counting them separately
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        char16_t buffer16[64];
+        char32_t buffer32[64];
+        size_t consumed, written;
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        cutf_stats_t stats16 = CUTF_STATS_INITIALIZER, stats32 = CUTF_STATS_INITIALIZER;
+        TEST_ASSERT(cutf_s8tos16_stats(test_pairs[i].sz8, test_pairs[i].p8, 64, &consumed, buffer16, &written, &stats16,
+                                       &state) == CUTF_SUCCESS);
+        TEST_ASSERT(written == test_pairs[i].sz16);
+        TEST_ASSERT(memcmp(buffer16, test_pairs[i].p16, written * sizeof(char16_t)) == 0);
+        TEST_ASSERT(cutf_s8tos32_stats(test_pairs[i].sz8, test_pairs[i].p8, 64, &consumed, buffer32, &written, &stats32,
+                                       &state) == CUTF_SUCCESS);
+        TEST_ASSERT(written == test_pairs[i].sz32);
+
+        char32_t max_codepoint = 0;
+        for (size_t j = 0; j < test_pairs[i].sz32; ++j)
+            max_codepoint = test_pairs[i].p32[j] > max_codepoint ? test_pairs[i].p32[j] : max_codepoint;
+        TEST_ASSERT(memcmp(&stats16, &stats32, sizeof(stats16)) == 0);
+        TEST_ASSERT(stats16.codepoints == test_pairs[i].sz32);
+        TEST_ASSERT(stats16.lines == 0);
+        TEST_ASSERT(stats16.max_codepoint == max_codepoint);
+        TEST_ASSERT(stats16.is_ascii == (test_pairs[i].sz8 == test_pairs[i].sz32));
+    }
+
+    // Lines are counted with carriage return and line feed counted once, even when split between calls
+    {
+        static constexpr char8_t text[] = u8"first line of text\r\nsecond line\u2028of text\rthird\n\nfifth line end ";
+        enum
+        {
+            SZ_TEXT = sizeof(text) - 1,
+        };
+        char16_t buffer[SZ_TEXT];
+        for (size_t split = 0; split <= SZ_TEXT; ++split)
+        {
+            size_t consumed, written, written2;
+            cutf_state_t state = CUTF_STATE_INITIALIZER;
+            cutf_stats_t stats = CUTF_STATS_INITIALIZER;
+            auto const first = cutf_s8tos16_stats(split, text, SZ_TEXT, &consumed, buffer, &written, &stats, &state);
+            TEST_ASSERT(first == CUTF_SUCCESS || first == CUTF_INCOMPLETE_INPUT);
+            TEST_ASSERT(cutf_s8tos16_stats(SZ_TEXT - split, text + split, SZ_TEXT - written, &consumed,
+                                           buffer + written, &written2, &stats, &state) == CUTF_SUCCESS);
+            TEST_ASSERT(stats.codepoints == 62 && stats.lines == 5);
+            TEST_ASSERT(stats.max_codepoint == 0x2028 && !stats.is_ascii && stats.last == U' ');
+        }
+    }
+
+    // Only codepoints consumed are counted
+    {
+        char32_t buffer[4];
+        size_t consumed, written;
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        cutf_stats_t stats = CUTF_STATS_INITIALIZER;
+        TEST_ASSERT(cutf_s8tos32_stats(14, u8"line\none\ntwo\n", 4, &consumed, buffer, &written, &stats, &state) ==
+                    CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(stats.codepoints == 4 && stats.lines == 0 && stats.is_ascii && stats.max_codepoint == U'n');
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "test_common.h"
+
+#include <string.h>
+
+static constexpr cutf_store_mode_t modes[] = {CUTF_STORE_AUTO, CUTF_STORE_CACHED, CUTF_STORE_STREAMING};
+
+int main(void)
+{
+    // Every mode gives the same result, for any alignment of the output
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        for (unsigned m = 0; m < sizeof(modes) / sizeof(*modes); ++m)
+        {
+            for (unsigned offset = 0; offset < 4; ++offset)
+            {
+                char32_t buffer[64];
+                size_t consumed, written;
+                cutf_state_t state = CUTF_STATE_INITIALIZER;
+                TEST_ASSERT(cutf_s8tos32_store(test_pairs[i].sz8, test_pairs[i].p8, 64 - offset, &consumed,
+                                               buffer + offset, &written, modes[m], &state) == CUTF_SUCCESS);
+                TEST_ASSERT(consumed == test_pairs[i].sz8 && written == test_pairs[i].sz32);
+                TEST_ASSERT(memcmp(buffer + offset, test_pairs[i].p32, written * sizeof(char32_t)) == 0);
+            }
+        }
+    }
+
+    // Long mixed input, split into two calls in the middle of a codepoint
+    {
+        static constexpr char8_t line[] = u8"The quick brown fox ケツを食べる 🗿 jumps over the lazy dog.\n";
+        static constexpr char32_t line32[] = U"The quick brown fox ケツを食べる 🗿 jumps over the lazy dog.\n";
+        enum
+        {
+            REPEATS = 100,
+            LINE8 = sizeof(line) - 1,
+            LINE32 = sizeof(line32) / sizeof(char32_t) - 1,
+        };
+        char8_t *const p_in = malloc(REPEATS * LINE8);
+        char32_t *const p_out = malloc(REPEATS * LINE32 * sizeof(char32_t));
+        TEST_ASSERT(p_in != nullptr && p_out != nullptr);
+        for (unsigned r = 0; r < REPEATS; ++r)
+            memcpy(p_in + r * LINE8, line, LINE8);
+
+        size_t split = 0;
+        while (line[split] < 0x80)
+            split += 1;
+        split += 1;
+
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        size_t consumed, written, written2;
+        TEST_ASSERT(cutf_s8tos32_store(split, p_in, REPEATS * LINE32, &consumed, p_out, &written, CUTF_STORE_STREAMING,
+                                       &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == split && written == split - 1);
+        TEST_ASSERT(cutf_s8tos32_store(REPEATS * LINE8 - split, p_in + split, REPEATS * LINE32 - written, &consumed,
+                                       p_out + written, &written2, CUTF_STORE_STREAMING, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == REPEATS * LINE8 - split && written + written2 == REPEATS * LINE32);
+        for (unsigned r = 0; r < REPEATS; ++r)
+            TEST_ASSERT(memcmp(p_out + r * LINE32, line32, LINE32 * sizeof(char32_t)) == 0);
+
+        // Errors and a short output buffer are reported as usual
+        p_in[LINE8 * 3 + 1] = 0xFF;
+        state = CUTF_STATE_INITIALIZER;
+        TEST_ASSERT(cutf_s8tos32_store(REPEATS * LINE8, p_in, REPEATS * LINE32, &consumed, p_out, &written,
+                                       CUTF_STORE_STREAMING, &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s8tos32_store(LINE8, p_in, LINE32 - 1, &consumed, p_out, &written, CUTF_STORE_STREAMING,
+                                       &state) == CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(written == LINE32 - 1);
+
+        free(p_in);
+        free(p_out);
+    }
+
+    // Input above the threshold switches to streaming automatically, and converts the same
+    {
+        auto const sz = CUTF_STREAMING_THRESHOLD / sizeof(char32_t) + 3;
+        char8_t *const p_in = malloc(sz);
+        char32_t *const p_out = malloc(sz * sizeof(char32_t));
+        TEST_ASSERT(p_in != nullptr && p_out != nullptr);
+        for (size_t i = 0; i < sz; ++i)
+            p_in[i] = (char8_t)('a' + i % 26);
+
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        size_t consumed, written;
+        TEST_ASSERT(cutf_s8tos32(sz, p_in, sz, &consumed, p_out, &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == sz && written == sz);
+        for (size_t i = 0; i < sz; ++i)
+            TEST_ASSERT(p_out[i] == (char32_t)('a' + i % 26));
+
+        free(p_in);
+        free(p_out);
+    }
+
+    return 0;
+}
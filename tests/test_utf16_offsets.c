@@ -0,0 +1,72 @@
+#include "test_common.h"
+
+int main(void)
+{
+    // Check every codepoint boundary converts in both directions
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        size_t offsets8[256], offsets16[256];
+        unsigned n = 0;
+        size_t i8 = 0, i16 = 0;
+        for (;;)
+        {
+            offsets8[n] = i8;
+            offsets16[n] = i16;
+            n += 1;
+            if (i8 == test_pairs[i].sz8)
+                break;
+
+            size_t consumed;
+            auto const res = cutf_utf8_next_codepoint(test_pairs[i].sz8 - i8, test_pairs[i].p8 + i8, &consumed);
+            TEST_ASSERT(res == CUTF_SUCCESS);
+            i8 += consumed;
+            i16 += (test_pairs[i].p16[i16] >= 0xD800 && test_pairs[i].p16[i16] <= 0xDBFF) ? 2 : 1;
+        }
+        TEST_ASSERT(i16 == test_pairs[i].sz16);
+
+        for (unsigned j = 0; j < n; ++j)
+        {
+            size_t offset;
+            auto res = cutf_utf16_offset_to_utf8(test_pairs[i].sz8, test_pairs[i].p8, offsets16[j], &offset);
+            TEST_ASSERT(res == CUTF_SUCCESS);
+            TEST_ASSERT(offset == offsets8[j]);
+            res = cutf_utf8_offset_to_utf16(test_pairs[i].sz8, test_pairs[i].p8, offsets8[j], &offset);
+            TEST_ASSERT(res == CUTF_SUCCESS);
+            TEST_ASSERT(offset == offsets16[j]);
+        }
+
+        // Batched conversion must give the same results
+        size_t out[256], converted;
+        auto res = cutf_utf16_offsets_to_utf8(test_pairs[i].sz8, test_pairs[i].p8, n, offsets16, out, &converted);
+        TEST_ASSERT(res == CUTF_SUCCESS);
+        TEST_ASSERT(converted == n);
+        for (unsigned j = 0; j < n; ++j)
+            TEST_ASSERT(out[j] == offsets8[j]);
+
+        res = cutf_utf8_offsets_to_utf16(test_pairs[i].sz8, test_pairs[i].p8, n, offsets8, out, &converted);
+        TEST_ASSERT(res == CUTF_SUCCESS);
+        TEST_ASSERT(converted == n);
+        for (unsigned j = 0; j < n; ++j)
+            TEST_ASSERT(out[j] == offsets16[j]);
+    }
+
+    // Check invalid offsets are rejected
+    {
+        const char8_t *const str = u8"a🗿b";
+        size_t offset;
+        // Past the end
+        TEST_ASSERT(cutf_utf16_offset_to_utf8(6, str, 5, &offset) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_utf8_offset_to_utf16(6, str, 7, &offset) == CUTF_INCOMPLETE_INPUT);
+        // Middle of a surrogate pair
+        TEST_ASSERT(cutf_utf16_offset_to_utf8(6, str, 2, &offset) == CUTF_INVALID_INPUT);
+        // Middle of a UTF-8 sequence
+        TEST_ASSERT(cutf_utf8_offset_to_utf16(6, str, 3, &offset) == CUTF_INVALID_INPUT);
+        // Unsorted offsets
+        size_t converted, out[2];
+        TEST_ASSERT(cutf_utf16_offsets_to_utf8(6, str, 2, (size_t[]){3, 1}, out, &converted) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(converted == 1);
+        TEST_ASSERT(out[0] == 5);
+    }
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "test_common.h"
+#include <string.h>
+
+static void check_round_trip(const size_t sz16, const char16_t *const p16, const size_t sz8, const char8_t *const p8,
+                             const cutf_utf8_variant_t variant)
+{
+    char8_t out8[256];
+    char16_t out16[256];
+    size_t consumed, written;
+    cutf_state_t state = {0};
+
+    auto res = cutf_s16tos8_variant(sz16, p16, 256, &consumed, out8, &written, variant, &state);
+    if (res == CUTF_INCOMPLETE_INPUT)
+    {
+        // Flush the lone high surrogate at the end
+        size_t flushed;
+        res = cutf_s16tos8_variant(0, p16, 256 - written, &consumed, out8 + written, &flushed, variant, &state);
+        written += flushed;
+    }
+    TEST_ASSERT(res == CUTF_SUCCESS);
+    TEST_ASSERT(written == sz8);
+    TEST_ASSERT(memcmp(out8, p8, sz8) == 0);
+
+    res = cutf_s8tos16_variant(sz8, p8, 256, &consumed, out16, &written, variant, &state);
+    TEST_ASSERT(consumed == sz8);
+    if (res == CUTF_INCOMPLETE_INPUT)
+    {
+        // Flush the lone high surrogate at the end
+        size_t flushed;
+        res = cutf_s8tos16_variant(0, p8, 256 - written, &consumed, out16 + written, &flushed, variant, &state);
+        written += flushed;
+    }
+    TEST_ASSERT(res == CUTF_SUCCESS);
+    TEST_ASSERT(written == sz16);
+    TEST_ASSERT(memcmp(out16, p16, sz16 * sizeof(char16_t)) == 0);
+
+    // Check the conversion works one unit at a time
+    state = (cutf_state_t){0};
+    size_t pos_in = 0, pos_out = 0;
+    for (; pos_in < sz16; pos_in += consumed, pos_out += written)
+    {
+        res = cutf_s16tos8_variant(1, p16 + pos_in, 256 - pos_out, &consumed, out8 + pos_out, &written, variant,
+                                   &state);
+        TEST_ASSERT(res == CUTF_SUCCESS || res == CUTF_INCOMPLETE_INPUT);
+    }
+    if (state.state_type != CUTF_STATE_CLEAR)
+    {
+        res = cutf_s16tos8_variant(0, p16, 256 - pos_out, &consumed, out8 + pos_out, &written, variant, &state);
+        TEST_ASSERT(res == CUTF_SUCCESS);
+        pos_out += written;
+    }
+    TEST_ASSERT(pos_out == sz8);
+    TEST_ASSERT(memcmp(out8, p8, sz8) == 0);
+
+    for (pos_in = 0, pos_out = 0; pos_in < sz8; pos_in += consumed, pos_out += written)
+    {
+        res = cutf_s8tos16_variant(1, p8 + pos_in, 256 - pos_out, &consumed, out16 + pos_out, &written, variant,
+                                   &state);
+        TEST_ASSERT(res == CUTF_SUCCESS || res == CUTF_INCOMPLETE_INPUT);
+    }
+    if (state.state_type != CUTF_STATE_CLEAR)
+    {
+        res = cutf_s8tos16_variant(0, p8, 256 - pos_out, &consumed, out16 + pos_out, &written, variant, &state);
+        pos_out += written;
+    }
+    TEST_ASSERT(res == CUTF_SUCCESS);
+    TEST_ASSERT(pos_out == sz16);
+    TEST_ASSERT(memcmp(out16, p16, sz16 * sizeof(char16_t)) == 0);
+}
+
+int main(void)
+{
+    // Well-formed strings are encoded the same as UTF-8 in WTF-8
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        check_round_trip(test_pairs[i].sz16, test_pairs[i].p16, test_pairs[i].sz8, test_pairs[i].p8,
+                         CUTF_UTF8_STANDARD);
+        check_round_trip(test_pairs[i].sz16, test_pairs[i].p16, test_pairs[i].sz8, test_pairs[i].p8, CUTF_UTF8_WTF8);
+    }
+
+    // Lone surrogates are preserved by WTF-8 and Modified UTF-8
+    check_round_trip(5, u"a\xD800" "b\xDC00\xD83D", 11, u8"a\xED\xA0\x80" "b\xED\xB0\x80\xED\xA0\xBD",
+                     CUTF_UTF8_WTF8);
+    check_round_trip(5, u"a\xD800" "b\xDC00\xD83D", 11, u8"a\xED\xA0\x80" "b\xED\xB0\x80\xED\xA0\xBD",
+                     CUTF_UTF8_MUTF8);
+
+    // Supplementary characters are encoded as two surrogates in CESU-8 and Modified UTF-8
+    check_round_trip(4, u"x\xD83D\xDE00y", 8, u8"x\xED\xA0\xBD\xED\xB8\x80y", CUTF_UTF8_CESU8);
+    check_round_trip(4, u"x\xD83D\xDE00y", 8, u8"x\xED\xA0\xBD\xED\xB8\x80y", CUTF_UTF8_MUTF8);
+    check_round_trip(4, u"x\xD83D\xDE00y", 6, u8"x\xF0\x9F\x98\x80y", CUTF_UTF8_WTF8);
+
+    // U+0000 is encoded with two units in Modified UTF-8
+    check_round_trip(11, u"abc\0defghij", 12, u8"abc\xC0\x80" "defghij", CUTF_UTF8_MUTF8);
+    check_round_trip(11, u"abc\0defghij", 11, u8"abc\0defghij", CUTF_UTF8_CESU8);
+
+    // Check what each variant rejects
+    {
+        char8_t out8[16];
+        char16_t out16[16];
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s16tos8_variant(2, u"a\xDC00", 16, &consumed, out8, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(cutf_s16tos8_variant(2, u"\xD800" "a", 16, &consumed, out8, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s16tos8_variant(1, u"\xD800", 16, &consumed, out8, &written, CUTF_UTF8_STANDARD, &state) ==
+                    CUTF_INCOMPLETE_INPUT);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(4, u8"\xF0\x9F\x98\x80", 16, &consumed, out16, &written, CUTF_UTF8_CESU8,
+                                         &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s8tos16_variant(3, u8"\xED\xA0\x80", 16, &consumed, out16, &written, CUTF_UTF8_STANDARD,
+                                         &state) == CUTF_INVALID_INPUT);
+
+        // CESU-8 only allows surrogates in pairs, also when the pair is split between calls
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s16tos8_variant(1, u"\xD800", 16, &consumed, out8, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_s16tos8_variant(0, u"", 16, &consumed, out8, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(written == 0);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(4, u8"a\xED\xA0\x80", 16, &consumed, out16, &written, CUTF_UTF8_CESU8,
+                                         &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 4 && written == 1 && !cutf_state_is_clean(state));
+        TEST_ASSERT(cutf_s8tos16_variant(0, u8"", 16, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(written == 0 && !cutf_state_is_clean(state));
+        TEST_ASSERT(cutf_s8tos16_variant(1, u8"a", 16, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INVALID_INPUT);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(4, u8"\xED\xA0\x80" "a", 16, &consumed, out16, &written, CUTF_UTF8_CESU8,
+                                         &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 3 && written == 0);
+
+        // The high surrogate is only written out together with its low surrogate, which may come a unit at a time
+        state = (cutf_state_t){0};
+        const char8_t pair[] = u8"\xED\xA0\xBD\xED\xB8\x80";
+        for (size_t i = 0; i < 5; ++i)
+        {
+            TEST_ASSERT(cutf_s8tos16_variant(1, pair + i, 16, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                        CUTF_INCOMPLETE_INPUT);
+            TEST_ASSERT(consumed == 1 && written == 0 && !cutf_state_is_clean(state));
+        }
+        TEST_ASSERT(cutf_s8tos16_variant(1, pair + 5, 1, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 0 && written == 0);
+        TEST_ASSERT(cutf_s8tos16_variant(1, pair + 5, 16, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 1 && written == 2 && out16[0] == 0xD83D && out16[1] == 0xDE00);
+        TEST_ASSERT(cutf_state_is_clean(state));
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(4, u8"a\xED\xB0\x80", 16, &consumed, out16, &written, CUTF_UTF8_CESU8,
+                                         &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 1 && written == 1);
+
+        // WTF-8 encodes surrogate pairs as a four unit sequence only
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(6, u8"\xED\xA0\xBD\xED\xB8\x80", 16, &consumed, out16, &written,
+                                         CUTF_UTF8_WTF8, &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 3 && written == 0);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(4, u8"\xED\xA0\xBD\xED", 16, &consumed, out16, &written, CUTF_UTF8_WTF8,
+                                         &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(cutf_s8tos16_variant(2, u8"\xB8\x80", 16, &consumed, out16, &written, CUTF_UTF8_WTF8, &state) ==
+                    CUTF_INVALID_INPUT);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(3, u8"\xED\xA0\xBD", 16, &consumed, out16, &written, CUTF_UTF8_WTF8,
+                                         &state) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(written == 0 && !cutf_state_is_clean(state));
+        TEST_ASSERT(cutf_s8tos16_variant(1, u8"a", 16, &consumed, out16, &written, CUTF_UTF8_WTF8, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(written == 2 && out16[0] == 0xD83D && out16[1] == u'a' && cutf_state_is_clean(state));
+
+        // Modified UTF-8 never contains a zero unit, while the others only encode U+0000 as one
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(12, u8"abcdefghij\0k", 16, &consumed, out16, &written, CUTF_UTF8_MUTF8,
+                                         &state) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(consumed == 10 && written == 10);
+        state = (cutf_state_t){0};
+        TEST_ASSERT(cutf_s8tos16_variant(2, u8"\xC0\x80", 16, &consumed, out16, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s8tos16_variant(2, u8"\xC0\x80", 16, &consumed, out16, &written, CUTF_UTF8_WTF8, &state) ==
+                    CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_s16tos8_variant(2, u"\0a", 16, &consumed, out8, &written, CUTF_UTF8_MUTF8, &state) ==
+                    CUTF_SUCCESS);
+        TEST_ASSERT(written == 3 && memcmp(out8, u8"\xC0\x80" "a", 3) == 0);
+    }
+
+    // Sequences are only written out when they fit completely
+    {
+        char8_t out8[16];
+        char16_t out16[16];
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s16tos8_variant(3, u"a\xD83D\xDE00", 5, &consumed, out8, &written, CUTF_UTF8_CESU8, &state) ==
+                    CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 1 && written == 1);
+        TEST_ASSERT(cutf_s8tos16_variant(5, u8"a\xF0\x9F\x98\x80", 2, &consumed, out16, &written, CUTF_UTF8_WTF8,
+                                         &state) == CUTF_INSUFFICIENT_BUFFER);
+        TEST_ASSERT(consumed == 1 && written == 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "test_common.h"
+#include <string.h>
+
+int main(void)
+{
+    // Check leading whitespace is skipped, including non-ASCII whitespace
+    {
+        const char8_t *const str = u8"        \t  　x ";
+        const size_t len = strlen((const char *)str);
+        TEST_ASSERT(cutf_utf8_skip_whitespace(len, str) == len - 2);
+        TEST_ASSERT(cutf_utf8_skip_whitespace(3, u8"\xE3\x80\x80") == 3);
+        // Incomplete or invalid units are not whitespace
+        TEST_ASSERT(cutf_utf8_skip_whitespace(2, u8"\xE3\x80") == 0);
+        TEST_ASSERT(cutf_utf8_skip_whitespace(2, u8"\xA0 ") == 0);
+    }
+
+    // Check trimming
+    {
+        const char8_t *const str = u8"   ケツを 食べる　\r\n\xC2\x85";
+        auto const span = cutf_utf8_trim(strlen((const char *)str), str);
+        const char8_t *const expected = u8"ケツを 食べる";
+        TEST_ASSERT(span.length == strlen((const char *)expected));
+        TEST_ASSERT(memcmp(str + span.start, expected, span.length) == 0);
+
+        auto const empty = cutf_utf8_trim(4, u8" \t\r\n");
+        TEST_ASSERT(empty.length == 0);
+        // Continuation unit which only looks like the end of a whitespace character
+        auto const partial = cutf_utf8_trim(2, u8"a\xA0");
+        TEST_ASSERT(partial.start == 0 && partial.length == 2);
+    }
+
+    // Check splitting
+    {
+        const char8_t *const str = u8"  field-number-one\ttwo  three ケツ　 ";
+        const char *const expected[] = {"field-number-one", "two", "three", u8"ケツ"};
+        const size_t len = strlen((const char *)str);
+        size_t pos = 0;
+        cutf_span_t span;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            TEST_ASSERT(cutf_utf8_split_whitespace(len, str, &pos, &span));
+            TEST_ASSERT(span.length == strlen(expected[i]));
+            TEST_ASSERT(memcmp(str + span.start, expected[i], span.length) == 0);
+        }
+        TEST_ASSERT(!cutf_utf8_split_whitespace(len, str, &pos, &span));
+        TEST_ASSERT(pos == len);
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "test_common.h"
+#include <string.h>
+
+static void check_wrap(const char8_t *str, const size_t width, const unsigned n_lines, const char *const lines[])
+{
+    const size_t len = strlen((const char *)str);
+    cutf_span_t spans[64];
+    size_t consumed, written;
+    auto const res = cutf_utf8_wrap(len, str, width, 64, &consumed, spans, &written);
+    TEST_ASSERT(res == CUTF_SUCCESS);
+    TEST_ASSERT(consumed == len);
+    TEST_ASSERT(written == n_lines);
+    for (unsigned i = 0; i < n_lines; ++i)
+    {
+        TEST_ASSERT(spans[i].length == strlen(lines[i]));
+        TEST_ASSERT(memcmp(str + spans[i].start, lines[i], spans[i].length) == 0);
+    }
+}
+
+int main(void)
+{
+    // Check breaking at whitespace
+    check_wrap(u8"the quick brown fox jumps over the lazy dog", 10, 5,
+               (const char *[]){"the quick", "brown fox", "jumps over", "the lazy", "dog"});
+    // Check long words get broken and line terminators are respected
+    check_wrap(u8"abcdefghijkl\r\nmn\n\nopqrstuvwxyz0123456789 end", 5, 11,
+               (const char *[]){"abcde", "fghij", "kl", "mn", "", "opqrs", "tuvwx", "yz012", "34567", "89", "end"});
+    // Check ASCII blocks are handled correctly
+    check_wrap(u8"abcdefghijklmnopqrstuvwxyz0123456789 abcdefghijklmnopqrstuvwxyz", 40, 2,
+               (const char *[]){"abcdefghijklmnopqrstuvwxyz0123456789", "abcdefghijklmnopqrstuvwxyz"});
+    // Check width is counted in codepoints
+    check_wrap(u8"ケツを食べる", 2, 3, (const char *[]){u8"ケツ", u8"を食", u8"べる"});
+    check_wrap(u8"ケツを　食べる", 4, 2, (const char *[]){u8"ケツを", u8"食べる"});
+
+    // Check wrapping can be resumed when the output is full
+    {
+        const char8_t *const str = u8"one two three four five";
+        const size_t len = strlen((const char *)str);
+        const char *const expected[] = {"one", "two", "three", "four", "five"};
+        size_t pos = 0;
+        for (unsigned i = 0; i < 5; ++i)
+        {
+            cutf_span_t span;
+            size_t consumed, written;
+            auto const res = cutf_utf8_wrap(len - pos, str + pos, 5, 1, &consumed, &span, &written);
+            TEST_ASSERT(res == (i == 4 ? CUTF_SUCCESS : CUTF_INSUFFICIENT_BUFFER));
+            TEST_ASSERT(written == 1);
+            TEST_ASSERT(span.length == strlen(expected[i]));
+            TEST_ASSERT(memcmp(str + pos + span.start, expected[i], span.length) == 0);
+            pos += consumed;
+        }
+        TEST_ASSERT(pos == len);
+    }
+
+    // Check invalid input is rejected
+    {
+        cutf_span_t span;
+        size_t consumed, written;
+        TEST_ASSERT(cutf_utf8_wrap(3, u8"ab\xFF", 10, 1, &consumed, &span, &written) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(cutf_utf8_wrap(3, u8"ab\xE3", 10, 1, &consumed, &span, &written) == CUTF_INCOMPLETE_INPUT);
+        TEST_ASSERT(consumed == 0);
+        TEST_ASSERT(cutf_utf8_wrap(3, u8"abc", 0, 1, &consumed, &span, &written) == CUTF_INVALID_INPUT);
+    }
+
+    return 0;
+}
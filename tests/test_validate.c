@@ -0,0 +1,98 @@
+#include "test_common.h"
+#include <string.h>
+
+int main(void)
+{
+    // All test strings are valid and have the expected number of codepoints
+    for (unsigned i = 0; i < num_test_pairs; ++i)
+    {
+        size_t valid, count;
+        TEST_ASSERT(cutf_count_s16asc32(test_pairs[i].sz16, test_pairs[i].p16, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz16);
+        TEST_ASSERT(count == test_pairs[i].sz32);
+        TEST_ASSERT(cutf_is_utf16_valid(test_pairs[i].sz16, test_pairs[i].p16, &valid) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz16);
+        TEST_ASSERT(cutf_is_utf32_valid(test_pairs[i].sz32, test_pairs[i].p32, &valid) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz32);
+
+        // Counting units of the other encodings
+        TEST_ASSERT(cutf_count_s8asc16(test_pairs[i].sz8, test_pairs[i].p8, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz8 && count == test_pairs[i].sz16);
+        TEST_ASSERT(cutf_count_s16asc8(test_pairs[i].sz16, test_pairs[i].p16, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz16 && count == test_pairs[i].sz8);
+        TEST_ASSERT(cutf_count_s32asc8(test_pairs[i].sz32, test_pairs[i].p32, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz32 && count == test_pairs[i].sz8);
+        TEST_ASSERT(cutf_count_s32asc16(test_pairs[i].sz32, test_pairs[i].p32, &valid, &count) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == test_pairs[i].sz32 && count == test_pairs[i].sz16);
+        TEST_ASSERT(cutf_count_s8asc32_complete(test_pairs[i].sz8, test_pairs[i].p8) == test_pairs[i].sz32);
+    }
+
+    // Check errors are found at every position, both inside and outside the blocks checked at once
+    for (unsigned pos = 0; pos < 40; ++pos)
+    {
+        char16_t str16[40];
+        char32_t str32[40];
+        for (unsigned i = 0; i < 40; ++i)
+        {
+            str16[i] = u'a' + i % 26;
+            str32[i] = U'a' + i % 26;
+        }
+        size_t valid, count;
+
+        // Unpaired low surrogate
+        str16[pos] = 0xDC00;
+        TEST_ASSERT(cutf_count_s16asc32(40, str16, &valid, &count) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == pos && count == pos);
+
+        // Unpaired high surrogate, which is incomplete only at the end of the input
+        str16[pos] = 0xDBFF;
+        TEST_ASSERT(cutf_is_utf16_valid(40, str16, &valid) ==
+                    (pos == 39 ? CUTF_INCOMPLETE_INPUT : CUTF_INVALID_INPUT));
+        TEST_ASSERT(valid == pos);
+
+        // Surrogate pair using the highest high surrogate
+        if (pos < 39)
+        {
+            str16[pos + 1] = 0xDFFF;
+            TEST_ASSERT(cutf_count_s16asc32(40, str16, &valid, &count) == CUTF_SUCCESS);
+            TEST_ASSERT(valid == 40 && count == 39);
+        }
+
+        // Surrogates and values which are too large
+        str32[pos] = 0xD800;
+        TEST_ASSERT(cutf_is_utf32_valid(40, str32, &valid) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == pos);
+        str32[pos] = 0x110000;
+        TEST_ASSERT(cutf_is_utf32_valid(40, str32, &valid) == CUTF_INVALID_INPUT);
+        TEST_ASSERT(valid == pos);
+        str32[pos] = 0x10FFFF;
+        TEST_ASSERT(cutf_is_utf32_valid(40, str32, &valid) == CUTF_SUCCESS);
+        TEST_ASSERT(valid == 40);
+    }
+
+    // UTF-8 which is not converted is not valid either
+    {
+        const char8_t *const invalid[] = {u8"ab\xC1\x81", u8"ab\xE0\x9F\xBF", u8"ab\xED\xA0\x80",
+                                          u8"ab\xF4\x90\x80\x80"};
+        for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        {
+            size_t valid, count;
+            TEST_ASSERT(cutf_is_utf8_valid(strlen((const char *)invalid[i]), invalid[i], &valid) == CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2);
+            TEST_ASSERT(cutf_count_s8asc16(strlen((const char *)invalid[i]), invalid[i], &valid, &count) ==
+                        CUTF_INVALID_INPUT);
+            TEST_ASSERT(valid == 2 && count == 2);
+        }
+    }
+
+    // U+10FFFF converts through UTF-16
+    {
+        char32_t out;
+        size_t consumed, written;
+        cutf_state_t state = {0};
+        TEST_ASSERT(cutf_s16tos32(2, u"\xDBFF\xDFFF", 1, &consumed, &out, &written, &state) == CUTF_SUCCESS);
+        TEST_ASSERT(consumed == 2 && written == 1 && out == 0x10FFFF);
+    }
+
+    return 0;
+}
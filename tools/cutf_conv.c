@@ -0,0 +1,439 @@
+// cutf-conv: convert files between UTF-8, UTF-16 and UTF-32.
+//
+// Reading, converting and writing run in separate threads, connected by queues of blocks, such that the conversion of
+// one block overlaps with reading the next one and writing the previous one. The conversion state is carried from one
+// block to the next, so codepoints may be split between blocks.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <cutf.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+typedef enum
+{
+    BLOCK_SIZE = 1 << 20, // Number of input bytes in each block, which is a multiple of every unit size
+    // Largest output per input byte is UTF-8 to UTF-32, plus room for a codepoint carried over from the previous block
+    OUTPUT_BLOCK_SIZE = 4 * BLOCK_SIZE + 16,
+    PIPELINE_DEPTH = 3, // Number of blocks in flight, one being read, one converted and one written
+} pipeline_constants_t;
+
+typedef struct
+{
+    cutf_encoding_t encoding;
+    utf_endianness_t endianness; // Byte order relative to the machine
+} file_encoding_t;
+
+typedef struct
+{
+    const char *name;
+    cutf_encoding_t encoding;
+    bool big_endian;
+} encoding_name_t;
+
+static const encoding_name_t ENCODING_NAMES[] = {
+    {"utf8", CUTF_ENCODING_UTF8, false},     {"utf-8", CUTF_ENCODING_UTF8, false},
+    {"utf16le", CUTF_ENCODING_UTF16, false}, {"utf-16le", CUTF_ENCODING_UTF16, false},
+    {"utf16be", CUTF_ENCODING_UTF16, true},  {"utf-16be", CUTF_ENCODING_UTF16, true},
+    {"utf32le", CUTF_ENCODING_UTF32, false}, {"utf-32le", CUTF_ENCODING_UTF32, false},
+    {"utf32be", CUTF_ENCODING_UTF32, true},  {"utf-32be", CUTF_ENCODING_UTF32, true},
+};
+
+static bool machine_is_big_endian(void)
+{
+    const char16_t bom = cutf_utf16_bom(CUTF_ENDIANNESS_NATIVE);
+    unsigned char bytes[sizeof(bom)];
+    memcpy(bytes, &bom, sizeof(bom));
+    return bytes[0] == 0xFE;
+}
+
+static bool parse_encoding(const char *const name, file_encoding_t *const p_encoding)
+{
+    for (size_t i = 0; i < sizeof(ENCODING_NAMES) / sizeof(*ENCODING_NAMES); ++i)
+    {
+        if (strcmp(name, ENCODING_NAMES[i].name) != 0)
+            continue;
+
+        // UTF-8 has no byte order, so it always matches the one detected from its byte-order mark
+        p_encoding->encoding = ENCODING_NAMES[i].encoding;
+        p_encoding->endianness = ENCODING_NAMES[i].encoding == CUTF_ENCODING_UTF8 ||
+                                         ENCODING_NAMES[i].big_endian == machine_is_big_endian()
+                                     ? CUTF_ENDIANNESS_NATIVE
+                                     : CUTF_ENDIANNESS_REVERSE;
+        return true;
+    }
+    return false;
+}
+
+// Check if both files are the same one, also when reached through different paths. Only POSIX systems can tell.
+static bool same_file(FILE *const p_a, FILE *const p_b)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat a, b;
+    return fstat(fileno(p_a), &a) == 0 && fstat(fileno(p_b), &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#else
+    (void)p_a;
+    (void)p_b;
+    return false;
+#endif
+}
+
+// Detect the encoding from the byte-order mark at the start of the file, returning the length of the mark.
+static size_t detect_encoding(const size_t sz, const unsigned char p_start[static sz], file_encoding_t *p_encoding)
+{
+    // UTF-32 has to be checked first, since the little endian UTF-32 BOM starts with the little endian UTF-16 BOM
+    if (sz >= sizeof(char32_t))
+    {
+        char32_t bom;
+        memcpy(&bom, p_start, sizeof(bom));
+        auto const endianness = cutf_utf32_bom_endianness(bom);
+        if (endianness != CUTF_ENDIANNESS_INVALID)
+        {
+            *p_encoding = (file_encoding_t){.encoding = CUTF_ENCODING_UTF32, .endianness = endianness};
+            return sizeof(bom);
+        }
+    }
+    if (sz >= sizeof(char16_t))
+    {
+        char16_t bom;
+        memcpy(&bom, p_start, sizeof(bom));
+        auto const endianness = cutf_utf16_bom_endianness(bom);
+        if (endianness != CUTF_ENDIANNESS_INVALID)
+        {
+            *p_encoding = (file_encoding_t){.encoding = CUTF_ENCODING_UTF16, .endianness = endianness};
+            return sizeof(bom);
+        }
+    }
+
+    *p_encoding = (file_encoding_t){.encoding = CUTF_ENCODING_UTF8, .endianness = CUTF_ENDIANNESS_NATIVE};
+    if (sz >= 3 && p_start[0] == 0xEF && p_start[1] == 0xBB && p_start[2] == 0xBF)
+        return 3;
+    return 0;
+}
+
+typedef struct
+{
+    void *data;
+    size_t size; // Number of bytes in the block
+    bool last;   // Block is the last one of the file
+} block_t;
+
+typedef struct
+{
+    block_t *blocks[PIPELINE_DEPTH];
+    size_t first, count;
+} block_queue_t;
+
+// Queues connecting the stages of the pipeline. All of them share a single lock, since blocks are large enough that
+// contention is not an issue.
+typedef struct
+{
+    mtx_t lock;
+    cnd_t changed;
+    bool aborted;
+    block_queue_t free_input, full_input, free_output, full_output;
+    FILE *p_in, *p_out;
+} pipeline_t;
+
+static void queue_push(pipeline_t *const pipeline, block_queue_t *const queue, block_t *const block)
+{
+    mtx_lock(&pipeline->lock);
+    queue->blocks[(queue->first + queue->count) % PIPELINE_DEPTH] = block;
+    queue->count += 1;
+    cnd_broadcast(&pipeline->changed);
+    mtx_unlock(&pipeline->lock);
+}
+
+// Wait for the next block of the queue, returning NULL if the pipeline was aborted.
+static block_t *queue_pop(pipeline_t *const pipeline, block_queue_t *const queue)
+{
+    mtx_lock(&pipeline->lock);
+    while (queue->count == 0 && !pipeline->aborted)
+        cnd_wait(&pipeline->changed, &pipeline->lock);
+
+    block_t *block = nullptr;
+    if (!pipeline->aborted)
+    {
+        block = queue->blocks[queue->first];
+        queue->first = (queue->first + 1) % PIPELINE_DEPTH;
+        queue->count -= 1;
+    }
+    mtx_unlock(&pipeline->lock);
+    return block;
+}
+
+static void pipeline_abort(pipeline_t *const pipeline)
+{
+    mtx_lock(&pipeline->lock);
+    pipeline->aborted = true;
+    cnd_broadcast(&pipeline->changed);
+    mtx_unlock(&pipeline->lock);
+}
+
+static int reader_thread(void *const arg)
+{
+    pipeline_t *const pipeline = arg;
+    for (;;)
+    {
+        block_t *const block = queue_pop(pipeline, &pipeline->free_input);
+        if (!block)
+            return EXIT_FAILURE;
+
+        block->size = fread(block->data, 1, BLOCK_SIZE, pipeline->p_in);
+        block->last = block->size != BLOCK_SIZE;
+        if (ferror(pipeline->p_in))
+        {
+            fprintf(stderr, "cutf-conv: failed reading the input file\n");
+            pipeline_abort(pipeline);
+            return EXIT_FAILURE;
+        }
+
+        queue_push(pipeline, &pipeline->full_input, block);
+        if (block->last)
+            return EXIT_SUCCESS;
+    }
+}
+
+static int writer_thread(void *const arg)
+{
+    pipeline_t *const pipeline = arg;
+    for (;;)
+    {
+        block_t *const block = queue_pop(pipeline, &pipeline->full_output);
+        if (!block)
+            return EXIT_FAILURE;
+
+        if (fwrite(block->data, 1, block->size, pipeline->p_out) != block->size)
+        {
+            fprintf(stderr, "cutf-conv: failed writing the output file\n");
+            pipeline_abort(pipeline);
+            return EXIT_FAILURE;
+        }
+
+        if (block->last)
+            return EXIT_SUCCESS;
+        queue_push(pipeline, &pipeline->free_output, block);
+    }
+}
+
+static void swap_endianness(const cutf_encoding_t encoding, const size_t sz, void *const p_data)
+{
+    if (encoding == CUTF_ENCODING_UTF16)
+        cutf_utf16_swap_endianness(sz, p_data, p_data);
+    else if (encoding == CUTF_ENCODING_UTF32)
+        cutf_utf32_swap_endianness(sz, p_data, p_data);
+}
+
+static bool convert_blocks(pipeline_t *const pipeline, const file_encoding_t from, const file_encoding_t to)
+{
+    auto const in_unit = cutf_encoding_unit_size(from.encoding);
+    auto const out_unit = cutf_encoding_unit_size(to.encoding);
+    cutf_state_t state = CUTF_STATE_INITIALIZER;
+    size_t offset = 0;
+    for (;;)
+    {
+        block_t *const in = queue_pop(pipeline, &pipeline->full_input);
+        if (!in)
+            return false;
+        block_t *const out = queue_pop(pipeline, &pipeline->free_output);
+        if (!out)
+            return false;
+
+        if (in->size % in_unit != 0)
+        {
+            fprintf(stderr, "cutf-conv: input ends in the middle of a unit\n");
+            return false;
+        }
+        auto const units = in->size / in_unit;
+        if (from.endianness == CUTF_ENDIANNESS_REVERSE)
+            swap_endianness(from.encoding, units, in->data);
+
+        // Output blocks are large enough to fit the whole input block, so all of it is consumed
+        size_t consumed, written;
+        auto const res = cutf_convert(from.encoding, units, in->data, to.encoding, OUTPUT_BLOCK_SIZE / out_unit,
+                                      &consumed, out->data, &written, &state);
+        if (res == CUTF_INVALID_INPUT || res == CUTF_INSUFFICIENT_BUFFER)
+        {
+            fprintf(stderr, "cutf-conv: input is not correctly encoded after byte %zu\n", offset);
+            return false;
+        }
+        if (in->last && !cutf_state_is_clean(state))
+        {
+            fprintf(stderr, "cutf-conv: input ends in the middle of a codepoint\n");
+            return false;
+        }
+        offset += in->size;
+
+        if (to.endianness == CUTF_ENDIANNESS_REVERSE)
+            swap_endianness(to.encoding, written, out->data);
+        out->size = written * out_unit;
+        out->last = in->last;
+
+        queue_push(pipeline, &pipeline->full_output, out);
+        if (in->last)
+            return true;
+        queue_push(pipeline, &pipeline->free_input, in);
+    }
+}
+
+static bool run_pipeline(pipeline_t *const pipeline, const file_encoding_t from, const file_encoding_t to)
+{
+    thrd_t reader, writer;
+    if (thrd_create(&reader, reader_thread, pipeline) != thrd_success)
+        return false;
+    if (thrd_create(&writer, writer_thread, pipeline) != thrd_success)
+    {
+        pipeline_abort(pipeline);
+        thrd_join(reader, nullptr);
+        return false;
+    }
+
+    // Conversion happens on this thread
+    auto const success = convert_blocks(pipeline, from, to);
+    if (!success)
+        pipeline_abort(pipeline);
+
+    int reader_res, writer_res;
+    thrd_join(reader, &reader_res);
+    thrd_join(writer, &writer_res);
+    return success && reader_res == EXIT_SUCCESS && writer_res == EXIT_SUCCESS;
+}
+
+static int print_usage(void)
+{
+    fprintf(stderr, "usage: cutf-conv [-f ENCODING] -t ENCODING [-b] INPUT OUTPUT\n"
+                    "\n"
+                    "  -f ENCODING  encoding of the input, detected from its byte-order mark if not given\n"
+                    "  -t ENCODING  encoding of the output\n"
+                    "  -b           write a byte-order mark at the start of the output\n"
+                    "\n"
+                    "Encodings are utf8, utf16le, utf16be, utf32le and utf32be.\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *from_name = nullptr, *to_name = nullptr, *in_path = nullptr, *out_path = nullptr;
+    bool write_bom = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            from_name = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            to_name = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0)
+            write_bom = true;
+        else if (!in_path)
+            in_path = argv[i];
+        else if (!out_path)
+            out_path = argv[i];
+        else
+            return print_usage();
+    }
+    if (!to_name || !in_path || !out_path)
+        return print_usage();
+
+    file_encoding_t from, to;
+    if ((from_name && !parse_encoding(from_name, &from)) || !parse_encoding(to_name, &to))
+    {
+        fprintf(stderr, "cutf-conv: unknown encoding\n");
+        return print_usage();
+    }
+
+    FILE *const p_in = fopen(in_path, "rb");
+    if (!p_in)
+    {
+        fprintf(stderr, "cutf-conv: could not open %s\n", in_path);
+        return EXIT_FAILURE;
+    }
+    // The output is only truncated once it is known not to be the input, which would be emptied before it is read
+    FILE *p_out = fopen(out_path, "ab");
+    if (p_out && same_file(p_in, p_out))
+    {
+        fprintf(stderr, "cutf-conv: %s and %s are the same file\n", in_path, out_path);
+        fclose(p_out);
+        fclose(p_in);
+        return EXIT_FAILURE;
+    }
+    if (p_out)
+        p_out = freopen(out_path, "wb", p_out);
+    if (!p_out)
+    {
+        fprintf(stderr, "cutf-conv: could not open %s\n", out_path);
+        fclose(p_in);
+        return EXIT_FAILURE;
+    }
+
+    // Skip over the byte-order mark of the input, using it to determine the encoding if it was not given
+    unsigned char start[4];
+    auto const sz_start = fread(start, 1, sizeof(start), p_in);
+    file_encoding_t detected;
+    auto bom_length = detect_encoding(sz_start, start, &detected);
+    if (!from_name)
+        from = detected;
+    else if (detected.encoding != from.encoding || detected.endianness != from.endianness)
+        bom_length = 0;
+
+    bool success = fseek(p_in, (long)bom_length, SEEK_SET) == 0;
+    if (success && write_bom)
+    {
+        char32_t bom[1];
+        cutf_state_t state = CUTF_STATE_INITIALIZER;
+        size_t consumed, written;
+        auto const res = cutf_convert(CUTF_ENCODING_UTF32, 1, (const char32_t[]){0xFEFF}, to.encoding,
+                                      sizeof(bom) / cutf_encoding_unit_size(to.encoding), &consumed, bom, &written,
+                                      &state);
+        if (to.endianness == CUTF_ENDIANNESS_REVERSE)
+            swap_endianness(to.encoding, written, bom);
+        success = res == CUTF_SUCCESS && fwrite(bom, cutf_encoding_unit_size(to.encoding), written, p_out) == written;
+    }
+
+    pipeline_t pipeline = {.p_in = p_in, .p_out = p_out};
+    block_t input_blocks[PIPELINE_DEPTH], output_blocks[PIPELINE_DEPTH];
+    for (size_t i = 0; i < PIPELINE_DEPTH; ++i)
+    {
+        input_blocks[i] = (block_t){.data = malloc(BLOCK_SIZE)};
+        output_blocks[i] = (block_t){.data = malloc(OUTPUT_BLOCK_SIZE)};
+        success = success && input_blocks[i].data && output_blocks[i].data;
+        pipeline.free_input.blocks[i] = input_blocks + i;
+        pipeline.free_output.blocks[i] = output_blocks + i;
+    }
+    pipeline.free_input.count = pipeline.free_output.count = PIPELINE_DEPTH;
+
+    if (success && mtx_init(&pipeline.lock, mtx_plain) == thrd_success)
+    {
+        if (cnd_init(&pipeline.changed) == thrd_success)
+        {
+            success = run_pipeline(&pipeline, from, to);
+            cnd_destroy(&pipeline.changed);
+        }
+        else
+        {
+            success = false;
+        }
+        mtx_destroy(&pipeline.lock);
+    }
+    else
+    {
+        success = false;
+    }
+
+    for (size_t i = 0; i < PIPELINE_DEPTH; ++i)
+    {
+        free(input_blocks[i].data);
+        free(output_blocks[i].data);
+    }
+    fclose(p_in);
+    if (fclose(p_out) != 0)
+        success = false;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""Generate the Unicode property tables in src/cutf_tables.c and src/cutf_tables.h.
+
+The properties are taken from the `regex` package, so the tables follow the Unicode version it was built with. Simple
+case folding, which `regex` does not expose, is taken from ICU's u_foldCase. Each property is stored as a two-stage
+table: the first stage maps each block of codepoints to one of the distinct blocks of values in the second stage.
+
+Usage: gen_unicode_tables.py [OUTPUT_DIRECTORY]
+"""
+
+import ctypes
+import ctypes.util
+import functools
+import os
+import sys
+
+import regex
+
+UNICODE_VERSION = "17.0"
+CODEPOINTS = 0x110000
+BLOCK_SHIFT = 7
+
+# Grapheme_Cluster_Break values, in the order of the grapheme_class_t enumeration
+GRAPHEME_CLASSES = [
+    ("OTHER", None),
+    ("CR", "CR"),
+    ("LF", "LF"),
+    ("CONTROL", "Control"),
+    ("EXTEND", "Extend"),
+    ("ZWJ", "ZWJ"),
+    ("REGIONAL_INDICATOR", "Regional_Indicator"),
+    ("PREPEND", "Prepend"),
+    ("SPACING_MARK", "SpacingMark"),
+    ("L", "L"),
+    ("V", "V"),
+    ("T", "T"),
+    ("LV", "LV"),
+    ("LVT", "LVT"),
+]
+
+# Indic_Conjunct_Break values, in the order of the grapheme_conjunct_t enumeration
+GRAPHEME_CONJUNCT = [
+    ("NONE", None),
+    ("CONSONANT", "Consonant"),
+    ("EXTEND", "Extend"),
+    ("LINKER", "Linker"),
+]
+
+GRAPHEME_PICTOGRAPHIC = 0x10
+GRAPHEME_CONJUNCT_SHIFT = 5
+
+ALL_CODEPOINTS = "".join(map(chr, range(CODEPOINTS)))
+
+
+def codepoints_with(prop):
+    """Yield all codepoints which have the given property, written as in a regular expression."""
+    for match in regex.finditer(r"\p{%s}+" % prop, ALL_CODEPOINTS):
+        yield from range(match.start(), match.end())
+
+
+def grapheme_properties():
+    values = bytearray(CODEPOINTS)
+    for index, (_, name) in enumerate(GRAPHEME_CLASSES):
+        if name is not None:
+            for c in codepoints_with("Grapheme_Cluster_Break=" + name):
+                values[c] |= index
+    for c in codepoints_with("Extended_Pictographic"):
+        values[c] |= GRAPHEME_PICTOGRAPHIC
+    for index, (_, name) in enumerate(GRAPHEME_CONJUNCT):
+        if name is not None:
+            for c in codepoints_with("InCB=" + name):
+                values[c] |= index << GRAPHEME_CONJUNCT_SHIFT
+    return values
+
+
+def grapheme_declarations():
+    lines = ["typedef enum", "{"]
+    lines += ["    GRAPHEME_%s," % name for name, _ in GRAPHEME_CLASSES]
+    lines += ["    GRAPHEME_CLASS_COUNT,", "    GRAPHEME_CLASS_MASK = 0x0F,"]
+    lines += ["    GRAPHEME_PICTOGRAPHIC = 0x%02X, // Extended_Pictographic" % GRAPHEME_PICTOGRAPHIC]
+    lines += ["} grapheme_class_t;", "", "typedef enum", "{"]
+    lines += ["    GRAPHEME_CONJUNCT_%s," % name for name, _ in GRAPHEME_CONJUNCT]
+    lines += ["    GRAPHEME_CONJUNCT_SHIFT = %d," % GRAPHEME_CONJUNCT_SHIFT, "} grapheme_conjunct_t;"]
+    return lines
+
+
+def width_properties():
+    """Columns taken in a terminal: zero for marks, format and control characters and conjoining Hangul vowels and
+    trailing consonants, two for wide and fullwidth characters and emoji, and one for everything else."""
+    values = bytearray([1]) * CODEPOINTS
+    for prop in ("East_Asian_Width=Wide", "East_Asian_Width=Fullwidth", "Emoji_Presentation"):
+        for c in codepoints_with(prop):
+            values[c] = 2
+    for prop in ("Mn", "Me", "Mc", "Cf", "Cc", "Grapheme_Cluster_Break=V", "Grapheme_Cluster_Break=T"):
+        for c in codepoints_with(prop):
+            values[c] = 0
+    # Soft hyphens are shown where they break a line, so terminals give them a column like glibc does
+    values[0xAD] = 1
+    return values
+
+
+def width_declarations():
+    return []
+
+
+def identifier_properties():
+    values = bytearray(CODEPOINTS)
+    for c in codepoints_with("XID_Start"):
+        values[c] |= 1
+    for c in codepoints_with("XID_Continue"):
+        values[c] |= 2
+    return values
+
+
+def identifier_declarations():
+    return ["typedef enum", "{", "    IDENTIFIER_START = 1,", "    IDENTIFIER_CONTINUE = 2,", "} identifier_class_t;"]
+
+
+@functools.cache
+def simple_case_folding():
+    """Map codepoints which change when case folded to their simple case folding."""
+    library = ctypes.util.find_library("icuuc")
+    icu = ctypes.CDLL(library)
+    suffix = "_" + library.split(".so.")[1].split(".")[0] if ".so." in library else ""
+    fold_case = getattr(icu, "u_foldCase" + suffix)
+    fold_case.argtypes = [ctypes.c_int32, ctypes.c_uint32]
+    fold_case.restype = ctypes.c_int32
+    char_type = getattr(icu, "u_charType" + suffix)
+    char_type.argtypes = [ctypes.c_int32]
+    char_type.restype = ctypes.c_int8
+
+    folding = {}
+    changing = set(codepoints_with("Changes_When_Casefolded"))
+    for c in codepoints_with("Assigned"):
+        if char_type(c) != 0:
+            if fold_case(c, 0) != c:
+                folding[c] = fold_case(c, 0)
+        elif c in changing:
+            # Characters newer than ICU's data fold to the only one of their case-insensitive matches which does not
+            # change when case folded
+            stable = [m.start() for m in regex.finditer(r"(?i)" + regex.escape(chr(c)), ALL_CODEPOINTS)
+                      if m.start() not in changing]
+            if len(stable) == 1:
+                folding[c] = stable[0]
+    return folding
+
+
+def casefold_deltas():
+    return [0] + sorted(set(f - c for c, f in simple_case_folding().items()))
+
+
+def casefold_properties():
+    deltas = casefold_deltas()
+    values = bytearray(CODEPOINTS)
+    for c, f in simple_case_folding().items():
+        values[c] = deltas.index(f - c)
+    return values
+
+
+def casefold_declarations():
+    return ["extern const int32_t cutf_casefold_deltas[%d];" % len(casefold_deltas())]
+
+
+def casefold_definitions():
+    deltas = casefold_deltas()
+    lines = ["", "const int32_t cutf_casefold_deltas[%d] = {" % len(deltas)]
+    lines += format_array(deltas, 12)
+    return lines + ["};"]
+
+
+def no_definitions():
+    return []
+
+
+# Name, description, generator of the values, and additional declarations and definitions for each table
+TABLES = [
+    ("grapheme", "Grapheme_Cluster_Break, Extended_Pictographic and Indic_Conjunct_Break", grapheme_properties,
+     grapheme_declarations, no_definitions),
+    ("width", "Display width in columns", width_properties, width_declarations, no_definitions),
+    ("identifier", "XID_Start and XID_Continue", identifier_properties, identifier_declarations, no_definitions),
+    ("casefold", "Simple case folding, as the index of the difference to the folded codepoint in cutf_casefold_deltas",
+     casefold_properties, casefold_declarations, casefold_definitions),
+]
+
+
+def split_stages(values):
+    """Split the values into the two stages, sharing blocks of values which are the same."""
+    block_size = 1 << BLOCK_SHIFT
+    blocks = {}
+    stage1 = []
+    stage2 = bytearray()
+    for start in range(0, CODEPOINTS, block_size):
+        block = bytes(values[start:start + block_size])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2 += block
+        stage1.append(blocks[block])
+    return stage1, stage2
+
+
+def format_array(values, per_line):
+    for start in range(0, len(values), per_line):
+        yield "    " + " ".join("%d," % v for v in values[start:start + per_line])
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "..", "src")
+    notice = "// Generated by tools/gen_unicode_tables.py from Unicode %s, do not edit." % UNICODE_VERSION
+
+    header = [notice, "#pragma once", "", "#include <stddef.h>", "#include <stdint.h>", "#include <uchar.h>", "",
+              "enum", "{", "    CUTF_TABLE_SHIFT = %d," % BLOCK_SHIFT,
+              "    CUTF_TABLE_MASK = (1 << CUTF_TABLE_SHIFT) - 1,", "};"]
+    source = [notice, '#include "cutf_tables.h"']
+    for name, description, generate, declarations, definitions in TABLES:
+        stage1, stage2 = split_stages(generate())
+        index_type = "uint8_t" if len(stage2) >> BLOCK_SHIFT <= 0x100 else "uint16_t"
+        header += ["", "// " + description]
+        header += declarations()
+        header += ["",
+                   "extern const %s cutf_%s_stage1[%d];" % (index_type, name, len(stage1)),
+                   "extern const uint8_t cutf_%s_stage2[%d];" % (name, len(stage2)),
+                   "",
+                   "static inline uint8_t cutf_%s_lookup(const char32_t c)" % name,
+                   "{",
+                   "    return cutf_%s_stage2[(size_t)cutf_%s_stage1[c >> CUTF_TABLE_SHIFT] << CUTF_TABLE_SHIFT |"
+                   % (name, name),
+                   " " * len("    return cutf_%s_stage2[" % name) + "(c & CUTF_TABLE_MASK)];",
+                   "}"]
+        source += ["", "const %s cutf_%s_stage1[%d] = {" % (index_type, name, len(stage1))]
+        source += format_array(stage1, 24)
+        source += ["};", "", "const uint8_t cutf_%s_stage2[%d] = {" % (name, len(stage2))]
+        source += format_array(stage2, 24)
+        source += ["};"]
+        source += definitions()
+
+    with open(os.path.join(output, "cutf_tables.h"), "w") as f:
+        f.write("\n".join(header) + "\n")
+    with open(os.path.join(output, "cutf_tables.c"), "w") as f:
+        f.write("\n".join(source) + "\n")
+
+
+if __name__ == "__main__":
+    main()